@@ -31,6 +31,7 @@ struct ArgumentsType
    bool version;
    bool help;
    bool verbose;
+   bool layerDiagnostics;
 
    // Configuration
    std::string outputDir;
@@ -52,6 +53,7 @@ struct ArgumentsType
    float              gammaValue;
    float              curveOffset;
    bool               notFadeBorders;
+   std::string        platesCache;
    bool               scatterPlot;
    bool               satelliteMap;
    bool               icecapsMap;
@@ -18,6 +18,7 @@
 #include <worldengine/export.h>
 #include <worldengine/generation.h>
 #include <worldengine/plates.h>
+#include <worldengine/plates_cache.h>
 #include <worldengine/world.h>
 
 #include <worldengine/images/ancient_map_image.h>
@@ -85,7 +86,8 @@ GenerateWorld(const std::string&        worldName,
               bool                      icecapsMap    = DEFAULT_ICECAPS_MAP,
               bool                      worldMap      = DEFAULT_WORLD_MAP,
               bool                      elevationMap  = DEFAULT_ELEVATION_MAP,
-              bool elevationShadows = DEFAULT_ELEVATION_SHADOWS);
+              bool elevationShadows = DEFAULT_ELEVATION_SHADOWS,
+              const std::string& platesCacheDir = "");
 
 static std::shared_ptr<World> LoadWorld(const std::string& filename,
                                         WorldFormat        format);
@@ -126,7 +128,11 @@ static int AddOptions(int                      argc,
       //
       ("verbose,v",
        po::bool_switch(&args.verbose)->default_value(false),
-       "Enable verbose messages");
+       "Enable verbose messages")
+      //
+      ("layer-diagnostics",
+       po::bool_switch(&args.layerDiagnostics)->default_value(false),
+       "Log the contents of the plates simulation layers, with --verbose");
 
    po::options_description configuration("Configuration");
    configuration.add_options() //
@@ -249,6 +255,11 @@ static int AddOptions(int                      argc,
        po::bool_switch(&args.notFadeBorders)->default_value(false),
        "Don't fade borders")
       //
+      ("plates-cache",
+       po::value<std::string>(&args.platesCache)->value_name("dir"),
+       "Directory caching plates simulation results, reused by worlds "
+       "sharing a seed, size and number of plates")
+      //
       ("scatter",
        po::bool_switch(&args.scatterPlot)->default_value(false),
        "Generate scatter plot")
@@ -470,8 +481,15 @@ static std::shared_ptr<World> GenerateWorld(const std::string& worldName,
                                             bool        icecapsMap,
                                             bool        worldMap,
                                             bool        elevationMap,
-                                            bool        elevationShadows)
+                                            bool        elevationShadows,
+                                            const std::string& platesCacheDir)
 {
+   std::unique_ptr<PlatesCache> platesCache;
+   if (!platesCacheDir.empty())
+   {
+      platesCache = std::make_unique<PlatesCache>(platesCacheDir);
+   }
+
    std::shared_ptr<World> world = WorldGen(worldName,
                                            width,
                                            height,
@@ -483,7 +501,9 @@ static std::shared_ptr<World> GenerateWorld(const std::string& worldName,
                                            numPlates,
                                            oceanLevel,
                                            step,
-                                           fadeBorders);
+                                           fadeBorders,
+                                           nullptr,
+                                           platesCache.get());
 
    BOOST_LOG_TRIVIAL(info) << "Producing output";
 
@@ -797,6 +817,8 @@ static void SetLogLevel(const ArgumentsType& args)
 
    boost::log::core::get()->set_filter(boost::log::trivial::severity >=
                                        severity);
+
+   SetLayerDiagnostics(args.layerDiagnostics);
 }
 
 static void TransformArguments(ArgumentsType& args)
@@ -922,7 +944,8 @@ void CliMain(int argc, const char** argv)
                             args.icecapsMap,
                             args.worldMap,
                             args.elevationMap,
-                            args.elevationShadows);
+                            args.elevationShadows,
+                            args.platesCache);
    }
    else if (args.operation == OperationType::Plates)
    {
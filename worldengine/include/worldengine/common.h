@@ -112,6 +112,12 @@ typedef Iterator<ElevationThreshold,
                  ElevationThreshold::Mountain>
    ElevationIterator;
 
+enum class ErosionMode
+{
+   Search,
+   PriorityFlood
+};
+
 enum class ExportDataType
 {
    Int16,
@@ -123,6 +129,18 @@ enum class ExportDataType
    Float64
 };
 
+/**
+ * @brief Evaluation of the gamma curve applied to precipitation. Exact uses
+ * std::pow, compatible with earlier versions. Approximate uses a polynomial
+ * approximation with a relative error below 1e-5, allowing the curve to be
+ * vectorized.
+ */
+enum class GammaMode
+{
+   Exact,
+   Approximate
+};
+
 enum class HumidityLevel
 {
    Superarid,
@@ -133,6 +151,7 @@ enum class HumidityLevel
    Humid,
    Perhumid,
    Superhumid,
+   Count,
    Last = Superhumid
 };
 typedef Iterator<HumidityLevel,
@@ -140,6 +159,38 @@ typedef Iterator<HumidityLevel,
                  HumidityLevel::Superhumid>
    HumidityIterator;
 
+enum class Layer
+{
+   Elevation,
+   Plates,
+   Ocean,
+   SeaDepth,
+   Temperature,
+   Precipitation,
+   RiverMap,
+   LakeMap,
+   WaterMap,
+   Irrigation,
+   Humidity,
+   Permeability,
+   Biome,
+   Icecap,
+   Count
+};
+typedef Iterator<Layer, Layer::Elevation, Layer::Icecap> LayerIterator;
+
+/**
+ * @brief World parameters which may be changed after generation, and the
+ * affected layers regenerated
+ */
+enum class Parameter
+{
+   Temps,
+   Humids,
+   GammaCurve,
+   CurveOffset
+};
+
 enum class PermeabilityLevel
 {
    Low,
@@ -151,6 +202,16 @@ typedef Iterator<PermeabilityLevel,
                  PermeabilityLevel::High>
    PermeabilityIterator;
 
+/**
+ * @brief Outcome of a plates simulation
+ */
+enum class PlatesStatus
+{
+   Finished,  /**< The simulation converged */
+   Truncated, /**< The budget was exhausted, and the current state is used */
+   Cancelled  /**< The callback cancelled the simulation */
+};
+
 enum class PrecipitationLevel
 {
    Low,
@@ -162,6 +223,18 @@ typedef Iterator<PrecipitationLevel,
                  PrecipitationLevel::High>
    PrecipitationIterator;
 
+/**
+ * @brief Source of random numbers for stochastic simulation stages. Sequential
+ * draws from sequential generators, compatible with earlier versions.
+ * CounterBased keys each value by seed, stage and cell, allowing stages to run
+ * in parallel with the same results for any number of threads.
+ */
+enum class RandomMode
+{
+   Sequential,
+   CounterBased
+};
+
 enum class SeaColor
 {
    Blue,
@@ -216,6 +289,13 @@ typedef Iterator<WaterThreshold,
                  WaterThreshold::MainRiver>
    WaterIterator;
 
+enum class WatermapMode
+{
+   Droplets,
+   Accumulation,
+   AccumulationD8
+};
+
 enum class WorldFormat
 {
    Protobuf,
@@ -224,11 +304,15 @@ enum class WorldFormat
 
 struct Step
 {
-   StepType stepType_;
-   bool     includePlates_;
-   bool     includePrecipitations_;
-   bool     includeErosion_;
-   bool     includeBiome_;
+   StepType     stepType_;
+   bool         includePlates_;
+   bool         includePrecipitations_;
+   bool         includeErosion_;
+   bool         includeBiome_;
+   ErosionMode  erosionMode_;  /**< River routing used by erosion */
+   WatermapMode watermapMode_; /**< Rainfall routing used by the watermap */
+   RandomMode   randomMode_;   /**< Random numbers used by stochastic stages */
+   GammaMode    gammaMode_;    /**< Gamma curve used by precipitation */
 
    Step(StepType stepType,
         bool     includePlates,
@@ -239,7 +323,11 @@ struct Step
        includePlates_(includePlates),
        includePrecipitations_(includePrecipitations),
        includeErosion_(includeErosion),
-       includeBiome_(includeBiome)
+       includeBiome_(includeBiome),
+       erosionMode_(ErosionMode::Search),
+       watermapMode_(WatermapMode::Droplets),
+       randomMode_(RandomMode::Sequential),
+       gammaMode_(GammaMode::Exact)
    {
    }
 
@@ -384,6 +472,14 @@ SeaColor      SeaColorFromString(const std::string& value);
 std::ostream& operator<<(std::ostream& os, const SeaColor& color);
 std::istream& operator>>(std::istream& in, SeaColor& color);
 
+/**
+ * @brief Convert from a simulation enumeration to a string value
+ * @param simulation Simulation enumeration
+ * @return String value
+ */
+std::string   SimulationToString(Simulation simulation);
+std::ostream& operator<<(std::ostream& os, const Simulation& simulation);
+
 /**
  * @brief Convert from a step type enumeration to a string value
  * @param step Step type enumeration
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "worldengine/common.h"
+#include "worldengine/scratch_arena.h"
 #include "worldengine/world.h"
 
 #include <memory>
@@ -28,16 +29,27 @@ void CenterLand(World& world);
  * @param world A world having elevation, oceans and thresholds
  * @param step Generation steps to perform
  * @param seed Random seed value
+ * @param scratch Arena for temporary layers, which are released when
+ * generation completes or throws. Reusing an arena across a batch of worlds
+ * avoids reallocating them. If nullptr, temporary layers are allocated for
+ * this call only.
  */
-void GenerateWorld(World& world, const Step& step, uint32_t seed);
+void GenerateWorld(World&        world,
+                   const Step&   step,
+                   uint32_t      seed,
+                   ScratchArena* scratch = nullptr);
 
 /**
  * @brief Calculate the ocean, the sea depth and the elevation thresholds
  * @param world A world having elevation but not thresholds
  * @param oceanLevel The elevation representing the ocean level
+ * @param scratch Arena for temporary layers, or nullptr to allocate them for
+ * this call only
  */
-void InitializeOceanAndThresholds(World& world,
-                                  float  oceanLevel = DEFAULT_OCEAN_LEVEL);
+void InitializeOceanAndThresholds(
+   World&        world,
+   float         oceanLevel = DEFAULT_OCEAN_LEVEL,
+   ScratchArena* scratch    = nullptr);
 
 /**
  * @brief Lower the elevation near the border of the map
@@ -45,11 +57,31 @@ void InitializeOceanAndThresholds(World& world,
  */
 void PlaceOceansAtMapBorders(World& world);
 
+/**
+ * @brief Repeat only the simulations invalidated since the world was
+ * generated. A simulation is repeated if it consumes a changed parameter, or a
+ * layer whose version differs from the version it consumed. Temperature and
+ * humidity thresholds are recalculated without repeating their simulations.
+ *
+ * Layers edited outside of generation are signalled with
+ * World::MarkLayerEdited(). Generation records are not serialized, so a loaded
+ * world has no simulations to repeat.
+ * @param world A world generated by GenerateWorld()
+ * @param changedParameters Parameters changed since the world was generated
+ * @param scratch Arena for temporary layers, or nullptr to allocate them for
+ * this call only
+ */
+void Regenerate(World&                        world,
+                const std::vector<Parameter>& changedParameters,
+                ScratchArena*                 scratch = nullptr);
+
 /**
  * @brief Calculate the sea depth
  * @param world A world having elevation and oceans
  * @param seaLevel The elevation representing the ocean level
+ * @param scratch Arena for temporary layers, or nullptr to allocate them for
+ * this call only
 */
-void SeaDepth(World& world, float seaLevel);
+void SeaDepth(World& world, float seaLevel, ScratchArena* scratch = nullptr);
 
 } // namespace WorldEngine
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "image.h"
+#include "worldengine/scratch_arena.h"
 
 namespace WorldEngine
 {
@@ -10,14 +11,20 @@ namespace WorldEngine
 class AncientMapImage : public Image
 {
 public:
-   explicit AncientMapImage(const World& world,
-                            uint32_t     seed,
-                            uint32_t     scale               = 1u,
-                            SeaColor     seaColor            = SeaColor::Brown,
-                            bool         drawBiome           = true,
-                            bool         drawRivers          = true,
-                            bool         drawMountains       = true,
-                            bool         drawOuterLandBorder = false);
+   /**
+    * @brief Create an ancient map image
+    * @param scratch Arena for temporary tables used while drawing, or nullptr
+    * to allocate them for each image only
+    */
+   explicit AncientMapImage(const World&  world,
+                            uint32_t      seed,
+                            uint32_t      scale               = 1u,
+                            SeaColor      seaColor            = SeaColor::Brown,
+                            bool          drawBiome           = true,
+                            bool          drawRivers          = true,
+                            bool          drawMountains       = true,
+                            bool          drawOuterLandBorder = false,
+                            ScratchArena* scratch             = nullptr);
    ~AncientMapImage();
 
 protected:
@@ -28,12 +35,13 @@ protected:
    void DrawImage(boost::gil::rgb8_image_t::view_t& target) override;
 
 private:
-   uint32_t seed_;
-   SeaColor seaColor_;
-   bool     drawBiome_;
-   bool     drawRivers_;
-   bool     drawMountains_;
-   bool     drawOuterLandBorder_;
+   uint32_t      seed_;
+   SeaColor      seaColor_;
+   bool          drawBiome_;
+   bool          drawRivers_;
+   bool          drawMountains_;
+   bool          drawOuterLandBorder_;
+   ScratchArena* scratch_;
 };
 
 boost::gil::rgb8_pixel_t Gradient(float                    value,
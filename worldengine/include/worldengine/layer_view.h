@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace WorldEngine
+{
+
+/**
+ * @brief Non-owning view of a two-dimensional layer, stored as rows of
+ * contiguous cells. Rows are accessed through raw pointers, so indexing a cell
+ * is a single multiply-add, and loops over a row can be vectorized.
+ *
+ * A view remains valid until the layer it refers to is resized or destroyed.
+ *
+ * @tparam T Cell type, const qualified for a read-only view
+ */
+template<typename T>
+class LayerView
+{
+public:
+   LayerView() : LayerView(nullptr, 0u, 0u, 0u) {}
+
+   /**
+    * @brief Create a view of existing storage
+    * @param data First cell of the first row
+    * @param width Number of cells in each row
+    * @param height Number of rows
+    * @param stride Distance between the first cells of consecutive rows, in
+    * cells
+    */
+   LayerView(T* data, uint32_t width, uint32_t height, size_t stride) :
+       data_(data), width_(width), height_(height), stride_(stride)
+   {
+   }
+
+   /**
+    * @brief Create a read-only view from a mutable view
+    */
+   template<typename U,
+            typename = std::enable_if_t<std::is_same_v<const U, T> &&
+                                        !std::is_same_v<U, T>>>
+   LayerView(const LayerView<U>& other) :
+       LayerView(other.data(), other.width(), other.height(), other.stride())
+   {
+   }
+
+   T*       data() const { return data_; }
+   uint32_t width() const { return width_; }
+   uint32_t height() const { return height_; }
+   size_t   stride() const { return stride_; }
+
+   /**
+    * @brief Number of cells in the layer
+    */
+   size_t size() const { return static_cast<size_t>(width_) * height_; }
+
+   /**
+    * @brief Determine whether the rows are stored without padding, allowing
+    * the layer to be traversed as a single array of size() cells. Views of
+    * World layers are always contiguous.
+    */
+   bool contiguous() const { return stride_ == width_; }
+
+   /**
+    * @brief Pointer to the first cell of a row, allowing cells to be accessed
+    * as view[y][x]
+    */
+   T* operator[](uint32_t y) const { return data_ + y * stride_; }
+
+   T& operator()(uint32_t x, uint32_t y) const
+   {
+      return data_[y * stride_ + x];
+   }
+
+private:
+   T*       data_;
+   uint32_t width_;
+   uint32_t height_;
+   size_t   stride_;
+};
+
+} // namespace WorldEngine
@@ -1,9 +1,13 @@
 #pragma once
 
 #include "common.h"
+#include "plates_cache.h"
+#include "scratch_arena.h"
 #include "world.h"
 
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -11,6 +15,47 @@
 namespace WorldEngine
 {
 
+/**
+ * @brief Progress of a plates simulation, reported after each step
+ */
+struct PlatesProgress
+{
+   uint32_t                  step_;        /**< Number of steps performed */
+   std::chrono::milliseconds elapsedTime_; /**< Time since the first step */
+};
+
+/**
+ * @brief Limits on a plates simulation, and a callback reporting its progress.
+ * The default budget runs the simulation until it converges.
+ */
+struct PlatesBudget
+{
+   /**
+    * @brief Maximum number of steps, or 0 for no limit
+    */
+   uint32_t maxSteps_ = 0u;
+
+   /**
+    * @brief Maximum time spent stepping, or 0 for no limit. The limit is
+    * checked between steps, so a step in progress is completed.
+    */
+   std::chrono::milliseconds maxTime_ = std::chrono::milliseconds(0);
+
+   /**
+    * @brief Called after each step. Returning false cancels the simulation.
+    */
+   std::function<bool(const PlatesProgress&)> callback_;
+};
+
+/**
+ * @brief Step a plates simulation until it converges, exhausts its budget, or
+ * is cancelled
+ * @param p Handle to a Plate Tectonics library object
+ * @param budget Limits on the simulation
+ * @return Outcome of the simulation
+ */
+PlatesStatus StepPlatesSimulation(void* p, const PlatesBudget& budget);
+
 /**
  * @brief Perform an initial plates simulation using the Plate Tectonics library
  * @param heightmap Elevation map
@@ -25,21 +70,26 @@ namespace WorldEngine
  * @param aggrOverlapRel
  * @param cycleCount
  * @param numPlates Number of plates
+ * @param budget Limits on the simulation
+ * @param status Receives the outcome of the simulation, if not nullptr. The
+ * maps are valid unless the simulation was cancelled.
  * @return Handle to a Plate Tectonics library object
  */
 void* GeneratePlatesSimulation(
-   float**    heightmap,
-   uint32_t** platesmap,
-   long       seed,
-   uint32_t   width,
-   uint32_t   height,
-   float      seaLevel       = DEFAULT_SEA_LEVEL,
-   uint32_t   erosionPeriod  = DEFAULT_EROSION_PERIOD,
-   float      foldingRatio   = DEFAULT_FOLDING_RATIO,
-   uint32_t   aggrOverlapAbs = DEFAULT_AGGR_OVERLAP_ABS,
-   float      aggrOverlapRel = DEFAULT_AGGR_OVERLAP_REL,
-   uint32_t   cycleCount     = DEFAULT_CYCLE_COUNT,
-   uint32_t   numPlates      = DEFAULT_NUM_PLATES);
+   float**             heightmap,
+   uint32_t**          platesmap,
+   long                seed,
+   uint32_t            width,
+   uint32_t            height,
+   float               seaLevel       = DEFAULT_SEA_LEVEL,
+   uint32_t            erosionPeriod  = DEFAULT_EROSION_PERIOD,
+   float               foldingRatio   = DEFAULT_FOLDING_RATIO,
+   uint32_t            aggrOverlapAbs = DEFAULT_AGGR_OVERLAP_ABS,
+   float               aggrOverlapRel = DEFAULT_AGGR_OVERLAP_REL,
+   uint32_t            cycleCount     = DEFAULT_CYCLE_COUNT,
+   uint32_t            numPlates      = DEFAULT_NUM_PLATES,
+   const PlatesBudget& budget         = PlatesBudget(),
+   PlatesStatus*       status         = nullptr);
 
 /**
  * @brief Destroy a Plate Tectonics library object
@@ -63,20 +113,31 @@ void PlatecApiDestroy(void* p);
  * @param oceanLevel The elevation representing the ocean level
  * @param step Generation steps to perform
  * @param fadeBorders Place oceans at map borders
- * @return A new world
+ * @param scratch Arena for temporary layers, which may be reused across a batch
+ * of worlds, or nullptr to allocate them for each world
+ * @param platesCache Cache of plates simulation results, allowing worlds which
+ * share a seed, size and number of plates to skip the plates simulation, or
+ * nullptr to always run the plates simulation
+ * @param platesBudget Limits on the plates simulation, bounding the time taken
+ * to create a world. Results truncated by the budget are not cached, and are
+ * reported by GenerationRecord::platesStatus_ of the world.
+ * @return A new world, or nullptr if the plates simulation was cancelled
  */
 std::shared_ptr<World>
 WorldGen(const std::string&        name,
          uint32_t                  width,
          uint32_t                  height,
          uint32_t                  seed,
-         const std::vector<float>& temps       = DEFAULT_TEMPS,
-         const std::vector<float>& humids      = DEFAULT_HUMIDS,
-         float                     gammaCurve  = DEFAULT_GAMMA_CURVE,
-         float                     curveOffset = DEFAULT_CURVE_OFFSET,
-         uint32_t                  numPlates   = DEFAULT_NUM_PLATES,
-         float                     oceanLevel  = DEFAULT_OCEAN_LEVEL,
-         const Step&               step        = DEFAULT_STEP,
-         bool                      fadeBorders = DEFAULT_FADE_BORDERS);
+         const std::vector<float>& temps        = DEFAULT_TEMPS,
+         const std::vector<float>& humids       = DEFAULT_HUMIDS,
+         float                     gammaCurve   = DEFAULT_GAMMA_CURVE,
+         float                     curveOffset  = DEFAULT_CURVE_OFFSET,
+         uint32_t                  numPlates    = DEFAULT_NUM_PLATES,
+         float                     oceanLevel   = DEFAULT_OCEAN_LEVEL,
+         const Step&               step         = DEFAULT_STEP,
+         bool                      fadeBorders  = DEFAULT_FADE_BORDERS,
+         ScratchArena*             scratch      = nullptr,
+         PlatesCache*              platesCache  = nullptr,
+         const PlatesBudget&       platesBudget = PlatesBudget());
 
 } // namespace WorldEngine
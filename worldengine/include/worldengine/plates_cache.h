@@ -0,0 +1,101 @@
+#pragma once
+
+#include "common.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace WorldEngine
+{
+
+/**
+ * @brief Parameters of a plates simulation. The result of a plates simulation
+ * is fully determined by its parameters.
+ */
+struct PlatesParameters
+{
+   int64_t  seed_           = 0;
+   uint32_t width_          = 0u;
+   uint32_t height_         = 0u;
+   float    seaLevel_       = DEFAULT_SEA_LEVEL;
+   uint32_t erosionPeriod_  = DEFAULT_EROSION_PERIOD;
+   float    foldingRatio_   = DEFAULT_FOLDING_RATIO;
+   uint32_t aggrOverlapAbs_ = DEFAULT_AGGR_OVERLAP_ABS;
+   float    aggrOverlapRel_ = DEFAULT_AGGR_OVERLAP_REL;
+   uint32_t cycleCount_     = DEFAULT_CYCLE_COUNT;
+   uint32_t numPlates_      = DEFAULT_NUM_PLATES;
+
+   bool operator==(const PlatesParameters& other) const;
+};
+
+/**
+ * @brief On-disk cache of plates simulation results. Each result is stored in
+ * its own file, named by a hash of its parameters, so worlds sharing a plates
+ * seed can skip the plates simulation.
+ *
+ * Files store their parameters, and a file whose parameters do not match is
+ * treated as a miss. Results are written to a temporary file and renamed into
+ * place, allowing processes to share a cache directory. The cache is never
+ * pruned.
+ */
+class PlatesCache
+{
+public:
+   /**
+    * @brief Create a cache
+    * @param directory Directory holding the cache files, created when the
+    * first result is stored
+    */
+   explicit PlatesCache(const std::string& directory);
+   ~PlatesCache();
+
+   /**
+    * @brief Load a plates simulation result
+    * @param parameters Parameters of the plates simulation
+    * @param heightmap Receives the elevation map, in row-major order
+    * @param platesmap Receives the plates map, in row-major order
+    * @return true if the result was found in the cache
+    */
+   bool Load(const PlatesParameters& parameters,
+             std::vector<float>&     heightmap,
+             std::vector<uint32_t>&  platesmap) const;
+
+   /**
+    * @brief Load a plates simulation result into existing buffers, allowing it
+    * to be read directly into the storage of a world
+    * @param parameters Parameters of the plates simulation
+    * @param heightmap Receives the elevation map, width * height cells in
+    * row-major order
+    * @param platesmap Receives the plates map, width * height cells in
+    * row-major order
+    * @return true if the result was found in the cache. If false, the contents
+    * of the buffers are unspecified.
+    */
+   bool Load(const PlatesParameters& parameters,
+             float*                  heightmap,
+             uint32_t*               platesmap) const;
+
+   /**
+    * @brief Store a plates simulation result
+    * @param parameters Parameters of the plates simulation
+    * @param heightmap Elevation map of width * height cells, in row-major order
+    * @param platesmap Plates map of width * height cells, in row-major order
+    * @return true if the result was written to the cache
+    */
+   bool Store(const PlatesParameters& parameters,
+              const float*            heightmap,
+              const uint32_t*         platesmap) const;
+
+   /**
+    * @brief Path of the file storing the result for a set of parameters
+    */
+   std::string Filename(const PlatesParameters& parameters) const;
+
+   const std::string& directory() const;
+
+private:
+   std::string directory_;
+};
+
+} // namespace WorldEngine
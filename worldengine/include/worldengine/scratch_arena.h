@@ -0,0 +1,177 @@
+#pragma once
+
+#include "layer_view.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace WorldEngine
+{
+
+/**
+ * @brief Alignment of layers allocated from a scratch arena
+ */
+const size_t SCRATCH_ALIGNMENT = 64u;
+
+/**
+ * @brief Default size of the first block allocated by a scratch arena
+ */
+const size_t DEFAULT_SCRATCH_BLOCK_SIZE = 4u * 1024u * 1024u;
+
+/**
+ * @brief Bump allocator for temporary layers used during world generation.
+ *
+ * Allocations are not freed individually, and remain valid until Reset() is
+ * called, or until the ScratchScope they were made in is left. Memory is
+ * retained across Reset(), so an arena reused for a batch of worlds stops
+ * allocating once it has grown to fit the largest world. Storage is not
+ * initialized, and is only suitable for trivial types.
+ *
+ * Allocation is thread safe, allowing concurrent simulation stages to share an
+ * arena. Worlds generated concurrently must each use their own arena.
+ */
+class ScratchArena
+{
+public:
+   /**
+    * @brief Position in the arena, marking the allocations made before it
+    */
+   struct Mark
+   {
+      size_t blocks_; /**< Number of blocks */
+      size_t offset_; /**< Offset into the last block */
+   };
+
+   /**
+    * @brief Create an empty arena. No memory is allocated until the first
+    * allocation.
+    * @param blockSize Minimum size of each block, in bytes
+    */
+   explicit ScratchArena(size_t blockSize = DEFAULT_SCRATCH_BLOCK_SIZE);
+   ~ScratchArena();
+
+   ScratchArena(const ScratchArena&)            = delete;
+   ScratchArena& operator=(const ScratchArena&) = delete;
+
+   /**
+    * @brief Allocate uninitialized memory
+    * @param size Size in bytes
+    * @param alignment Alignment in bytes, a power of two no greater than
+    * SCRATCH_ALIGNMENT
+    * @return Pointer to the allocated memory
+    */
+   void* Allocate(size_t size, size_t alignment = SCRATCH_ALIGNMENT);
+
+   /**
+    * @brief Allocate an uninitialized, contiguous layer
+    * @tparam T Cell type
+    * @param width Number of cells in each row
+    * @param height Number of rows
+    */
+   template<typename T>
+   LayerView<T> AllocateLayer(uint32_t width, uint32_t height)
+   {
+      static_assert(std::is_trivially_copyable_v<T> &&
+                       std::is_trivially_destructible_v<T>,
+                    "Scratch layers must have a trivial type");
+
+      size_t numCells = static_cast<size_t>(width) * height;
+      T*     data     = static_cast<T*>(Allocate(numCells * sizeof(T)));
+      return LayerView<T>(data, width, height, width);
+   }
+
+   /**
+    * @brief Allocate a contiguous layer with every cell set to a value
+    * @tparam T Cell type
+    * @param width Number of cells in each row
+    * @param height Number of rows
+    * @param value Initial value of each cell
+    */
+   template<typename T>
+   LayerView<T> AllocateLayer(uint32_t width, uint32_t height, const T& value)
+   {
+      LayerView<T> layer = AllocateLayer<T>(width, height);
+      std::fill(layer.data(), layer.data() + layer.size(), value);
+      return layer;
+   }
+
+   /**
+    * @brief Release every allocation, retaining the memory for reuse. If the
+    * arena grew to more than one block, the blocks are replaced by a single
+    * block of the combined size.
+    */
+   void Reset();
+
+   /**
+    * @brief Current position in the arena, for use with Rewind()
+    */
+   Mark GetMark() const;
+
+   /**
+    * @brief Release every allocation made since a mark was taken. Blocks added
+    * since the mark are freed. Rewinding to a mark taken while the arena held
+    * no allocations is equivalent to Reset(), and retains the memory.
+    * @param mark Position returned by GetMark(), with no Rewind() or Reset()
+    * to an earlier position since
+    */
+   void Rewind(const Mark& mark);
+
+   /**
+    * @brief Number of bytes reserved by the arena
+    */
+   size_t capacity() const;
+
+   /**
+    * @brief Number of bytes allocated since the last reset, including
+    * alignment padding
+    */
+   size_t used() const;
+
+private:
+   struct Block
+   {
+      std::unique_ptr<uint8_t[]> memory_;
+      uint8_t*                   begin_;
+      size_t                     size_;
+      size_t                     offset_;
+   };
+
+   void AddBlock(size_t size);
+   void ResetBlocks();
+
+   mutable std::mutex mutex_;
+   std::vector<Block> blocks_;
+   size_t             blockSize_;
+};
+
+/**
+ * @brief Releases the allocations made from a scratch arena within a scope
+ * when the scope is left, including when an exception is thrown.
+ *
+ * Allocations made by other threads while the scope is active are released
+ * too, so a stage may only open a scope if no stage running concurrently with
+ * it allocates from the same arena.
+ */
+class ScratchScope
+{
+public:
+   explicit ScratchScope(ScratchArena& arena) :
+       arena_(arena), mark_(arena.GetMark())
+   {
+   }
+   ~ScratchScope() { arena_.Rewind(mark_); }
+
+   ScratchScope(const ScratchScope&)            = delete;
+   ScratchScope& operator=(const ScratchScope&) = delete;
+
+private:
+   ScratchArena&      arena_;
+   ScratchArena::Mark mark_;
+};
+
+} // namespace WorldEngine
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "common.h"
+#include "layer_view.h"
 
+#include <array>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -60,6 +62,82 @@ typedef boost::multi_array<TemperatureDataType, 2>   TemperatureArrayType;
 typedef boost::multi_array<RiverMapDataType, 2>      RiverMapArrayType;
 typedef boost::multi_array<WaterMapDataType, 2>      WaterMapArrayType;
 
+/**
+ * @brief Create a view of a two-dimensional array
+ * @param array Array with the default row-major storage order
+ * @return View of the array, valid until the array is resized or destroyed
+ */
+template<typename T>
+LayerView<T> MakeLayerView(boost::multi_array<T, 2>& array)
+{
+   return LayerView<T>(array.data(),
+                       static_cast<uint32_t>(array.shape()[1]),
+                       static_cast<uint32_t>(array.shape()[0]),
+                       static_cast<size_t>(array.strides()[0]));
+}
+
+template<typename T>
+LayerView<const T> MakeLayerView(const boost::multi_array<T, 2>& array)
+{
+   return LayerView<const T>(array.data(),
+                             static_cast<uint32_t>(array.shape()[1]),
+                             static_cast<uint32_t>(array.shape()[0]),
+                             static_cast<size_t>(array.strides()[0]));
+}
+
+/**
+ * @brief Versions of the layers read and written by a simulation when it last
+ * ran. The parameters a simulation consumes are fixed by its stage, and are
+ * not recorded.
+ */
+struct SimulationRecord
+{
+   std::unordered_map<Layer, uint32_t> inputVersions_;  /**< Layers read */
+   std::unordered_map<Layer, uint32_t> outputVersions_; /**< Layers written */
+};
+
+/**
+ * @brief Record of the simulations which generated a world, allowing the
+ * layers affected by a change to be regenerated. Records are not serialized.
+ */
+struct GenerationRecord
+{
+   Step     step_ = STEP_PLATES; /**< Generation steps performed */
+   uint32_t seed_ = 0u;          /**< Seed of the simulations */
+
+   /**
+    * @brief Outcome of the plates simulation. Truncated if its budget was
+    * exhausted, in which case the world differs from a converged simulation.
+    */
+   PlatesStatus platesStatus_ = PlatesStatus::Finished;
+
+   /**
+    * @brief Most recently assigned layer version
+    */
+   uint32_t lastVersion_ = 0u;
+
+   /**
+    * @brief Cells changed by erosion, by index, with their elevation before
+    * erosion. Erosion only changes cells near rivers, so this is far smaller
+    * than the elevation layer, and allows erosion to be repeated from the
+    * elevation it eroded.
+    */
+   std::vector<std::pair<size_t, ElevationDataType>> erosionChanges_;
+
+   /**
+    * @brief Record of each simulation, by the time it last ran
+    */
+   std::unordered_map<Simulation, SimulationRecord> simulations_;
+};
+
+/**
+ * @brief Enable logging the contents of layers set from external buffers, such
+ * as the results of the plates simulation. Disabled by default, in which case
+ * nothing is formatted.
+ */
+void SetLayerDiagnostics(bool enabled);
+bool LayerDiagnostics();
+
 class World
 {
 public:
@@ -129,6 +207,40 @@ public:
    TemperatureArrayType&   GetTemperatureData();
    WaterMapArrayType&      GetWaterMapData();
 
+   /**
+    * @brief Views of each layer, for use in performance sensitive loops. A
+    * view is invalidated when its layer is resized.
+    */
+   LayerView<const ElevationDataType>     GetElevationView() const;
+   LayerView<const OceanDataType>         GetOceanView() const;
+   LayerView<const PlateDataType>         GetPlateView() const;
+   LayerView<const Biome>                 GetBiomeView() const;
+   LayerView<const HumidityDataType>      GetHumidityView() const;
+   LayerView<const IcecapDataType>        GetIcecapView() const;
+   LayerView<const IrrigationDataType>    GetIrrigationView() const;
+   LayerView<const LakeMapDataType>       GetLakeMapView() const;
+   LayerView<const PermeabilityDataType>  GetPermeabilityView() const;
+   LayerView<const PrecipitationDataType> GetPrecipitationView() const;
+   LayerView<const RiverMapDataType>      GetRiverMapView() const;
+   LayerView<const SeaDepthDataType>      GetSeaDepthView() const;
+   LayerView<const TemperatureDataType>   GetTemperatureView() const;
+   LayerView<const WaterMapDataType>      GetWaterMapView() const;
+
+   LayerView<ElevationDataType>     GetElevationView();
+   LayerView<OceanDataType>         GetOceanView();
+   LayerView<PlateDataType>         GetPlateView();
+   LayerView<Biome>                 GetBiomeView();
+   LayerView<HumidityDataType>      GetHumidityView();
+   LayerView<IcecapDataType>        GetIcecapView();
+   LayerView<IrrigationDataType>    GetIrrigationView();
+   LayerView<LakeMapDataType>       GetLakeMapView();
+   LayerView<PermeabilityDataType>  GetPermeabilityView();
+   LayerView<PrecipitationDataType> GetPrecipitationView();
+   LayerView<RiverMapDataType>      GetRiverMapView();
+   LayerView<SeaDepthDataType>      GetSeaDepthView();
+   LayerView<TemperatureDataType>   GetTemperatureView();
+   LayerView<WaterMapDataType>      GetWaterMapView();
+
    float GetThreshold(ElevationThreshold type) const;
    float GetThreshold(HumidityLevel type) const;
    float GetThreshold(PermeabilityLevel type) const;
@@ -147,9 +259,36 @@ public:
    bool IsOcean(Point p) const;
    bool IsMountain(uint32_t x, uint32_t y) const;
 
+   /**
+    * @brief Version of a layer, assigned each time a simulation writes the
+    * layer. Layers which have not been written by a simulation have version 0.
+    */
+   uint32_t GetLayerVersion(Layer layer) const;
+   void     SetLayerVersion(Layer layer, uint32_t version);
+
+   /**
+    * @brief Signal that a layer was edited outside of generation, assigning it
+    * the next version of the generation record
+    * @param layer Edited layer
+    * @return New version of the layer
+    */
+   uint32_t MarkLayerEdited(Layer layer);
+
+   const GenerationRecord& GetGenerationRecord() const;
+   GenerationRecord&       GetGenerationRecord();
+
    TemperatureLevel GetTemperatureLevel(uint32_t x, uint32_t y) const;
    HumidityLevel    GetHumidityLevel(uint32_t x, uint32_t y) const;
 
+   /**
+    * @brief Quantize every cell into levels in a single pass, for use in
+    * performance sensitive loops. Each cell receives the underlying value of
+    * the level returned by GetTemperatureLevel() or GetHumidityLevel().
+    * @param levels Layer of width() x height() cells
+    */
+   void GetTemperatureLevels(LayerView<uint8_t> levels) const;
+   void GetHumidityLevels(LayerView<uint8_t> levels) const;
+
    void GetRandomLand(std::vector<Point>& landSamples,
                       uint32_t            numSamples,
                       uint32_t            seed) const;
@@ -167,6 +306,11 @@ public:
    void SetThreshold(TemperatureLevel type, float value);
    void SetThreshold(WaterThreshold type, float value);
 
+   void SetTemps(const std::vector<float>& temps);
+   void SetHumids(const std::vector<float>& humids);
+   void SetGammaCurve(float gammaCurve);
+   void SetCurveOffset(float curveOffset);
+
    bool ProtobufSerialize(std::string& output) const;
    bool ProtobufDeserialize(std::istream& input);
 
@@ -205,6 +349,9 @@ private:
    std::unordered_map<TemperatureLevel, float>   temperatureThresholds_;
    std::unordered_map<WaterThreshold, float>     waterThresholds_;
 
+   std::array<uint32_t, static_cast<size_t>(Layer::Count)> layerVersions_;
+   GenerationRecord                                        generationRecord_;
+
    template<typename T, typename U>
    void SetArrayData(const U* source, boost::multi_array<T, 2>& dest);
 };
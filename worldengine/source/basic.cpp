@@ -1,107 +1,318 @@
 #include "basic.h"
 
-#if defined(__GNUC__)
-#pragma GCC diagnostic push
-#if __GNUC_PREREQ(9, 0)
-#pragma GCC diagnostic ignored "-Wdeprecated-copy"
-#endif
-#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
-#pragma GCC diagnostic ignored "-Wunused-parameter"
-#endif
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
 
-#include <boost/accumulators/accumulators.hpp>
-#include <boost/accumulators/statistics.hpp>
 #include <boost/log/trivial.hpp>
 
-#if defined(__GNUC__)
-#pragma GCC diagnostic pop
-#endif
-
-#if defined(_MSC_VER)
-#pragma warning(push)
-#pragma warning(disable : 4127)
-#pragma warning(disable : 4554)
-#pragma warning(disable : 26450)
-#pragma warning(disable : 26451)
-#pragma warning(disable : 26454)
-#pragma warning(disable : 26495)
-#pragma warning(disable : 26812)
-#elif defined(__GNUC__)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-parameter"
-#endif
-
-#include <unsupported/Eigen/CXX11/Tensor>
-
-#if defined(_MSC_VER)
-#pragma warning(pop)
-#elif defined(__GNUC__)
-#pragma GCC diagnostic pop
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
 #endif
 
 #include <OpenSimplexNoise.h>
 
-namespace ba = boost::accumulators;
-
 namespace WorldEngine
 {
 
+/**
+ * @brief Sum each cell of a row with its left and right neighbors, wrapping
+ * around horizontally
+ * @param src Source row
+ * @param dst Destination row
+ * @param width Number of cells in each row
+ */
+static void AntiAliasSumRow(const float* src, float* dst, uint32_t width);
+
+/**
+ * @brief Combine the horizontal sums of three consecutive rows into a row of
+ * the anti-aliased result
+ * @param above Horizontal sums of the row above
+ * @param row Horizontal sums of the row
+ * @param below Horizontal sums of the row below
+ * @param part Weighted original values of the row
+ * @param weight Weight of each cell of the 3x3 neighborhood
+ * @param dst Destination row
+ * @param width Number of cells in each row
+ */
+static void AntiAliasCombineRows(const float* above,
+                                 const float* row,
+                                 const float* below,
+                                 const float* part,
+                                 float        weight,
+                                 float*       dst,
+                                 uint32_t     width);
+
+/**
+ * @brief Count how many neighbors of a coordinate are set to true, with each
+ * row of the mask packed into bits. The cells set within the radius of each
+ * cell of a row are counted from the number of bits set before each word, and
+ * the row counts are summed over a window of rows which slides down the map.
+ * @param mask
+ * @param radius
+ * @param arena Arena for temporary tables
+ * @return Map of number of neighbors
+ */
+static boost::multi_array<uint32_t, 2>
+CountNeighborsPacked(const boost::multi_array<bool, 2>& mask,
+                     int32_t                            radius,
+                     ScratchArena&                      arena);
+
+/**
+ * @brief Count the bits set in a word
+ */
+static uint32_t PopCount(uint64_t value);
+
 void AntiAlias(boost::multi_array<float, 2>& mapData, size_t steps)
 {
-   typedef Eigen::Tensor<float, 2>    Tensor2D;
-   typedef Eigen::TensorMap<Tensor2D> Tensor2DMap;
+   // Number of rows in each task. The horizontal sums of the rows surrounding
+   // each band are computed by both of the neighboring tasks.
+   static const uint32_t bandHeight = 32u;
 
    static const float w = 1.0f / 11.0f;
 
-   Tensor2D kernel(3, 3);
-   kernel.setValues({{w, w, w}, {w, w, w}, {w, w, w}});
+   const uint32_t width    = static_cast<uint32_t>(mapData.shape()[1]);
+   const uint32_t height   = static_cast<uint32_t>(mapData.shape()[0]);
+   const size_t   numCells = mapData.num_elements();
 
-   const uint32_t width  = static_cast<uint32_t>(mapData.shape()[1]);
-   const uint32_t height = static_cast<uint32_t>(mapData.shape()[0]);
+   if (steps == 0u || numCells == 0u)
+   {
+      return;
+   }
 
-   Tensor2DMap map(mapData.data(), width, height);
+   // Each step blends the neighborhood with the original values
+   std::vector<float> part(numCells);
+   std::transform(mapData.data(),
+                  mapData.data() + numCells,
+                  part.begin(),
+                  [](const float& a) -> float { return a * (2.0f / 11.0f); });
 
-   Tensor2D mapPart = map * (2.0f / 11.0f);
+   // Steps alternate between the map and a single buffer
+   std::vector<float> buffer(numCells);
+   float*             src = mapData.data();
+   float*             dst = buffer.data();
 
-   auto AntiAliasStep = [&width,
-                         &height,
-                         &mapPart = std::as_const(mapPart),
-                         &kernel  = std::as_const(kernel)](Tensor2DMap& map)
+   const uint32_t numBands = (height + bandHeight - 1u) / bandHeight;
+
+   for (size_t i = 0; i < steps; i++)
    {
-      // Specify first and second dimension for convolution
-      static const Eigen::array<int, 2> dimensions({0, 1});
+      ParallelFor(0u,
+                  numBands,
+                  [&](uint32_t band)
+                  {
+                     const uint32_t y0 = band * bandHeight;
+                     const uint32_t y1 = std::min(y0 + bandHeight, height);
+
+                     // Horizontal sums of the rows above, at and below the
+                     // current row, wrapping around vertically
+                     std::vector<float> sums(3u * width);
+                     float* above = sums.data();
+                     float* row   = above + width;
+                     float* below = row + width;
+
+                     AntiAliasSumRow(
+                        src + ((y0 + height - 1u) % height) * width,
+                        above,
+                        width);
+                     AntiAliasSumRow(src + y0 * width, row, width);
+
+                     for (uint32_t y = y0; y < y1; y++)
+                     {
+                        AntiAliasSumRow(
+                           src + ((y + 1u) % height) * width, below, width);
+                        AntiAliasCombineRows(above,
+                                             row,
+                                             below,
+                                             part.data() + y * width,
+                                             w,
+                                             dst + y * width,
+                                             width);
+
+                        std::swap(above, row);
+                        std::swap(row, below);
+                     }
+                  });
 
-      // Create a circular boundary
-      const Eigen::array<std::pair<int, int>, 2> paddings(
-         {std::make_pair(1, 1), std::make_pair(1, 1)});
-      Tensor2D paddedMap = map.pad(paddings);
+      std::swap(src, dst);
+   }
 
-      for (uint32_t x = 0; x <= width + 1; x++)
-      {
-         paddedMap(x, 0)          = paddedMap(x, height);
-         paddedMap(x, height + 1) = paddedMap(x, 1);
-      }
-      for (uint32_t y = 0; y <= height + 1; y++)
-      {
-         paddedMap(0, y)         = paddedMap(width, y);
-         paddedMap(width + 1, y) = paddedMap(1, y);
-      }
+   if (src != mapData.data())
+   {
+      std::copy(src, src + numCells, mapData.data());
+   }
+}
 
-      map = paddedMap.convolve(kernel, dimensions);
+static void AntiAliasSumRow(const float* src, float* dst, uint32_t width)
+{
+   static const bool useAvx2 = AntiAliasAvx2Supported();
 
-      map += mapPart;
-   };
+   if (width == 1u)
+   {
+      dst[0] = (src[0] + src[0]) + src[0];
+      return;
+   }
 
-   for (size_t i = 0; i < steps; i++)
+   dst[0]         = (src[width - 1u] + src[0]) + src[1];
+   dst[width - 1] = (src[width - 2u] + src[width - 1u]) + src[0];
+
+   if (useAvx2)
    {
-      AntiAliasStep(map);
+      AntiAliasSumRowAvx2(src, dst, 1u, width - 1u);
+      return;
+   }
+
+   for (uint32_t x = 1u; x < width - 1u; x++)
+   {
+      dst[x] = (src[x - 1u] + src[x]) + src[x + 1u];
    }
 }
 
+static void AntiAliasCombineRows(const float* above,
+                                 const float* row,
+                                 const float* below,
+                                 const float* part,
+                                 float        weight,
+                                 float*       dst,
+                                 uint32_t     width)
+{
+   static const bool useAvx2 = AntiAliasAvx2Supported();
+
+   if (useAvx2)
+   {
+      AntiAliasCombineRowsAvx2(above, row, below, part, weight, dst, width);
+      return;
+   }
+
+   for (uint32_t x = 0; x < width; x++)
+   {
+      dst[x] = ((above[x] + row[x]) + below[x]) * weight + part[x];
+   }
+}
+
+bool AntiAliasAvx2Supported()
+{
+   return AntiAliasAvx2Compiled() && ProcessorSupportsAvx2();
+}
+
+bool ProcessorSupportsAvx2()
+{
+   static const bool supported = []()
+   {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+      int info[4];
+
+      __cpuid(info, 1);
+      const bool osxsave = (info[2] & (1 << 27)) != 0;
+      if (!osxsave || (_xgetbv(0) & 0x6) != 0x6)
+      {
+         // Operating system does not save YMM registers
+         return false;
+      }
+
+      __cpuidex(info, 7, 0);
+      return (info[1] & (1 << 5)) != 0;
+#elif (defined(__GNUC__) || defined(__clang__)) && \
+   (defined(__x86_64__) || defined(__i386__))
+      return __builtin_cpu_supports("avx2") != 0;
+#else
+      return false;
+#endif
+   }();
+
+   return supported;
+}
+
 template<typename T>
 boost::multi_array<uint32_t, 2>
-CountNeighbors(const boost::multi_array<T, 2>& mask, int32_t radius)
+CountNeighbors(const boost::multi_array<T, 2>& mask,
+               int32_t                         radius,
+               ScratchArena*                   scratch)
 {
+   ScratchArena  localScratch;
+   ScratchArena& arena = (scratch != nullptr) ? *scratch : localScratch;
+   ScratchScope  scope(arena);
+
+   if constexpr (std::is_same_v<T, bool>)
+   {
+      return CountNeighborsPacked(mask, radius, arena);
+   }
+   else
+   {
+      const int32_t width  = static_cast<int32_t>(mask.shape()[1]);
+      const int32_t height = static_cast<int32_t>(mask.shape()[0]);
+
+      boost::multi_array<uint32_t, 2> neighbors(boost::extents[height][width]);
+
+      std::fill(
+         neighbors.data(), neighbors.data() + neighbors.num_elements(), 0u);
+
+      if (radius <= 0)
+      {
+         return neighbors;
+      }
+
+      // Summed-area table, preceded by a row and column of zeros, so that
+      // sums[y][x] is the number of cells set in the first y rows and x
+      // columns
+      const size_t        stride    = static_cast<size_t>(width) + 1u;
+      LayerView<uint32_t> sumsTable = arena.AllocateLayer<uint32_t>(
+         static_cast<uint32_t>(stride), static_cast<uint32_t>(height + 1), 0u);
+      uint32_t* sums = sumsTable.data();
+
+      for (int32_t y = 0; y < height; y++)
+      {
+         uint32_t rowSum = 0u;
+         for (int32_t x = 0; x < width; x++)
+         {
+            if (mask[y][x])
+            {
+               rowSum++;
+            }
+            sums[(y + 1) * stride + x + 1] = sums[y * stride + x + 1] + rowSum;
+         }
+      }
+
+      ParallelFor(0u,
+                  static_cast<uint32_t>(height),
+                  [&](uint32_t row)
+                  {
+                     const int32_t y  = static_cast<int32_t>(row);
+                     const size_t  y0 = std::max(y - radius, 0) * stride;
+                     const size_t  y1 =
+                        std::min(y + radius + 1, height) * stride;
+
+                     for (int32_t x = 0; x < width; x++)
+                     {
+                        const int32_t x0 = std::max(x - radius, 0);
+                        const int32_t x1 = std::min(x + radius + 1, width);
+
+                        uint32_t count = sums[y1 + x1] - sums[y0 + x1] -
+                                         sums[y1 + x0] + sums[y0 + x0];
+
+                        neighbors[y][x] = count - (mask[y][x] ? 1u : 0u);
+                     }
+                  });
+
+      return neighbors;
+   }
+}
+template boost::multi_array<uint32_t, 2>
+CountNeighbors<bool>(const boost::multi_array<bool, 2>& mask,
+                     int32_t                            radius,
+                     ScratchArena*                      scratch);
+template boost::multi_array<uint32_t, 2>
+CountNeighbors<float>(const boost::multi_array<float, 2>& mask,
+                      int32_t                             radius,
+                      ScratchArena*                       scratch);
+
+static boost::multi_array<uint32_t, 2>
+CountNeighborsPacked(const boost::multi_array<bool, 2>& mask,
+                     int32_t                            radius,
+                     ScratchArena&                      arena)
+{
+   static const int32_t wordBits = 64;
+
    const int32_t width  = static_cast<int32_t>(mask.shape()[1]);
    const int32_t height = static_cast<int32_t>(mask.shape()[0]);
 
@@ -109,84 +320,441 @@ CountNeighbors(const boost::multi_array<T, 2>& mask, int32_t radius)
 
    std::fill(neighbors.data(), neighbors.data() + neighbors.num_elements(), 0u);
 
-   for (int32_t y = 0; y < height; y++)
+   if (radius <= 0 || width == 0)
+   {
+      return neighbors;
+   }
+
+   // Each row packed into words, and the number of bits set before each word,
+   // including one past the last word
+   const int32_t  numWords = (width + wordBits - 1) / wordBits;
+   const uint32_t words    = static_cast<uint32_t>(numWords);
+   const uint32_t rows     = static_cast<uint32_t>(height);
+
+   uint64_t* bits   = arena.AllocateLayer<uint64_t>(words, rows, 0u).data();
+   uint32_t* before = arena.AllocateLayer<uint32_t>(words + 1u, rows).data();
+
+   ParallelFor(0u,
+               static_cast<uint32_t>(height),
+               [&](uint32_t y)
+               {
+                  uint64_t* rowBits   = &bits[y * numWords];
+                  uint32_t* rowBefore = &before[y * (numWords + 1)];
+
+                  for (int32_t x = 0; x < width; x++)
+                  {
+                     if (mask[y][x])
+                     {
+                        rowBits[x / wordBits] |= uint64_t(1u)
+                                                 << (x % wordBits);
+                     }
+                  }
+
+                  rowBefore[0] = 0u;
+                  for (int32_t w = 0; w < numWords; w++)
+                  {
+                     rowBefore[w + 1] = rowBefore[w] + PopCount(rowBits[w]);
+                  }
+               });
+
+   // Number of bits set in the first n cells of a row
+   auto CountBefore = [&](int32_t y, int32_t n) -> uint32_t
+   {
+      const int32_t word  = n / wordBits;
+      const int32_t bit   = n % wordBits;
+      uint32_t      count = before[y * (numWords + 1) + word];
+
+      if (bit != 0)
+      {
+         count += PopCount(bits[y * numWords + word] &
+                           ((uint64_t(1u) << bit) - 1u));
+      }
+
+      return count;
+   };
+
+   // Add the number of cells set within the radius of each cell of a row
+   auto AddRowCounts = [&](int32_t y, uint32_t* sums, bool add)
    {
       for (int32_t x = 0; x < width; x++)
       {
-         for (int32_t ny = y - radius; ny <= y + radius; ny++)
-         {
-            if (0 <= ny && ny < height)
-            {
-               for (int32_t nx = x - radius; nx <= x + radius; nx++)
+         uint32_t count = CountBefore(y, std::min(x + radius + 1, width)) -
+                          CountBefore(y, std::max(x - radius, 0));
+
+         sums[x] = add ? sums[x] + count : sums[x] - count;
+      }
+   };
+
+   // Bands are at least as tall as the window, so that the rows summed before
+   // the first row of each band are a small part of its work
+   const int32_t bandHeight = std::max(wordBits, 2 * radius + 1);
+   const int32_t numBands   = (height + bandHeight - 1) / bandHeight;
+
+   // Cells set within the radius of each cell of the current row of each band
+   LayerView<uint32_t> bandSums = arena.AllocateLayer<uint32_t>(
+      static_cast<uint32_t>(width), static_cast<uint32_t>(numBands), 0u);
+
+   ParallelFor(0u,
+               static_cast<uint32_t>(numBands),
+               [&](uint32_t band)
                {
-                  if ((nx != x || ny != y) && 0 <= nx && nx < width)
+                  const int32_t y0 = static_cast<int32_t>(band) * bandHeight;
+                  const int32_t y1 = std::min(y0 + bandHeight, height);
+
+                  // The window starts one row above the band
+                  uint32_t* sums = bandSums[band];
+
+                  for (int32_t ny = std::max(y0 - radius - 1, 0);
+                       ny < std::min(y0 + radius, height);
+                       ny++)
                   {
-                     if (mask[ny][nx])
+                     AddRowCounts(ny, sums, true);
+                  }
+
+                  for (int32_t y = y0; y < y1; y++)
+                  {
+                     // Slide the window down to the current row
+                     if (y + radius < height)
+                     {
+                        AddRowCounts(y + radius, sums, true);
+                     }
+                     if (y - radius - 1 >= 0)
+                     {
+                        AddRowCounts(y - radius - 1, sums, false);
+                     }
+
+                     for (int32_t x = 0; x < width; x++)
                      {
-                        neighbors[y][x]++;
+                        neighbors[y][x] = sums[x] - (mask[y][x] ? 1u : 0u);
                      }
                   }
-               }
-            }
-         }
-      }
-   }
+               });
 
    return neighbors;
 }
-template boost::multi_array<uint32_t, 2>
-CountNeighbors<bool>(const boost::multi_array<bool, 2>& mask, int32_t radius);
-template boost::multi_array<uint32_t, 2>
-CountNeighbors<float>(const boost::multi_array<float, 2>& mask, int32_t radius);
 
-float FindThresholdF(const boost::multi_array<float, 2>& mapData,
-                     float                               landPercentage,
-                     const OceanArrayType*               ocean)
+static uint32_t PopCount(uint64_t value)
 {
-   typedef ba::accumulator_set<float, ba::stats<ba::tag::p_square_quantile>>
-      accumulator_t;
+#if defined(__GNUC__) || defined(__clang__)
+   return static_cast<uint32_t>(__builtin_popcountll(value));
+#else
+   value = value - ((value >> 1) & 0x5555555555555555ull);
+   value = (value & 0x3333333333333333ull) +
+           ((value >> 2) & 0x3333333333333333ull);
+   value = (value + (value >> 4)) & 0x0f0f0f0f0f0f0f0full;
+   return static_cast<uint32_t>((value * 0x0101010101010101ull) >> 56);
+#endif
+}
 
-   const uint32_t width    = static_cast<uint32_t>(mapData.shape()[1]);
-   const uint32_t height   = static_cast<uint32_t>(mapData.shape()[0]);
-   float          quantile = 1.0f - landPercentage;
+void DistanceTransform(LayerView<const bool> features,
+                       LayerView<float>      distance,
+                       DistanceMetric        metric)
+{
+   // Number of columns in each task of the first phase, so that each row is
+   // read in contiguous runs
+   static const int32_t stripWidth = 64;
 
-   accumulator_t accumulator(ba::quantile_probability = quantile);
+   const int32_t width  = static_cast<int32_t>(features.width());
+   const int32_t height = static_cast<int32_t>(features.height());
 
-   if (ocean == nullptr || ocean->size() != mapData.size())
+   if (width == 0 || height == 0)
    {
-      BOOST_LOG_TRIVIAL(trace) << "Calculating threshold (" << landPercentage
-                               << ") without ocean data...";
+      return;
+   }
+
+   // Greater than the distance between any two cells
+   const int64_t unreachable = static_cast<int64_t>(width) + height;
+   const int64_t unreachableF =
+      (metric == DistanceMetric::Euclidean) ? unreachable * unreachable
+                                            : unreachable;
 
-      for (uint32_t y = 0; y < height; y++)
+   // Phase 1: Distance to the nearest feature in the same column
+   const int32_t numStrips = (width + stripWidth - 1) / stripWidth;
+
+   ParallelFor(
+      0u,
+      static_cast<uint32_t>(numStrips),
+      [&](uint32_t strip)
       {
-         for (uint32_t x = 0; x < width; x++)
+         const int32_t x0 = static_cast<int32_t>(strip) * stripWidth;
+         const int32_t x1 = std::min(x0 + stripWidth, width);
+
+         for (int32_t x = x0; x < x1; x++)
          {
-            accumulator(mapData[y][x]);
+            distance[0][x] =
+               features[0][x] ? 0.0f : static_cast<float>(unreachable);
          }
-      }
-   }
-   else
-   {
-      BOOST_LOG_TRIVIAL(trace) << "Calculating threshold (" << landPercentage
-                               << ") with ocean data...";
 
-      for (uint32_t y = 0; y < height; y++)
+         for (int32_t y = 1; y < height; y++)
+         {
+            for (int32_t x = x0; x < x1; x++)
+            {
+               distance[y][x] =
+                  features[y][x]
+                     ? 0.0f
+                     : std::min(distance[y - 1][x] + 1.0f,
+                                static_cast<float>(unreachable));
+            }
+         }
+
+         for (int32_t y = height - 2; y >= 0; y--)
+         {
+            for (int32_t x = x0; x < x1; x++)
+            {
+               distance[y][x] =
+                  std::min(distance[y][x], distance[y + 1][x] + 1.0f);
+            }
+         }
+      });
+
+   // Phase 2: Lower envelope of the column distances along each row
+   ParallelFor(
+      0u,
+      static_cast<uint32_t>(height),
+      [&](uint32_t y)
       {
-         for (uint32_t x = 0; x < width; x++)
+         float* row = distance[y];
+
+         std::vector<int64_t> g(width);
+         std::vector<int32_t> s(width);
+         std::vector<int64_t> t(width);
+
+         for (int32_t x = 0; x < width; x++)
+         {
+            g[x] = static_cast<int64_t>(row[x]);
+         }
+
+         // Distance from x to the nearest feature in column i
+         auto F = [&](int64_t x, int32_t i) -> int64_t
+         {
+            if (metric == DistanceMetric::Euclidean)
+            {
+               return (x - i) * (x - i) + g[i] * g[i];
+            }
+            return std::max(std::abs(x - i), g[i]);
+         };
+
+         // Last x for which column i is at least as near as column u, i < u
+         auto Sep = [&](int32_t i, int32_t u) -> int64_t
          {
-            if (!(*ocean)[y][x])
+            if (metric == DistanceMetric::Euclidean)
             {
-               accumulator(mapData[y][x]);
+               return (static_cast<int64_t>(u) * u -
+                       static_cast<int64_t>(i) * i + g[u] * g[u] -
+                       g[i] * g[i]) /
+                      (2 * static_cast<int64_t>(u - i));
+            }
+            if (g[i] <= g[u])
+            {
+               return std::max<int64_t>(i + g[u], (i + u) / 2);
+            }
+            return std::min<int64_t>(u - g[i], (i + u) / 2);
+         };
+
+         int32_t q = 0;
+         s[0]      = 0;
+         t[0]      = 0;
+
+         for (int32_t u = 1; u < width; u++)
+         {
+            while (q >= 0 && F(t[q], s[q]) > F(t[q], u))
+            {
+               q--;
+            }
+
+            if (q < 0)
+            {
+               q    = 0;
+               s[0] = u;
+            }
+            else
+            {
+               int64_t w = 1 + Sep(s[q], u);
+               if (w < width)
+               {
+                  q++;
+                  s[q] = u;
+                  t[q] = w;
+               }
             }
          }
-      }
+
+         for (int32_t u = width - 1; u >= 0; u--)
+         {
+            int64_t f = F(u, s[q]);
+
+            if (f >= unreachableF)
+            {
+               row[u] = std::numeric_limits<float>::infinity();
+            }
+            else if (metric == DistanceMetric::Euclidean)
+            {
+               row[u] = static_cast<float>(std::sqrt(static_cast<double>(f)));
+            }
+            else
+            {
+               row[u] = static_cast<float>(f);
+            }
+
+            if (u == t[q])
+            {
+               q--;
+            }
+         }
+      });
+}
+
+float FindThresholdF(const boost::multi_array<float, 2>& mapData,
+                     float                               landPercentage,
+                     const OceanArrayType*               ocean)
+{
+   return FindThresholdsF(mapData, {landPercentage}, ocean)[0];
+}
+
+std::vector<float>
+FindThresholdsF(const boost::multi_array<float, 2>& mapData,
+                const std::vector<float>&           landPercentages,
+                const OceanArrayType*               ocean)
+{
+   const uint32_t width  = static_cast<uint32_t>(mapData.shape()[1]);
+   const uint32_t height = static_cast<uint32_t>(mapData.shape()[0]);
+
+   const bool useOcean = (ocean != nullptr && ocean->size() == mapData.size());
+
+   BOOST_LOG_TRIVIAL(trace) << "Calculating " << landPercentages.size()
+                            << " threshold(s) "
+                            << (useOcean ? "with" : "without")
+                            << " ocean data...";
+
+   // Count land cells in each row, and copy them to a contiguous array
+   std::vector<size_t> rowOffsets(height + 1u, 0u);
+
+   if (useOcean)
+   {
+      ParallelFor(0u,
+                  height,
+                  [&](uint32_t y)
+                  {
+                     const auto row    = (*ocean)[y];
+                     rowOffsets[y + 1] = static_cast<size_t>(
+                        std::count(row.begin(), row.end(), false));
+                  });
+   }
+   else
+   {
+      std::fill(rowOffsets.begin() + 1, rowOffsets.end(), width);
+   }
+
+   for (uint32_t y = 0; y < height; y++)
+   {
+      rowOffsets[y + 1] += rowOffsets[y];
    }
 
-   float threshold = ba::p_square_quantile(accumulator);
+   std::vector<float> values(rowOffsets[height]);
 
-   BOOST_LOG_TRIVIAL(trace) << "Threshold: " << threshold;
+   ParallelFor(0u,
+               height,
+               [&](uint32_t y)
+               {
+                  size_t i = rowOffsets[y];
+                  for (uint32_t x = 0; x < width; x++)
+                  {
+                     if (!useOcean || !(*ocean)[y][x])
+                     {
+                        values[i++] = mapData[y][x];
+                     }
+                  }
+               });
 
-   return threshold;
+   return SelectThresholdsF(values, landPercentages);
+}
+
+std::vector<float> SelectThresholdsF(std::vector<float>&       values,
+                                     const std::vector<float>& percentages)
+{
+   std::vector<float> thresholds(percentages.size(), 0.0f);
+
+   if (values.empty())
+   {
+      BOOST_LOG_TRIVIAL(trace) << "No values, thresholds are 0";
+      return thresholds;
+   }
+
+   // Each threshold lies between two ranks of the sorted values
+   const size_t        n = values.size();
+   std::vector<double> positions(percentages.size());
+   std::vector<size_t> ranks;
+
+   for (size_t i = 0; i < percentages.size(); i++)
+   {
+      double quantile = std::clamp(1.0 - percentages[i], 0.0, 1.0);
+      positions[i]    = quantile * static_cast<double>(n - 1);
+
+      size_t lower = static_cast<size_t>(std::floor(positions[i]));
+      ranks.push_back(lower);
+      ranks.push_back(std::min(lower + 1, n - 1));
+   }
+
+   std::sort(ranks.begin(), ranks.end());
+   ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
+
+   // Select each rank in increasing order, partitioning only the values above
+   // the previous rank
+   auto begin = values.begin();
+   for (size_t rank : ranks)
+   {
+      std::nth_element(begin, values.begin() + rank, values.end());
+      begin = values.begin() + rank + 1;
+   }
+
+   for (size_t i = 0; i < percentages.size(); i++)
+   {
+      size_t lower      = static_cast<size_t>(std::floor(positions[i]));
+      size_t upper      = std::min(lower + 1, n - 1);
+      double t          = positions[i] - static_cast<double>(lower);
+      double lowerValue = values[lower];
+      double upperValue = values[upper];
+
+      thresholds[i] =
+         static_cast<float>(lowerValue + t * (upperValue - lowerValue));
+
+      BOOST_LOG_TRIVIAL(trace) << "Threshold (" << percentages[i]
+                               << "): " << thresholds[i];
+   }
+
+   return thresholds;
+}
+
+void QuantizeLevels(LayerView<const float> values,
+                    const float*           thresholds,
+                    uint8_t                numLevels,
+                    LayerView<uint8_t>     levels)
+{
+   const uint32_t width    = values.width();
+   const uint8_t  topLevel = numLevels - 1u;
+
+   ParallelFor(0u,
+               values.height(),
+               [&](uint32_t y)
+               {
+                  const float* valueRow = values[y];
+                  uint8_t*     levelRow = levels[y];
+
+                  std::fill(levelRow, levelRow + width, topLevel);
+
+                  // Visit thresholds from the highest level down, so the
+                  // first threshold a value is below is selected last
+                  for (uint8_t level = topLevel; level-- > 0u;)
+                  {
+                     const float threshold = thresholds[level];
+
+                     for (uint32_t x = 0; x < width; x++)
+                     {
+                        levelRow[x] =
+                           (valueRow[x] < threshold) ? level : levelRow[x];
+                     }
+                  }
+               });
 }
 
 double Noise(const OpenSimplexNoise::Noise& noise,
@@ -1,6 +1,13 @@
 #pragma once
 
+#include "worldengine/scratch_arena.h"
 #include "worldengine/world.h"
+#include "noise.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
 namespace OpenSimplexNoise
 {
@@ -11,26 +18,105 @@ namespace WorldEngine
 {
 
 /**
- * @brief Execute the anti-alias operation on the given data
+ * @brief Distance metric used by a distance transform
+ */
+enum class DistanceMetric
+{
+   Chebyshev, /**< Greatest of the horizontal and vertical distances */
+   Euclidean  /**< Straight line distance */
+};
+
+/**
+ * @brief Execute the anti-alias operation on the given data. Each step replaces
+ * each cell with its 3x3 neighborhood, wrapping around both axes, weighted by
+ * 1/11, plus the original value of the cell weighted by 2/11. Bands of rows
+ * are processed in parallel.
  * @param data Data to anti-alias
  * @param steps Number of times to run the anti-alias operation
  */
 void AntiAlias(boost::multi_array<float, 2>& data, size_t steps = 1);
 
+/**
+ * @brief Determine whether the AVX2 anti-alias kernels were built. Defined in a
+ * translation unit compiled for AVX2.
+ */
+bool AntiAliasAvx2Compiled();
+
+/**
+ * @brief Determine whether the AVX2 anti-alias kernels were built and the
+ * processor supports them
+ */
+bool AntiAliasAvx2Supported();
+
+/**
+ * @brief AVX2 implementation of the horizontal sums of a row, for cells in
+ * [begin, end) which have a neighbor on each side. Must only be called if
+ * AntiAliasAvx2Supported() returns true.
+ * @param src Source row
+ * @param dst Destination row
+ * @param begin First cell, at least 1
+ * @param end One past the last cell, less than the row width
+ */
+void AntiAliasSumRowAvx2(const float* src,
+                         float*       dst,
+                         uint32_t     begin,
+                         uint32_t     end);
+
+/**
+ * @brief AVX2 implementation of combining the horizontal sums of three rows,
+ * computing ((above + row + below) * weight + part) for each cell. Must only be
+ * called if AntiAliasAvx2Supported() returns true.
+ */
+void AntiAliasCombineRowsAvx2(const float* above,
+                              const float* row,
+                              const float* below,
+                              const float* part,
+                              float        weight,
+                              float*       dst,
+                              uint32_t     width);
+
+/**
+ * @brief Determine whether the processor and operating system support AVX2
+ */
+bool ProcessorSupportsAvx2();
+
 /**
  * @brief Count how many neighbors of a coordinate are set to true.
  * @tparam T
  * @param mask
  * @param radius
+ * @param scratch Arena for temporary tables, released before returning, or
+ * nullptr to allocate them for this call only. Must not be shared with other
+ * threads during the call.
  * @return Map of number of neighbors
  */
 template<typename T>
 boost::multi_array<uint32_t, 2>
-CountNeighbors(const boost::multi_array<T, 2>& mask, int32_t radius = 1);
+CountNeighbors(const boost::multi_array<T, 2>& mask,
+               int32_t                         radius  = 1,
+               ScratchArena*                   scratch = nullptr);
 
 /**
- * @brief Estimate the elevation threshold that is lower than a given percentage
- * of land
+ * @brief Compute the exact distance from each cell to the nearest feature cell.
+ * The running time is linear in the number of cells, and independent of the
+ * distances. Columns, and then rows, are processed in parallel. The map does
+ * not wrap.
+ *
+ * Meijster, A., Roerdink, J. B. T. M., & Hesselink, W. H. (2000). A General
+ * Algorithm for Computing Distance Transforms in Linear Time.
+ *
+ * @param features Feature mask, with feature cells set to true
+ * @param distance Distance to the nearest feature, the same size as features.
+ * Every cell is set to infinity if there are no features.
+ * @param metric Distance metric
+ */
+void DistanceTransform(LayerView<const bool> features,
+                       LayerView<float>      distance,
+                       DistanceMetric        metric);
+
+/**
+ * @brief Find the threshold that is lower than a given percentage of land. The
+ * threshold is interpolated linearly between the two nearest values.
  * @param mapData Elevation data
  * @param landPercentage Percentage of land higher than threshold
  * @param ocean Optional ocean data to exclude in threshold calculation
@@ -40,6 +126,46 @@ float FindThresholdF(const boost::multi_array<float, 2>& mapData,
                      float                               landPercentage,
                      const OceanArrayType*               ocean = nullptr);
 
+/**
+ * @brief Find the thresholds that are lower than each of several percentages of
+ * land, selecting from the land values once for all thresholds
+ * @param mapData Elevation data
+ * @param landPercentages Percentage of land higher than each threshold
+ * @param ocean Optional ocean data to exclude in threshold calculation
+ * @return Threshold for each percentage, in the same order
+ */
+std::vector<float>
+FindThresholdsF(const boost::multi_array<float, 2>& mapData,
+                const std::vector<float>&           landPercentages,
+                const OceanArrayType*               ocean = nullptr);
+
+/**
+ * @brief Find the thresholds that are lower than each of several percentages of
+ * a set of values, selecting from the values once for all thresholds
+ * @param values Values to select from, which are partially reordered
+ * @param percentages Percentage of values higher than each threshold
+ * @return Threshold for each percentage, in the same order. Thresholds are 0 if
+ * there are no values.
+ */
+std::vector<float> SelectThresholdsF(std::vector<float>&       values,
+                                     const std::vector<float>& percentages);
+
+/**
+ * @brief Quantize each cell of a layer into a level. The level of a cell is the
+ * index of the first threshold its value is below, or the last level if its
+ * value is not below any threshold. Rows are processed in parallel, and each
+ * row is quantized with branchless, vectorizable loops.
+ * @param values Values to quantize
+ * @param thresholds Upper bound of each level, numLevels values in level order.
+ * The threshold of the last level has no effect.
+ * @param numLevels Number of levels, greater than 0
+ * @param levels Level of each cell, the same size as values
+ */
+void QuantizeLevels(LayerView<const float> values,
+                    const float*           thresholds,
+                    uint8_t                numLevels,
+                    LayerView<uint8_t>     levels);
+
 /**
  * @brief Perform a linear interpolation over the given points
  * @tparam T
@@ -71,6 +197,72 @@ U Interpolate(T x, const std::vector<std::pair<T, U>>& points)
    return points.back().second;
 }
 
+/**
+ * @brief Approximate std::pow for a positive base, with a relative error
+ * below 1e-5. The approximation has no branches or library calls, so loops
+ * calling it can be vectorized. The power of two of the result is clamped to
+ * the range of normal floats.
+ * @param base Base, greater than 0. A base of 0 returns 0.
+ * @param exponent Exponent
+ * @return Approximation of base raised to exponent
+ */
+inline float PowApprox(float base, float exponent)
+{
+   // log2(base) = e + log2(m), with m in [sqrt(1/2), sqrt(2))
+   uint32_t bits;
+   std::memcpy(&bits, &base, sizeof(bits));
+
+   uint32_t       mantissa = (bits & 0x007fffffu) | 0x3f800000u;
+   const uint32_t high     = (mantissa > 0x3fb504f3u);
+   mantissa -= high << 23;
+
+   const int32_t e = static_cast<int32_t>((bits >> 23) + high) - 127;
+   float         m;
+   std::memcpy(&m, &mantissa, sizeof(m));
+
+   // log2(m) = 2 / ln(2) * atanh(s), with s = (m - 1) / (m + 1)
+   const float s     = (m - 1.0f) / (m + 1.0f);
+   const float s2    = s * s;
+   const float log2m = s * (2.88539008f +
+                            s2 * (0.961796694f +
+                                  s2 * (0.577078016f + s2 * 0.412198583f)));
+
+   const float y = exponent * (static_cast<float>(e) + log2m);
+
+   // exp2(y) = 2^i * exp2(f), with i = floor(y) and f in [0, 1)
+   int32_t i = static_cast<int32_t>(y);
+   i -= (y < static_cast<float>(i));
+
+   const float f    = y - static_cast<float>(i);
+   const float exp2 = //
+      1.0f +
+      f * (0.693147181f +
+           f * (0.240226507f +
+                f * (0.0555041087f +
+                     f * (0.00961812911f +
+                          f * (0.00133335581f +
+                               f * (0.000154035304f + f * 1.52527338e-05f))))));
+
+   // Selects are performed on integers, as floating point selects prevent
+   // vectorization unless traps are disabled
+   i = std::min(std::max(i, -126), 127);
+
+   const uint32_t scaleBits = static_cast<uint32_t>(i + 127) << 23;
+   float          scale;
+   std::memcpy(&scale, &scaleBits, sizeof(scale));
+
+   const float result = scale * exp2;
+   uint32_t    resultBits;
+   std::memcpy(&resultBits, &result, sizeof(resultBits));
+
+   // Zero the result if the base is not positive
+   resultBits &= 0u - static_cast<uint32_t>(base > 0.0f);
+   float power;
+   std::memcpy(&power, &resultBits, sizeof(power));
+
+   return power;
+}
+
 /**
  * @brief OpenSimplex noise value for specified 2D coordinate
  * @param noise Seeded OpenSimplex noise generator
@@ -84,4 +276,82 @@ double Noise(const OpenSimplexNoise::Noise& noise,
              double                         y,
              uint32_t                       octaves = 1);
 
+/**
+ * @brief Evaluate fractal OpenSimplex noise for each cell of a field. Cell
+ * (x, y) samples noise at (x * scale / freq, y * scale / freq), with the
+ * arithmetic performed in T. Rows are evaluated in parallel, and each row is
+ * evaluated as a batch. The results do not depend on the number of threads.
+ * @tparam T Coordinate precision
+ * @tparam F Callable as func(x, y, n), invoked once per cell with the noise
+ * value n. Invocations for different rows may run concurrently.
+ * @param noise Seeded noise generator
+ * @param width Field width
+ * @param height Field height
+ * @param scale Coordinate scale
+ * @param freq Coordinate frequency divisor
+ * @param octaves Number of noise passes
+ * @param wrap If true, the leftmost quarter of the field is blended with noise
+ * sampled one field width to the right, allowing the field to wrap around
+ * horizontally
+ * @param func Function receiving each cell's noise value
+ */
+template<typename T, typename F>
+void NoiseField(const NoiseGenerator& noise,
+                int32_t               width,
+                int32_t               height,
+                T                     scale,
+                T                     freq,
+                uint32_t              octaves,
+                bool                  wrap,
+                F&&                   func)
+{
+   const int32_t border = wrap ? width / 4 : -1;
+   const size_t  numWrapped =
+      static_cast<size_t>(std::min(border + 1, std::max(width, 0)));
+
+   ParallelFor(
+      0u,
+      static_cast<uint32_t>(height),
+      [&](uint32_t row)
+      {
+         const int32_t y  = static_cast<int32_t>(row);
+         const T       ny = y * scale / freq;
+
+         std::vector<double> nx(width);
+         std::vector<double> nxWrapped(numWrapped);
+         std::vector<double> nys(width, static_cast<double>(ny));
+         std::vector<double> values(width);
+         std::vector<double> valuesWrapped(numWrapped);
+
+         for (int32_t x = 0; x < width; x++)
+         {
+            nx[x] = x * scale / freq;
+         }
+         for (size_t x = 0; x < numWrapped; x++)
+         {
+            nxWrapped[x] = (static_cast<int32_t>(x) * scale + width) / freq;
+         }
+
+         noise.Evaluate(nx.data(), nys.data(), width, octaves, values.data());
+         noise.Evaluate(nxWrapped.data(),
+                        nys.data(),
+                        numWrapped,
+                        octaves,
+                        valuesWrapped.data());
+
+         for (int32_t x = 0; x < width; x++)
+         {
+            double n = values[x];
+
+            if (x <= border)
+            {
+               n *= static_cast<double>(x) / border;
+               n += valuesWrapped[x] * (border - x) / border;
+            }
+
+            func(x, y, n);
+         }
+      });
+}
+
 } // namespace WorldEngine
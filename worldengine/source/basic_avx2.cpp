@@ -0,0 +1,96 @@
+/**
+ * This translation unit is compiled for AVX2. Its functions must only be called
+ * after checking AntiAliasAvx2Supported(), and it must not instantiate
+ * templates which could be shared with other translation units.
+ */
+
+#include "basic.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace WorldEngine
+{
+
+#if defined(__AVX2__)
+
+bool AntiAliasAvx2Compiled()
+{
+   return true;
+}
+
+void AntiAliasSumRowAvx2(const float* src,
+                         float*       dst,
+                         uint32_t     begin,
+                         uint32_t     end)
+{
+   uint32_t x = begin;
+
+   for (; x + 8u <= end; x += 8u)
+   {
+      __m256 left   = _mm256_loadu_ps(src + x - 1u);
+      __m256 center = _mm256_loadu_ps(src + x);
+      __m256 right  = _mm256_loadu_ps(src + x + 1u);
+
+      _mm256_storeu_ps(dst + x,
+                       _mm256_add_ps(_mm256_add_ps(left, center), right));
+   }
+
+   for (; x < end; x++)
+   {
+      dst[x] = (src[x - 1u] + src[x]) + src[x + 1u];
+   }
+}
+
+void AntiAliasCombineRowsAvx2(const float* above,
+                              const float* row,
+                              const float* below,
+                              const float* part,
+                              float        weight,
+                              float*       dst,
+                              uint32_t     width)
+{
+   const __m256 w = _mm256_set1_ps(weight);
+
+   uint32_t x = 0;
+
+   for (; x + 8u <= width; x += 8u)
+   {
+      __m256 sum = _mm256_add_ps(
+         _mm256_add_ps(_mm256_loadu_ps(above + x), _mm256_loadu_ps(row + x)),
+         _mm256_loadu_ps(below + x));
+
+      _mm256_storeu_ps(
+         dst + x,
+         _mm256_add_ps(_mm256_mul_ps(sum, w), _mm256_loadu_ps(part + x)));
+   }
+
+   for (; x < width; x++)
+   {
+      dst[x] = ((above[x] + row[x]) + below[x]) * weight + part[x];
+   }
+}
+
+#else
+
+bool AntiAliasAvx2Compiled()
+{
+   return false;
+}
+
+void AntiAliasSumRowAvx2(const float*, float*, uint32_t, uint32_t) {}
+
+void AntiAliasCombineRowsAvx2(const float*,
+                              const float*,
+                              const float*,
+                              const float*,
+                              float,
+                              float*,
+                              uint32_t)
+{
+}
+
+#endif
+
+} // namespace WorldEngine
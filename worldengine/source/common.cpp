@@ -244,6 +244,29 @@ std::istream& operator>>(std::istream& in, SeaColor& color)
    return in;
 }
 
+std::string SimulationToString(Simulation simulation)
+{
+   switch (simulation)
+   {
+   case Simulation::Precipitation: return "Precipitation";
+   case Simulation::Erosion: return "Erosion";
+   case Simulation::Watermap: return "Watermap";
+   case Simulation::Irrigation: return "Irrigation";
+   case Simulation::Temperature: return "Temperature";
+   case Simulation::Humidity: return "Humidity";
+   case Simulation::Permeability: return "Permeability";
+   case Simulation::Biome: return "Biome";
+   case Simulation::Icecap: return "Icecap";
+   default: return "?";
+   }
+}
+
+std::ostream& operator<<(std::ostream& os, const Simulation& simulation)
+{
+   os << SimulationToString(simulation);
+   return os;
+}
+
 std::string StepTypeToString(StepType step)
 {
    switch (step)
@@ -1,5 +1,6 @@
 #include "worldengine/generation.h"
 #include "basic.h"
+#include "scheduler.h"
 #include "simulations/biome.h"
 #include "simulations/erosion.h"
 #include "simulations/humidity.h"
@@ -10,27 +11,25 @@
 #include "simulations/precipitation.h"
 #include "simulations/temperature.h"
 
-#include <queue>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <mutex>
 #include <random>
 
 #include <boost/log/trivial.hpp>
 #include <boost/random.hpp>
 
-#include <OpenSimplexNoise.h>
-
 namespace WorldEngine
 {
 
 typedef std::pair<uint32_t, uint32_t> CoordType;
 
-static void Around(std::vector<CoordType>& coordList,
-                   int32_t                 x,
-                   int32_t                 y,
-                   int32_t                 width,
-                   int32_t                 height);
-
 /**
- * @brief Fill the ocean from the borders of the map
+ * @brief Fill the ocean from the borders of the map. Cells at or below sea
+ * level are filled if they are connected to the border, including diagonally,
+ * through other cells at or below sea level. Cells already marked as ocean are
+ * kept, but the fill does not pass through them.
  * @param ocean Ocean data
  * @param elevation Elevation data
  * @param seaLevel The elevation representing the sea level
@@ -39,6 +38,28 @@ static void FillOcean(OceanArrayType&           ocean,
                       const ElevationArrayType& elevation,
                       float                     seaLevel);
 
+/**
+ * @brief Fill the ocean one horizontal span at a time
+ * @param ocean Ocean data, sized to match elevation
+ * @param elevation Elevation data
+ * @param seaLevel The elevation representing the sea level
+ */
+static void FillOceanScanline(OceanArrayType&           ocean,
+                              const ElevationArrayType& elevation,
+                              float                     seaLevel);
+
+/**
+ * @brief Fill the ocean by labeling connected cells in parallel strips of
+ * rows, merging the labels across strips, and filling the labels which touch
+ * the border. Produces the same result as FillOceanScanline.
+ * @param ocean Ocean data, sized to match elevation
+ * @param elevation Elevation data
+ * @param seaLevel The elevation representing the sea level
+ */
+static void FillOceanLabeling(OceanArrayType&           ocean,
+                              const ElevationArrayType& elevation,
+                              float                     seaLevel);
+
 /**
  * @brief Make the ocean floor less noisy. The underwater erosion should cause
  * the ocean floor to be more uniform.
@@ -51,33 +72,70 @@ static void HarmonizeOcean(const OceanArrayType& ocean,
                            float                 oceanLevel);
 
 /**
- * @brief A dynamic programming approach to gather how far the next land is from
- * a given coordinate up to a maximum distance of max_radius. Result is 0 for
- * land coordinates and -1 for coordinates further than max_radius away from
- * land.
- * @param ocean
- * @param maxRadius
+ * @brief A simulation stage, along with the layers it reads and writes, and
+ * the parameters its results depend on
+ */
+struct SimulationStage
+{
+   Simulation             simulation_;
+   std::vector<Layer>     inputs_;
+   std::vector<Layer>     outputs_;
+   std::vector<Parameter> parameters_;
+   std::function<void()>  execute_;
+};
+
+/**
+ * @brief Build the simulation stages of a generation step, in their serial
+ * order
+ * @param world World to simulate
+ * @param step Generation steps to perform
+ * @param seed Random seed value
+ * @param arena Scratch storage, which must outlive the stages
  */
-static boost::multi_array<int32_t, 2>
-NextLandDynamic(const OceanArrayType& ocean, int32_t maxRadius = 5);
+static std::vector<SimulationStage> SimulationStages(World&        world,
+                                                     const Step&   step,
+                                                     uint32_t      seed,
+                                                     ScratchArena& arena);
+
+/**
+ * @brief Simulate erosion, recording the cells it changes in the world's
+ * generation record
+ * @param world World to simulate
+ * @param mode River routing used by erosion
+ * @param arena Scratch storage
+ */
+static void ErosionStage(World& world, ErosionMode mode, ScratchArena& arena);
+
+/**
+ * @brief Run simulation stages, concurrently where their layers allow it.
+ * Each stage which runs assigns new versions to the layers it writes, and
+ * replaces its record in the world's generation record.
+ * @param world World to simulate
+ * @param stages Stages in their serial order
+ * @param run Whether to run each stage
+ */
+static void ExecuteStages(World&                              world,
+                          const std::vector<SimulationStage>& stages,
+                          const std::vector<bool>&            run);
 
 void AddNoiseToElevation(World& world, uint32_t seed)
 {
    uint32_t octaves = 8;
    double   freq    = 16.0 * octaves;
 
-   ElevationArrayType& elevation = world.GetElevationData();
+   LayerView<ElevationDataType> elevation = world.GetElevationView();
 
-   OpenSimplexNoise::Noise noise(seed);
+   NoiseGenerator noise(seed);
 
-   for (uint32_t y = 0; y < world.height(); y++)
-   {
-      for (uint32_t x = 0; x < world.width(); x++)
-      {
-         double n = Noise(noise, x / freq * 2.0, y / freq * 2.0, octaves);
-         elevation[y][x] += static_cast<float>(n);
-      }
-   }
+   NoiseField(noise,
+              world.width(),
+              world.height(),
+              2.0,
+              freq,
+              octaves,
+              false,
+              [&](int32_t x, int32_t y, double n)
+              { elevation[y][x] += static_cast<float>(n); });
 }
 
 void CenterLand(World& world)
@@ -149,62 +207,52 @@ void CenterLand(World& world)
    BOOST_LOG_TRIVIAL(debug) << "CenterLand(): Rotate complete";
 }
 
-void GenerateWorld(World& world, const Step& step, uint32_t seed)
+void GenerateWorld(World&        world,
+                   const Step&   step,
+                   uint32_t      seed,
+                   ScratchArena* scratch)
 {
-   if (!step.includePrecipitations_)
-   {
-      return;
-   }
-
-   std::mt19937                                      generator(seed);
-   boost::random::uniform_int_distribution<uint32_t> distribution(0,
-                                                                  UINT32_MAX);
-
-   // Seed map should be appended to to maximize compatibility between versions
-   std::unordered_map<Simulation, uint32_t> seedMap;
-   seedMap.insert({Simulation::Precipitation, distribution(generator)});
-   seedMap.insert({Simulation::Erosion, distribution(generator)});
-   seedMap.insert({Simulation::Watermap, distribution(generator)});
-   seedMap.insert({Simulation::Irrigation, distribution(generator)});
-   seedMap.insert({Simulation::Temperature, distribution(generator)});
-   seedMap.insert({Simulation::Humidity, distribution(generator)});
-   seedMap.insert({Simulation::Permeability, distribution(generator)});
-   seedMap.insert({Simulation::Biome, distribution(generator)});
-   seedMap.insert({Simulation::Icecap, distribution(generator)});
+   ScratchArena  localScratch;
+   ScratchArena& arena = (scratch != nullptr) ? *scratch : localScratch;
+   ScratchScope  scope(arena);
 
-   TemperatureSimulation(world, seedMap[Simulation::Temperature]);
-   PrecipitationSimulation(world, seedMap[Simulation::Precipitation]);
+   GenerationRecord& record = world.GetGenerationRecord();
+   record.step_             = step;
+   record.seed_             = seed;
+   record.simulations_.clear();
+   record.erosionChanges_.clear();
 
-   if (!step.includeErosion_)
+   if (!step.includePrecipitations_)
    {
       return;
    }
 
-   ErosionSimulation(world);
-   WatermapSimulation(world, seedMap[Simulation::Watermap]);
-   IrrigationSimulation(world);
-   HumiditySimulation(world);
-   PermeabilitySimulation(world, seedMap[Simulation::Permeability]);
-   BiomeSimulation(world);
-   IcecapSimulation(world, seedMap[Simulation::Icecap]);
+   std::vector<SimulationStage> stages =
+      SimulationStages(world, step, seed, arena);
+
+   ExecuteStages(world, stages, std::vector<bool>(stages.size(), true));
 }
 
-void InitializeOceanAndThresholds(World& world, float oceanLevel)
+void InitializeOceanAndThresholds(World&        world,
+                                  float         oceanLevel,
+                                  ScratchArena* scratch)
 {
    ElevationArrayType& e     = world.GetElevationData();
    OceanArrayType&     ocean = world.GetOceanData();
 
    FillOcean(ocean, e, oceanLevel);
 
-   float hl = FindThresholdF(e, 0.10f); // Highest 10% of land is hills
-   float ml = FindThresholdF(e, 0.03f); // Highest 3% of land is mountains
+   // Highest 10% of land is hills, highest 3% of land is mountains
+   std::vector<float> thresholds = FindThresholdsF(e, {0.10f, 0.03f});
+   float              hl         = thresholds[0];
+   float              ml         = thresholds[1];
    world.SetThreshold(ElevationThreshold::Sea, oceanLevel);
    world.SetThreshold(ElevationThreshold::Hill, hl);
    world.SetThreshold(ElevationThreshold::Mountain, ml);
 
    HarmonizeOcean(ocean, e, oceanLevel);
 
-   SeaDepth(world, oceanLevel);
+   SeaDepth(world, oceanLevel, scratch);
 }
 
 void PlaceOceansAtMapBorders(World& world)
@@ -237,27 +285,358 @@ void PlaceOceansAtMapBorders(World& world)
    }
 }
 
-static void Around(std::vector<CoordType>& coordList,
-                   int32_t                 x,
-                   int32_t                 y,
-                   int32_t                 width,
-                   int32_t                 height)
+void Regenerate(World&                        world,
+                const std::vector<Parameter>& changedParameters,
+                ScratchArena*                 scratch)
 {
-   for (int32_t dy = -1; dy <= 1; dy++)
+   ScratchArena  localScratch;
+   ScratchArena& arena = (scratch != nullptr) ? *scratch : localScratch;
+   ScratchScope  scope(arena);
+
+   GenerationRecord& record = world.GetGenerationRecord();
+
+   if (!record.step_.includePrecipitations_)
+   {
+      BOOST_LOG_TRIVIAL(warning) << "Regenerate(): No simulations to repeat";
+      return;
+   }
+
+   auto Contains = [](const auto& values, auto value)
    {
-      int32_t ny = y + dy;
-      if (0 <= ny && ny < height)
+      return std::find(values.cbegin(), values.cend(), value) != values.cend();
+   };
+
+   std::vector<SimulationStage> stages =
+      SimulationStages(world, record.step_, record.seed_, arena);
+
+   // Replay the recorded layer versions in serial order. A layer modified in
+   // place, and not edited since, starts at the version its stage consumed.
+   std::unordered_map<Layer, uint32_t> versions;
+   std::vector<Layer>                  restoredLayers;
+   for (Layer layer : LayerIterator())
+   {
+      versions[layer] = world.GetLayerVersion(layer);
+   }
+
+   for (auto stage = stages.crbegin(); stage != stages.crend(); ++stage)
+   {
+      auto it = record.simulations_.find(stage->simulation_);
+      if (it == record.simulations_.end())
       {
-         for (int32_t dx = -1; dx <= 1; dx++)
+         continue;
+      }
+
+      for (Layer layer : stage->outputs_)
+      {
+         if (Contains(stage->inputs_, layer) &&
+             versions[layer] == it->second.outputVersions_.at(layer))
          {
-            int32_t nx = x + dx;
-            if (0 <= nx && nx < width && (dx != 0 || dy != 0))
-            {
-               coordList.push_back(CoordType(nx, ny));
-            }
+            versions[layer] = it->second.inputVersions_.at(layer);
+            restoredLayers.push_back(layer);
          }
       }
    }
+
+   // A layer edited since generation keeps its version after the last stage
+   // writing it
+   std::unordered_map<Layer, size_t> lastWriters;
+   for (size_t i = 0; i < stages.size(); i++)
+   {
+      for (Layer layer : stages[i].outputs_)
+      {
+         lastWriters[layer] = i;
+      }
+   }
+
+   // A stage runs again if it consumes a changed parameter, or a layer which
+   // differs from the layer it consumed. Layers written by a stage which runs
+   // again differ from any recorded version.
+   static const uint32_t staleVersion = std::numeric_limits<uint32_t>::max();
+
+   std::vector<bool> run(stages.size(), false);
+
+   for (size_t i = 0; i < stages.size(); i++)
+   {
+      const SimulationStage& stage = stages[i];
+      auto it = record.simulations_.find(stage.simulation_);
+
+      run[i] = (it == record.simulations_.end());
+
+      for (Parameter parameter : stage.parameters_)
+      {
+         run[i] = run[i] || Contains(changedParameters, parameter);
+      }
+
+      for (Layer layer : stage.inputs_)
+      {
+         run[i] = run[i] ||
+                  versions[layer] != it->second.inputVersions_.at(layer);
+      }
+
+      for (Layer layer : stage.outputs_)
+      {
+         if (run[i])
+         {
+            versions[layer] = staleVersion;
+         }
+         else if (lastWriters.at(layer) == i)
+         {
+            versions[layer] = world.GetLayerVersion(layer);
+         }
+         else
+         {
+            versions[layer] = it->second.outputVersions_.at(layer);
+         }
+      }
+
+      BOOST_LOG_TRIVIAL(debug) << "Regenerate(): " << stage.simulation_ << " "
+                               << (run[i] ? "runs" : "is unchanged");
+   }
+
+   auto Runs = [&](Simulation simulation) -> bool
+   {
+      for (size_t i = 0; i < stages.size(); i++)
+      {
+         if (stages[i].simulation_ == simulation)
+         {
+            return run[i];
+         }
+      }
+      return false;
+   };
+
+   auto Present = [&](Simulation simulation)
+   {
+      return record.simulations_.find(simulation) != record.simulations_.end();
+   };
+
+   // Thresholds derived from parameters are recalculated without repeating
+   // the simulation of their layer
+   if (Contains(changedParameters, Parameter::Temps) &&
+       Present(Simulation::Temperature) && !Runs(Simulation::Temperature))
+   {
+      TemperatureThresholds(world);
+   }
+   if (Contains(changedParameters, Parameter::Humids) &&
+       Present(Simulation::Humidity) && !Runs(Simulation::Humidity))
+   {
+      HumidityThresholds(world);
+   }
+
+   // Erosion starts from the elevation it originally eroded, unless elevation
+   // was edited since, in which case the edited elevation is eroded
+   if (Runs(Simulation::Erosion) && Contains(restoredLayers, Layer::Elevation))
+   {
+      ElevationDataType* elevation = world.GetElevationData().data();
+
+      for (const auto& [index, value] : record.erosionChanges_)
+      {
+         elevation[index] = value;
+      }
+
+      world.SetLayerVersion(Layer::Elevation,
+                            record.simulations_.at(Simulation::Erosion)
+                               .inputVersions_.at(Layer::Elevation));
+   }
+
+   ExecuteStages(world, stages, run);
+}
+
+static std::vector<SimulationStage> SimulationStages(World&        world,
+                                                     const Step&   step,
+                                                     uint32_t      seed,
+                                                     ScratchArena& arena)
+{
+   std::mt19937                                      generator(seed);
+   boost::random::uniform_int_distribution<uint32_t> distribution(0,
+                                                                  UINT32_MAX);
+
+   // Seed map should be appended to to maximize compatibility between versions
+   std::unordered_map<Simulation, uint32_t> seedMap;
+   seedMap.insert({Simulation::Precipitation, distribution(generator)});
+   seedMap.insert({Simulation::Erosion, distribution(generator)});
+   seedMap.insert({Simulation::Watermap, distribution(generator)});
+   seedMap.insert({Simulation::Irrigation, distribution(generator)});
+   seedMap.insert({Simulation::Temperature, distribution(generator)});
+   seedMap.insert({Simulation::Humidity, distribution(generator)});
+   seedMap.insert({Simulation::Permeability, distribution(generator)});
+   seedMap.insert({Simulation::Biome, distribution(generator)});
+   seedMap.insert({Simulation::Icecap, distribution(generator)});
+
+   // Stages are listed in their serial order. Temperature and humidity
+   // thresholds are recalculated by Regenerate() directly, so their stages do
+   // not depend on the temps and humids parameters. Only erosion and biome
+   // allocate from the arena, each releasing its layers with a scope, and
+   // biome depends on erosion through humidity, so they never run
+   // concurrently.
+   std::vector<SimulationStage> stages;
+
+   stages.push_back({Simulation::Temperature,
+                     {Layer::Elevation, Layer::Ocean},
+                     {Layer::Temperature},
+                     {},
+                     [=, &world]() {
+                        TemperatureSimulation(
+                           world, seedMap.at(Simulation::Temperature));
+                     }});
+   stages.push_back({Simulation::Precipitation,
+                     {Layer::Ocean, Layer::Temperature},
+                     {Layer::Precipitation},
+                     {Parameter::GammaCurve, Parameter::CurveOffset},
+                     [=, &world]() {
+                        PrecipitationSimulation(
+                           world,
+                           seedMap.at(Simulation::Precipitation),
+                           step.gammaMode_);
+                     }});
+
+   if (step.includeErosion_)
+   {
+      stages.push_back(
+         {Simulation::Erosion,
+          {Layer::Elevation, Layer::Ocean, Layer::Precipitation},
+          {Layer::Elevation, Layer::RiverMap, Layer::LakeMap},
+          {},
+          [=, &world, &arena]()
+          { ErosionStage(world, step.erosionMode_, arena); }});
+      stages.push_back(
+         {Simulation::Watermap,
+          {Layer::Elevation, Layer::Ocean, Layer::Precipitation},
+          {Layer::WaterMap},
+          {},
+          [=, &world]() {
+             WatermapSimulation(world,
+                                seedMap.at(Simulation::Watermap),
+                                step.watermapMode_,
+                                step.randomMode_);
+          }});
+      stages.push_back({Simulation::Irrigation,
+                        {Layer::Ocean, Layer::WaterMap},
+                        {Layer::Irrigation},
+                        {},
+                        [&world]() { IrrigationSimulation(world); }});
+      stages.push_back(
+         {Simulation::Humidity,
+          {Layer::Ocean, Layer::Precipitation, Layer::Irrigation},
+          {Layer::Humidity},
+          {},
+          [&world]() { HumiditySimulation(world); }});
+      stages.push_back({Simulation::Permeability,
+                        {Layer::Ocean},
+                        {Layer::Permeability},
+                        {},
+                        [=, &world]() {
+                           PermeabilitySimulation(
+                              world,
+                              seedMap.at(Simulation::Permeability),
+                              step.randomMode_);
+                        }});
+      stages.push_back({Simulation::Biome,
+                        {Layer::Ocean,
+                         Layer::Temperature,
+                         Layer::Precipitation,
+                         Layer::Humidity},
+                        {Layer::Biome},
+                        {Parameter::Temps, Parameter::Humids},
+                        [&world, &arena]()
+                        { BiomeSimulation(world, &arena); }});
+      stages.push_back({Simulation::Icecap,
+                        {Layer::Ocean, Layer::Temperature},
+                        {Layer::Icecap},
+                        {Parameter::Temps},
+                        [=, &world]() {
+                           IcecapSimulation(world,
+                                            seedMap.at(Simulation::Icecap),
+                                            step.randomMode_);
+                        }});
+   }
+
+   return stages;
+}
+
+static void ErosionStage(World& world, ErosionMode mode, ScratchArena& arena)
+{
+   ScratchScope scope(arena);
+
+   const ElevationArrayType&    elevation = world.GetElevationData();
+   LayerView<ElevationDataType> before =
+      arena.AllocateLayer<ElevationDataType>(world.width(), world.height());
+
+   std::copy(elevation.data(),
+             elevation.data() + elevation.num_elements(),
+             before.data());
+
+   ErosionSimulation(world, &arena, mode);
+
+   // No other stage accesses the changes, so they are recorded without locking
+   std::vector<std::pair<size_t, ElevationDataType>>& changes =
+      world.GetGenerationRecord().erosionChanges_;
+   changes.clear();
+
+   for (size_t i = 0; i < before.size(); i++)
+   {
+      if (elevation.data()[i] != before.data()[i])
+      {
+         changes.push_back({i, before.data()[i]});
+      }
+   }
+
+   BOOST_LOG_TRIVIAL(debug) << "Erosion changed " << changes.size() << " of "
+                            << before.size() << " cells";
+}
+
+static void ExecuteStages(World&                              world,
+                          const std::vector<SimulationStage>& stages,
+                          const std::vector<bool>&            run)
+{
+   GenerationRecord& record = world.GetGenerationRecord();
+   std::mutex        recordMutex;
+
+   // Stages run concurrently where the layers they read and write do not
+   // overlap
+   SimulationScheduler scheduler;
+
+   for (size_t i = 0; i < stages.size(); i++)
+   {
+      if (!run[i])
+      {
+         continue;
+      }
+
+      const SimulationStage& stage = stages[i];
+
+      scheduler.Add(
+         stage.simulation_,
+         stage.inputs_,
+         stage.outputs_,
+         [&world, &record, &recordMutex, &stage]()
+         {
+            // The scheduler prevents layers from being written while they are
+            // read, so their versions may be read without locking
+            SimulationRecord simulationRecord;
+
+            for (Layer layer : stage.inputs_)
+            {
+               simulationRecord.inputVersions_[layer] =
+                  world.GetLayerVersion(layer);
+            }
+
+            stage.execute_();
+
+            std::scoped_lock lock(recordMutex);
+
+            for (Layer layer : stage.outputs_)
+            {
+               world.SetLayerVersion(layer, ++record.lastVersion_);
+               simulationRecord.outputVersions_[layer] = record.lastVersion_;
+            }
+
+            record.simulations_[stage.simulation_] =
+               std::move(simulationRecord);
+         });
+   }
+
+   scheduler.Execute();
 }
 
 static void FillOcean(OceanArrayType&           ocean,
@@ -269,59 +648,247 @@ static void FillOcean(OceanArrayType&           ocean,
 
    ocean.resize(boost::extents[height][width]);
 
-   std::queue<CoordType> toExpand;
+   if (NumThreads() > 1u && height > 1u)
+   {
+      FillOceanLabeling(ocean, elevation, seaLevel);
+   }
+   else
+   {
+      FillOceanScanline(ocean, elevation, seaLevel);
+   }
+}
+
+static void FillOceanScanline(OceanArrayType&           ocean,
+                              const ElevationArrayType& elevation,
+                              float                     seaLevel)
+{
+   const int32_t height = static_cast<int32_t>(elevation.shape()[0]);
+   const int32_t width  = static_cast<int32_t>(elevation.shape()[1]);
+
+   auto Fillable = [&](int32_t x, int32_t y)
+   { return !ocean[y][x] && elevation[y][x] <= seaLevel; };
+
+   // Cells from which to fill a span
+   std::vector<CoordType> seeds;
 
    // Handle top and bottom border of the map
-   for (uint32_t x = 0; x < width; x++)
+   for (int32_t x = 0; x < width; x++)
+   {
+      seeds.push_back(CoordType(x, 0));
+      seeds.push_back(CoordType(x, height - 1));
+   }
+
+   // Handle left- and rightmost border of the map
+   for (int32_t y = 0; y < height; y++)
    {
-      if (elevation[0][x] <= seaLevel)
+      seeds.push_back(CoordType(0, y));
+      seeds.push_back(CoordType(width - 1, y));
+   }
+
+   while (!seeds.empty())
+   {
+      const int32_t sx = static_cast<int32_t>(seeds.back().first);
+      const int32_t sy = static_cast<int32_t>(seeds.back().second);
+      seeds.pop_back();
+
+      if (!Fillable(sx, sy))
       {
-         toExpand.push(CoordType(x, 0));
+         continue;
       }
-      if (elevation[height - 1][x] <= seaLevel)
+
+      // Extend the span left and right from the seed
+      int32_t x0 = sx;
+      int32_t x1 = sx;
+      while (x0 > 0 && Fillable(x0 - 1, sy))
       {
-         toExpand.push(CoordType(x, height - 1));
+         x0--;
+      }
+      while (x1 < width - 1 && Fillable(x1 + 1, sy))
+      {
+         x1++;
       }
-   }
 
-   // Handle left- and rightmost border of the map
-   for (uint32_t y = 0; y < height; y++)
-   {
-      if (elevation[y][0] <= seaLevel)
+      for (int32_t x = x0; x <= x1; x++)
       {
-         toExpand.push(CoordType(0, y));
+         ocean[sy][x] = true;
       }
-      if (elevation[y][width - 1] <= seaLevel)
+
+      // Seed each run of fillable cells above and below the span, including
+      // the cells diagonal to its ends
+      for (int32_t ny = sy - 1; ny <= sy + 1; ny += 2)
       {
-         toExpand.push(CoordType(width - 1, y));
+         if (ny < 0 || ny >= height)
+         {
+            continue;
+         }
+
+         bool inRun = false;
+         for (int32_t x = std::max(x0 - 1, 0); x <= std::min(x1 + 1, width - 1);
+              x++)
+         {
+            if (!Fillable(x, ny))
+            {
+               inRun = false;
+            }
+            else if (!inRun)
+            {
+               seeds.push_back(CoordType(x, ny));
+               inRun = true;
+            }
+         }
       }
    }
+}
+
+static void FillOceanLabeling(OceanArrayType&           ocean,
+                              const ElevationArrayType& elevation,
+                              float                     seaLevel)
+{
+   static const uint32_t noLabel = UINT32_MAX;
 
-   while (toExpand.size() > 0)
+   const uint32_t height = static_cast<uint32_t>(elevation.shape()[0]);
+   const uint32_t width  = static_cast<uint32_t>(elevation.shape()[1]);
+
+   // Fillable cells connected to each other, as a disjoint set forest. Each
+   // set is represented by its lowest index, so sets within a strip of rows
+   // are represented by a cell of the strip.
+   std::vector<uint32_t> label(static_cast<size_t>(width) * height, noLabel);
+
+   auto Find = [&](uint32_t index)
    {
-      const CoordType& coord = toExpand.front();
-      uint32_t         x     = coord.first;
-      uint32_t         y     = coord.second;
-      toExpand.pop();
+      while (label[index] != index)
+      {
+         label[index] = label[label[index]];
+         index        = label[index];
+      }
+      return index;
+   };
 
-      if (!ocean[y][x])
+   auto Union = [&](uint32_t a, uint32_t b)
+   {
+      a = Find(a);
+      b = Find(b);
+      if (a < b)
+      {
+         label[b] = a;
+      }
+      else
       {
-         std::vector<CoordType> around;
-         ocean[y][x] = true;
+         label[a] = b;
+      }
+   };
+
+   // Join a cell to the fillable cells in the row above it
+   auto UnionAbove = [&](uint32_t x, uint32_t y)
+   {
+      uint32_t index = y * width + x;
+      for (uint32_t nx = (x > 0u) ? x - 1u : 0u;
+           nx <= std::min(x + 1u, width - 1u);
+           nx++)
+      {
+         uint32_t above = (y - 1u) * width + nx;
+         if (label[above] != noLabel)
+         {
+            Union(index, above);
+         }
+      }
+   };
 
-         Around(around, x, y, width, height);
+   const uint32_t numStrips    = std::min(NumThreads(), height);
+   const uint32_t rowsPerStrip = (height + numStrips - 1u) / numStrips;
 
-         for (const CoordType& p : around)
+   // Label each strip independently
+   ParallelFor(0u,
+               numStrips,
+               [&](uint32_t strip)
+               {
+                  const uint32_t y0 = strip * rowsPerStrip;
+                  const uint32_t y1 = std::min(y0 + rowsPerStrip, height);
+
+                  for (uint32_t y = y0; y < y1; y++)
+                  {
+                     for (uint32_t x = 0; x < width; x++)
+                     {
+                        if (ocean[y][x] || elevation[y][x] > seaLevel)
+                        {
+                           continue;
+                        }
+
+                        uint32_t index = y * width + x;
+                        label[index]   = index;
+
+                        if (x > 0u && label[index - 1u] != noLabel)
+                        {
+                           Union(index, index - 1u);
+                        }
+                        if (y > y0)
+                        {
+                           UnionAbove(x, y);
+                        }
+                     }
+                  }
+               });
+
+   // Merge labels across the first row of each strip
+   for (uint32_t y = rowsPerStrip; y < height; y += rowsPerStrip)
+   {
+      for (uint32_t x = 0; x < width; x++)
+      {
+         if (label[y * width + x] != noLabel)
          {
-            int px = p.first;
-            int py = p.second;
-            if (!ocean[py][px] && elevation[py][px] <= seaLevel)
-            {
-               toExpand.push(p);
-            }
+            UnionAbove(x, y);
          }
       }
    }
+
+   // Mark the sets which touch the border of the map
+   std::vector<bool> border(label.size(), false);
+
+   auto MarkBorder = [&](uint32_t x, uint32_t y)
+   {
+      uint32_t index = y * width + x;
+      if (label[index] != noLabel)
+      {
+         border[Find(index)] = true;
+      }
+   };
+
+   for (uint32_t x = 0; x < width; x++)
+   {
+      MarkBorder(x, 0);
+      MarkBorder(x, height - 1);
+   }
+   for (uint32_t y = 0; y < height; y++)
+   {
+      MarkBorder(0, y);
+      MarkBorder(width - 1, y);
+   }
+
+   // Fill the marked sets. Sets are only read, so rows can be filled in
+   // parallel.
+   ParallelFor(0u,
+               height,
+               [&](uint32_t y)
+               {
+                  for (uint32_t x = 0; x < width; x++)
+                  {
+                     uint32_t index = y * width + x;
+                     if (label[index] == noLabel)
+                     {
+                        continue;
+                     }
+
+                     while (label[index] != index)
+                     {
+                        index = label[index];
+                     }
+
+                     if (border[index])
+                     {
+                        ocean[y][x] = true;
+                     }
+                  }
+               });
 }
 
 static void HarmonizeOcean(const OceanArrayType& ocean,
@@ -355,71 +922,34 @@ static void HarmonizeOcean(const OceanArrayType& ocean,
    }
 }
 
-static boost::multi_array<int32_t, 2>
-NextLandDynamic(const OceanArrayType& ocean, int32_t maxRadius)
-{
-   const int32_t width  = static_cast<int32_t>(ocean.shape()[1]);
-   const int32_t height = static_cast<int32_t>(ocean.shape()[0]);
-
-   boost::multi_array<int32_t, 2> nextLand(boost::extents[height][width]);
-
-   std::transform(ocean.data(),
-                  ocean.data() + ocean.num_elements(),
-                  nextLand.data(),
-                  [](const bool& ocean) -> int32_t {
-                     // Non-ocean tiles are zero distance away from next land
-                     return (ocean) ? -1 : 0;
-                  });
-
-   for (int32_t distance = 0; distance < maxRadius; distance++)
-   {
-      for (int32_t y = 0; y < height; y++)
-      {
-         for (int32_t x = 0; x < width; x++)
-         {
-            if (nextLand[y][x] != distance)
-            {
-               continue;
-            }
-
-            for (int32_t dy = -1; dy <= 1; dy++)
-            {
-               int32_t ny = y + dy;
-               if (0 <= ny && ny < height)
-               {
-                  for (int32_t dx = -1; dx <= 1; dx++)
-                  {
-                     int32_t nx = x + dx;
-                     if (0 <= nx && nx < width)
-                     {
-                        if (nextLand[ny][nx] == -1)
-                        {
-                           nextLand[ny][nx] = distance + 1;
-                        }
-                     }
-                  }
-               }
-            }
-         }
-      }
-   }
-
-   return nextLand;
-}
-
-void SeaDepth(World& world, float seaLevel)
+void SeaDepth(World& world, float seaLevel, ScratchArena* scratch)
 {
    // We want to multiply the raw sea depth by one of these factors depending on
    // the distance from the next land
    const std::vector<float> factors({0.0f, 0.3f, 0.5f, 0.7f, 0.9f});
+   const float              maxRadius = static_cast<float>(factors.size());
 
    const ElevationArrayType& elevation = world.GetElevationData();
    SeaDepthArrayType&        seaDepth  = world.GetSeaDepthData();
 
    seaDepth.resize(boost::extents[world.height()][world.width()]);
 
-   boost::multi_array<int32_t, 2> nextLand =
-      NextLandDynamic(world.GetOceanData());
+   ScratchArena  localScratch;
+   ScratchArena& arena = (scratch != nullptr) ? *scratch : localScratch;
+   ScratchScope  scope(arena);
+
+   // Distance to the next land, counting diagonal steps as one
+   const OceanArrayType& ocean = world.GetOceanData();
+   LayerView<bool>  land =
+      arena.AllocateLayer<bool>(world.width(), world.height());
+   LayerView<float> nextLand =
+      arena.AllocateLayer<float>(world.width(), world.height());
+
+   std::transform(ocean.data(),
+                  ocean.data() + ocean.num_elements(),
+                  land.data(),
+                  [](const bool& isOcean) -> bool { return !isOcean; });
+   DistanceTransform(land, nextLand, DistanceMetric::Chebyshev);
 
    for (uint32_t y = 0; y < world.height(); y++)
    {
@@ -427,10 +957,10 @@ void SeaDepth(World& world, float seaLevel)
       {
          seaDepth[y][x] = seaLevel - elevation[y][x];
 
-         int32_t distToNextLand = nextLand[y][x];
-         if (distToNextLand > 0)
+         float distToNextLand = nextLand[y][x];
+         if (distToNextLand > 0.0f && distToNextLand <= maxRadius)
          {
-            seaDepth[y][x] *= factors[distToNextLand - 1];
+            seaDepth[y][x] *= factors[static_cast<size_t>(distToNextLand) - 1];
          }
       }
    }
@@ -109,21 +109,23 @@ static void ScaleArray(const boost::multi_array<T, 2>& input,
                        boost::multi_array<T, 2>&       output,
                        uint32_t                        scale);
 
-AncientMapImage::AncientMapImage(const World& world,
-                                 uint32_t     seed,
-                                 uint32_t     scale,
-                                 SeaColor     seaColor,
-                                 bool         drawBiome,
-                                 bool         drawRivers,
-                                 bool         drawMountains,
-                                 bool         drawOuterLandBorder) :
+AncientMapImage::AncientMapImage(const World&  world,
+                                 uint32_t      seed,
+                                 uint32_t      scale,
+                                 SeaColor      seaColor,
+                                 bool          drawBiome,
+                                 bool          drawRivers,
+                                 bool          drawMountains,
+                                 bool          drawOuterLandBorder,
+                                 ScratchArena* scratch) :
     Image(world, scale),
     seed_(seed),
     seaColor_(seaColor),
     drawBiome_(drawBiome),
     drawRivers_(drawRivers),
     drawMountains_(drawMountains),
-    drawOuterLandBorder_(drawOuterLandBorder)
+    drawOuterLandBorder_(drawOuterLandBorder),
+    scratch_(scratch)
 {
 }
 
@@ -146,7 +148,8 @@ void AncientMapImage::DrawImage(boost::gil::rgb8_image_t::view_t& target)
 
    OceanArrayType scaledOcean;
    ScaleArray(world_.GetOceanData(), scaledOcean, scale_);
-   boost::multi_array<uint32_t, 2> neighbors = CountNeighbors(scaledOcean);
+   boost::multi_array<uint32_t, 2> neighbors =
+      CountNeighbors(scaledOcean, 1, scratch_);
 
    boost::multi_array<bool, 2> borders(boost::extents[sHeight][sWidth]);
    std::transform(scaledOcean.data(),
@@ -161,8 +164,8 @@ void AncientMapImage::DrawImage(boost::gil::rgb8_image_t::view_t& target)
    std::unordered_map<int32_t, boost::multi_array<int32_t, 2>> borderNeighbors;
    borderNeighbors[6].resize(boost::extents[sHeight][sWidth]);
    borderNeighbors[9].resize(boost::extents[sHeight][sWidth]);
-   borderNeighbors[6] = CountNeighbors(borders, 6);
-   borderNeighbors[9] = CountNeighbors(borders, 9);
+   borderNeighbors[6] = CountNeighbors(borders, 6, scratch_);
+   borderNeighbors[9] = CountNeighbors(borders, 9, scratch_);
 
    boost::multi_array<bool, 2> outerBorders;
    if (drawOuterLandBorder_)
@@ -170,11 +173,11 @@ void AncientMapImage::DrawImage(boost::gil::rgb8_image_t::view_t& target)
       outerBorders.resize(boost::extents[sHeight][sWidth]);
 
       auto GenerateOuterBorders =
-         [&sWidth, &sHeight, &scaledOcean = std::as_const(scaledOcean)](
+         [this, &sWidth, &sHeight, &scaledOcean = std::as_const(scaledOcean)](
             const boost::multi_array<bool, 2>& innerBorders,
             boost::multi_array<bool, 2>&       outerBorders) {
             boost::multi_array<uint32_t, 2> neighbors =
-               CountNeighbors(innerBorders);
+               CountNeighbors(innerBorders, 1, scratch_);
 
             for (int32_t y = 0; y < sHeight; y++)
             {
@@ -15,50 +15,33 @@ void PrecipitationImage::DrawImage(boost::gil::gray8_image_t::view_t& target)
 
 void PrecipitationImage::DrawImage(boost::gil::rgb8_image_t::view_t& target)
 {
+   // Color of each humidity level
+   static const boost::gil::rgb8_pixel_t colors[] = {{0, 32, 32},
+                                                     {0, 64, 64},
+                                                     {0, 96, 96},
+                                                     {0, 128, 128},
+                                                     {0, 160, 160},
+                                                     {0, 192, 192},
+                                                     {0, 224, 224},
+                                                     {0, 255, 255}};
+
    if (!world_.HasHumidity())
    {
       return;
    }
 
-   for (uint32_t y = 0; y < world_.height(); y++)
-   {
-      for (uint32_t x = 0; x < world_.width(); x++)
-      {
-         switch (world_.GetHumidityLevel(x, y))
-         {
-         case HumidityLevel::Superarid:
-            target(x, y) = boost::gil::rgb8_pixel_t(0, 32, 32);
-            break;
-
-         case HumidityLevel::Perarid:
-            target(x, y) = boost::gil::rgb8_pixel_t(0, 64, 64);
-            break;
-
-         case HumidityLevel::Arid:
-            target(x, y) = boost::gil::rgb8_pixel_t(0, 96, 96);
-            break;
+   const uint32_t       width  = world_.width();
+   const uint32_t       height = world_.height();
+   std::vector<uint8_t> levels(static_cast<size_t>(width) * height);
 
-         case HumidityLevel::Semiarid:
-            target(x, y) = boost::gil::rgb8_pixel_t(0, 128, 128);
-            break;
+   LayerView<uint8_t> levelView(levels.data(), width, height, width);
+   world_.GetHumidityLevels(levelView);
 
-         case HumidityLevel::Subhumid:
-            target(x, y) = boost::gil::rgb8_pixel_t(0, 160, 160);
-            break;
-
-         case HumidityLevel::Humid:
-            target(x, y) = boost::gil::rgb8_pixel_t(0, 192, 192);
-            break;
-
-         case HumidityLevel::Perhumid:
-            target(x, y) = boost::gil::rgb8_pixel_t(0, 224, 224);
-            break;
-
-         case HumidityLevel::Superhumid:
-         default: //
-            target(x, y) = boost::gil::rgb8_pixel_t(0, 255, 255);
-            break;
-         }
+   for (uint32_t y = 0; y < height; y++)
+   {
+      for (uint32_t x = 0; x < width; x++)
+      {
+         target(x, y) = colors[levelView[y][x]];
       }
    }
 }
@@ -1,5 +1,7 @@
 #include "worldengine/images/scatter_plot_image.h"
 
+#include <vector>
+
 #include <boost/log/trivial.hpp>
 
 namespace WorldEngine
@@ -155,11 +157,30 @@ void ScatterPlotImage::DrawImage(boost::gil::rgb8_image_t::view_t& target)
       target(x, (size_ - 1) - y) = boost::gil::rgb8_pixel_t(255, 0, 0);
    }
 
+   // Red value for each temperature level
+   static const uint8_t temperatureColors[] = {0, 42, 85, 128, 170, 213, 255};
+
+   // Blue value for each humidity level
+   static const uint8_t humidityColors[] = {
+      32, 64, 96, 128, 160, 192, 224, 255};
+
+   const uint32_t       width    = world_.width();
+   const uint32_t       height   = world_.height();
+   const size_t         numCells = static_cast<size_t>(width) * height;
+   std::vector<uint8_t> levels(2u * numCells);
+
+   LayerView<uint8_t> temperatureLevels(levels.data(), width, height, width);
+   LayerView<uint8_t> humidityLevels(
+      levels.data() + numCells, width, height, width);
+
+   world_.GetTemperatureLevels(temperatureLevels);
+   world_.GetHumidityLevels(humidityLevels);
+
    // Examine all cells in the map and if it is land get the temperature and
    // humidity for the cell.
-   for (uint32_t y = 0; y < world_.height(); y++)
+   for (uint32_t y = 0; y < height; y++)
    {
-      for (uint32_t x = 0; x < world_.width(); x++)
+      for (uint32_t x = 0; x < width; x++)
       {
          if (world_.IsLand(x, y))
          {
@@ -167,76 +188,8 @@ void ScatterPlotImage::DrawImage(boost::gil::rgb8_image_t::view_t& target)
             float p = humidity[y][x];
 
             // Get red and blue values depending on temperature and humidity
-            uint8_t r = 0;
-            uint8_t b = 0;
-
-            switch (world_.GetTemperatureLevel(x, y))
-            {
-            case TemperatureLevel::Polar:
-               r = 0; //
-               break;
-
-            case TemperatureLevel::Alpine:
-               r = 42; //
-               break;
-
-            case TemperatureLevel::Boreal:
-               r = 85; //
-               break;
-
-            case TemperatureLevel::Cool:
-               r = 128; //
-               break;
-
-            case TemperatureLevel::Warm:
-               r = 170; //
-               break;
-
-            case TemperatureLevel::Subtropical:
-               r = 213; //
-               break;
-
-            case TemperatureLevel::Tropical:
-            default:
-               r = 255; //
-               break;
-            }
-
-            switch (world_.GetHumidityLevel(x, y))
-            {
-            case HumidityLevel::Superarid:
-               b = 32; //
-               break;
-
-            case HumidityLevel::Perarid:
-               b = 64; //
-               break;
-
-            case HumidityLevel::Arid:
-               b = 96; //
-               break;
-
-            case HumidityLevel::Semiarid:
-               b = 128; //
-               break;
-
-            case HumidityLevel::Subhumid:
-               b = 160; //
-               break;
-
-            case HumidityLevel::Humid:
-               b = 192; //
-               break;
-
-            case HumidityLevel::Perhumid:
-               b = 224; //
-               break;
-
-            case HumidityLevel::Superhumid:
-            default:
-               b = 255; //
-               break;
-            }
+            uint8_t r = temperatureColors[temperatureLevels[y][x]];
+            uint8_t b = humidityColors[humidityLevels[y][x]];
 
             // Calculate x and y position based on normalized temperature and
             // humidity
@@ -16,41 +16,27 @@ void TemperatureImage::DrawImage(boost::gil::gray8_image_t::view_t& target)
 
 void TemperatureImage::DrawImage(boost::gil::rgb8_image_t::view_t& target)
 {
-   for (uint32_t y = 0; y < world_.height(); y++)
+   // Color of each temperature level
+   static const boost::gil::rgb8_pixel_t colors[] = {{0, 0, 255},
+                                                     {42, 0, 213},
+                                                     {85, 0, 170},
+                                                     {128, 0, 128},
+                                                     {170, 0, 85},
+                                                     {213, 0, 42},
+                                                     {255, 0, 0}};
+
+   const uint32_t       width  = world_.width();
+   const uint32_t       height = world_.height();
+   std::vector<uint8_t> levels(static_cast<size_t>(width) * height);
+
+   LayerView<uint8_t> levelView(levels.data(), width, height, width);
+   world_.GetTemperatureLevels(levelView);
+
+   for (uint32_t y = 0; y < height; y++)
    {
-      for (uint32_t x = 0; x < world_.width(); x++)
+      for (uint32_t x = 0; x < width; x++)
       {
-         switch (world_.GetTemperatureLevel(x, y))
-         {
-         case TemperatureLevel::Polar:
-            target(x, y) = boost::gil::rgb8_pixel_t(0, 0, 255);
-            break;
-
-         case TemperatureLevel::Alpine:
-            target(x, y) = boost::gil::rgb8_pixel_t(42, 0, 213);
-            break;
-
-         case TemperatureLevel::Boreal:
-            target(x, y) = boost::gil::rgb8_pixel_t(85, 0, 170);
-            break;
-
-         case TemperatureLevel::Cool:
-            target(x, y) = boost::gil::rgb8_pixel_t(128, 0, 128);
-            break;
-
-         case TemperatureLevel::Warm:
-            target(x, y) = boost::gil::rgb8_pixel_t(170, 0, 85);
-            break;
-
-         case TemperatureLevel::Subtropical:
-            target(x, y) = boost::gil::rgb8_pixel_t(213, 0, 42);
-            break;
-
-         case TemperatureLevel::Tropical:
-         default: //
-            target(x, y) = boost::gil::rgb8_pixel_t(255, 0, 0);
-            break;
-         }
+         target(x, y) = colors[levelView[y][x]];
       }
    }
 }
@@ -0,0 +1,304 @@
+#include "noise.h"
+#include "basic.h"
+
+#include <cmath>
+#include <vector>
+
+#include <boost/log/trivial.hpp>
+
+#include <OpenSimplexNoise.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+   (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WORLDENGINE_NOISE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace WorldEngine
+{
+
+static const double GRADIENTS_2D[16] = {
+   5, 2, 2, 5, -5, 2, -2, 5, 5, -2, 2, -5, -5, -2, -2, -5};
+
+namespace
+{
+
+/**
+ * @brief Single point policy, using the same operations as the vector policies
+ * with masks represented as 0 or 1
+ */
+struct ScalarPolicy
+{
+   typedef double D;
+
+   static constexpr size_t WIDTH = 1u;
+
+   static D    Load(const double* p) { return *p; }
+   static void Store(double* p, D v) { *p = v; }
+   static D    Set(double v) { return v; }
+   static D    Add(D a, D b) { return a + b; }
+   static D    Sub(D a, D b) { return a - b; }
+   static D    Mul(D a, D b) { return a * b; }
+   static D    Div(D a, D b) { return a / b; }
+   static D    Gt(D a, D b) { return (a > b) ? 1.0 : 0.0; }
+   static D    Le(D a, D b) { return (a <= b) ? 1.0 : 0.0; }
+   static D    Or(D a, D b) { return (a > 0.0 || b > 0.0) ? 1.0 : 0.0; }
+   static D    Select(D mask, D a, D b) { return (mask > 0.0) ? a : b; }
+
+   static D Floor(D v) { return std::floor(v); }
+
+   static D Extrapolate(const NoiseTables& t, D xsb, D ysb, D dx, D dy)
+   {
+      // Only the low 8 bits of the lattice coordinates are used, so they are
+      // reduced before conversion to remain in range for large coordinates
+      int32_t xi    = static_cast<int32_t>(std::fmod(xsb, 256.0));
+      int32_t yi    = static_cast<int32_t>(std::fmod(ysb, 256.0));
+      int32_t index = t.perm_[(t.perm_[xi & 0xff] + yi) & 0xff] & 0x0e;
+      return t.gradientsX_[index] * dx + t.gradientsY_[index] * dy;
+   }
+};
+
+#if defined(WORLDENGINE_NOISE_SSE2)
+/**
+ * @brief Two point policy using SSE2. SSE2 has no gather instruction, so
+ * gradient lookups are performed per lane.
+ */
+struct Sse2Policy
+{
+   typedef __m128d D;
+
+   static constexpr size_t WIDTH = 2u;
+
+   static D    Load(const double* p) { return _mm_loadu_pd(p); }
+   static void Store(double* p, D v) { _mm_storeu_pd(p, v); }
+   static D    Set(double v) { return _mm_set1_pd(v); }
+   static D    Add(D a, D b) { return _mm_add_pd(a, b); }
+   static D    Sub(D a, D b) { return _mm_sub_pd(a, b); }
+   static D    Mul(D a, D b) { return _mm_mul_pd(a, b); }
+   static D    Div(D a, D b) { return _mm_div_pd(a, b); }
+   static D    Gt(D a, D b) { return _mm_cmpgt_pd(a, b); }
+   static D    Le(D a, D b) { return _mm_cmple_pd(a, b); }
+   static D    Or(D a, D b) { return _mm_or_pd(a, b); }
+
+   static D Select(D mask, D a, D b)
+   {
+      return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+   }
+
+   static D Floor(D v)
+   {
+      // Adding and subtracting 2^52 rounds to an integer. Larger magnitudes
+      // are already integers.
+      const D signMask = Set(-0.0);
+      const D limit    = Set(4503599627370496.0);
+      const D magic    = _mm_or_pd(_mm_and_pd(v, signMask), limit);
+
+      D rounded = _mm_sub_pd(_mm_add_pd(v, magic), magic);
+      rounded   = _mm_sub_pd(rounded,
+                           _mm_and_pd(_mm_cmpgt_pd(rounded, v), Set(1.0)));
+
+      return Select(_mm_cmpge_pd(_mm_andnot_pd(signMask, v), limit),
+                    v,
+                    rounded);
+   }
+
+   static D Extrapolate(const NoiseTables& t, D xsb, D ysb, D dx, D dy)
+   {
+      alignas(16) int32_t xi[4];
+      alignas(16) int32_t yi[4];
+      alignas(16) double  gx[2];
+      alignas(16) double  gy[2];
+
+      // Only the low 8 bits of the lattice coordinates are used, so they are
+      // reduced before conversion to remain in range for large coordinates
+      const D wrap        = Set(256.0);
+      const D inverseWrap = Set(1.0 / 256.0);
+      xsb = Sub(xsb, Mul(Floor(Mul(xsb, inverseWrap)), wrap));
+      ysb = Sub(ysb, Mul(Floor(Mul(ysb, inverseWrap)), wrap));
+
+      _mm_store_si128(reinterpret_cast<__m128i*>(xi), _mm_cvttpd_epi32(xsb));
+      _mm_store_si128(reinterpret_cast<__m128i*>(yi), _mm_cvttpd_epi32(ysb));
+
+      for (size_t i = 0; i < WIDTH; i++)
+      {
+         int32_t index = t.perm_[(t.perm_[xi[i] & 0xff] + yi[i]) & 0xff] & 0x0e;
+         gx[i]         = t.gradientsX_[index];
+         gy[i]         = t.gradientsY_[index];
+      }
+
+      return Add(Mul(_mm_load_pd(gx), dx), Mul(_mm_load_pd(gy), dy));
+   }
+};
+#endif
+
+} // namespace
+
+/**
+ * @brief Build the permutation table for a seed, following the OpenSimplex
+ * reference implementation
+ */
+static void InitializeTables(NoiseTables& tables, int64_t seed);
+
+/**
+ * @brief Check the batched kernel against the OpenSimplex library
+ * @return Number of points, out of a fixed set, whose results differ
+ */
+static size_t ValidationMismatches(const NoiseGenerator& generator);
+
+NoiseGenerator::NoiseGenerator(int64_t seed) :
+    noise_(std::make_unique<OpenSimplexNoise::Noise>(seed)),
+    tables_(),
+    instructionSet_(NoiseInstructionSet::Scalar)
+{
+   InitializeTables(tables_, seed);
+
+#if defined(WORLDENGINE_NOISE_SSE2)
+   instructionSet_ = NoiseInstructionSet::SSE2;
+#endif
+   if (NoiseAvx2Supported())
+   {
+      instructionSet_ = NoiseInstructionSet::AVX2;
+   }
+
+   size_t mismatches = ValidationMismatches(*this);
+   if (mismatches > 0u)
+   {
+      BOOST_LOG_TRIVIAL(warning)
+         << "Batched noise differs from OpenSimplex library at " << mismatches
+         << " points, using reference implementation";
+      instructionSet_ = NoiseInstructionSet::Reference;
+   }
+}
+
+NoiseGenerator::~NoiseGenerator() = default;
+
+const OpenSimplexNoise::Noise& NoiseGenerator::noise() const
+{
+   return *noise_;
+}
+
+NoiseInstructionSet NoiseGenerator::instructionSet() const
+{
+   return instructionSet_;
+}
+
+void NoiseGenerator::Evaluate(const double* x,
+                              const double* y,
+                              size_t        count,
+                              uint32_t      octaves,
+                              double*       result) const
+{
+   Evaluate(instructionSet_, x, y, count, octaves, result);
+}
+
+void NoiseGenerator::Evaluate(NoiseInstructionSet instructionSet,
+                              const double*       x,
+                              const double*       y,
+                              size_t              count,
+                              uint32_t            octaves,
+                              double*             result) const
+{
+   switch (instructionSet)
+   {
+   case NoiseInstructionSet::AVX2:
+      NoiseBatchAvx2(tables_, x, y, count, octaves, result);
+      break;
+
+#if defined(WORLDENGINE_NOISE_SSE2)
+   case NoiseInstructionSet::SSE2:
+      NoiseKernelDetail::Batch<Sse2Policy>(
+         tables_, x, y, count, octaves, result);
+      break;
+#endif
+
+   case NoiseInstructionSet::Scalar:
+      NoiseKernelDetail::Batch<ScalarPolicy>(
+         tables_, x, y, count, octaves, result);
+      break;
+
+   case NoiseInstructionSet::Reference:
+   default:
+      for (size_t i = 0; i < count; i++)
+      {
+         result[i] = Noise(*noise_, x[i], y[i], octaves);
+      }
+      break;
+   }
+}
+
+bool NoiseAvx2Supported()
+{
+   return NoiseAvx2Compiled() && ProcessorSupportsAvx2();
+}
+
+static void InitializeTables(NoiseTables& tables, int64_t seed)
+{
+   static const uint64_t multiplier = 6364136223846793005ull;
+   static const uint64_t increment  = 1442695040888963407ull;
+
+   int32_t source[256];
+   for (int32_t i = 0; i < 256; i++)
+   {
+      source[i] = i;
+   }
+
+   // Unsigned arithmetic wraps the same way as the reference implementation
+   uint64_t s = static_cast<uint64_t>(seed);
+   s          = s * multiplier + increment;
+   s          = s * multiplier + increment;
+   s          = s * multiplier + increment;
+
+   for (int32_t i = 255; i >= 0; i--)
+   {
+      s         = s * multiplier + increment;
+      int32_t r = static_cast<int32_t>(static_cast<int64_t>(s + 31) % (i + 1));
+      if (r < 0)
+      {
+         r += i + 1;
+      }
+      tables.perm_[i] = source[r];
+      source[r]       = source[i];
+   }
+
+   for (size_t i = 0; i < 16u; i++)
+   {
+      tables.gradientsX_[i] = GRADIENTS_2D[i];
+      tables.gradientsY_[i] = GRADIENTS_2D[(i + 1) % 16u];
+   }
+}
+
+static size_t ValidationMismatches(const NoiseGenerator& generator)
+{
+   static const size_t   numPoints = 4096u;
+   static const uint32_t octaves   = 3u;
+
+   std::vector<double> x(numPoints);
+   std::vector<double> y(numPoints);
+   std::vector<double> result(numPoints);
+
+   for (size_t i = 0; i < numPoints; i++)
+   {
+      // Cover negative and positive coordinates, both simplex triangles, and
+      // coordinates from a few cells to several thousand cells from the origin
+      const double scale = static_cast<double>(1u << (i % 8u));
+
+      x[i] = (-37.25 + 0.01173 * static_cast<double>(i)) * scale;
+      y[i] = (19.5 - 0.0618 * static_cast<double>(i * i % 997u)) * scale;
+   }
+
+   generator.Evaluate(x.data(), y.data(), numPoints, octaves, result.data());
+
+   size_t mismatches = 0u;
+   for (size_t i = 0; i < numPoints; i++)
+   {
+      // Written so that NaN results in a mismatch
+      if (!(result[i] == Noise(generator.noise(), x[i], y[i], octaves)))
+      {
+         mismatches++;
+      }
+   }
+
+   return mismatches;
+}
+
+} // namespace WorldEngine
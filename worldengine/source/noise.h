@@ -0,0 +1,102 @@
+#pragma once
+
+#include "noise_kernel.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace OpenSimplexNoise
+{
+class Noise;
+}
+
+namespace WorldEngine
+{
+
+enum class NoiseInstructionSet
+{
+   Reference,
+   Scalar,
+   SSE2,
+   AVX2
+};
+
+/**
+ * @brief Seeded OpenSimplex noise generator evaluating many points at once.
+ *
+ * Points are evaluated with the widest instruction set supported at runtime.
+ * Batched results are identical to those of Noise() for the same seed and
+ * coordinates. On construction, the batched kernel is checked against the
+ * OpenSimplex library for the same seed. If any result differs, every point is
+ * evaluated through the library instead.
+ */
+class NoiseGenerator
+{
+public:
+   explicit NoiseGenerator(int64_t seed);
+   ~NoiseGenerator();
+
+   NoiseGenerator(const NoiseGenerator&)            = delete;
+   NoiseGenerator& operator=(const NoiseGenerator&) = delete;
+
+   /**
+    * @brief Scalar OpenSimplex noise generator for the same seed
+    */
+   const OpenSimplexNoise::Noise& noise() const;
+
+   /**
+    * @brief Instruction set used to evaluate batches
+    */
+   NoiseInstructionSet instructionSet() const;
+
+   /**
+    * @brief Evaluate fractal noise for a batch of points
+    * @param x X coordinates
+    * @param y Y coordinates
+    * @param count Number of points
+    * @param octaves Number of passes, 1 for simple noise
+    * @param result Noise value for each point
+    */
+   void Evaluate(const double* x,
+                 const double* y,
+                 size_t        count,
+                 uint32_t      octaves,
+                 double*       result) const;
+
+private:
+   std::unique_ptr<OpenSimplexNoise::Noise> noise_;
+   NoiseTables                              tables_;
+   NoiseInstructionSet                      instructionSet_;
+
+   void Evaluate(NoiseInstructionSet instructionSet,
+                 const double*       x,
+                 const double*       y,
+                 size_t              count,
+                 uint32_t            octaves,
+                 double*             result) const;
+};
+
+/**
+ * @brief Determine whether the AVX2 noise kernel was built. Defined in a
+ * translation unit compiled for AVX2.
+ */
+bool NoiseAvx2Compiled();
+
+/**
+ * @brief Determine whether the AVX2 noise kernel was built and the processor
+ * supports it
+ */
+bool NoiseAvx2Supported();
+
+/**
+ * @brief AVX2 implementation of fractal noise, defined in a translation unit
+ * compiled for AVX2. Must only be called if NoiseAvx2Supported() returns true.
+ */
+void NoiseBatchAvx2(const NoiseTables& tables,
+                    const double*      x,
+                    const double*      y,
+                    size_t             count,
+                    uint32_t           octaves,
+                    double*            result);
+
+} // namespace WorldEngine
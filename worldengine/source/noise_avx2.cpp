@@ -0,0 +1,111 @@
+/**
+ * This translation unit is compiled for AVX2. Its functions must only be called
+ * after checking NoiseAvx2Supported(), and it must not instantiate templates
+ * which could be shared with other translation units.
+ */
+
+#include "noise.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace WorldEngine
+{
+
+#if defined(__AVX2__)
+
+namespace
+{
+
+/**
+ * @brief Four point policy using AVX2, with gradient lookups performed by
+ * gather instructions
+ */
+struct Avx2Policy
+{
+   typedef __m256d D;
+
+   static constexpr size_t WIDTH = 4u;
+
+   static D    Load(const double* p) { return _mm256_loadu_pd(p); }
+   static void Store(double* p, D v) { _mm256_storeu_pd(p, v); }
+   static D    Set(double v) { return _mm256_set1_pd(v); }
+   static D    Add(D a, D b) { return _mm256_add_pd(a, b); }
+   static D    Sub(D a, D b) { return _mm256_sub_pd(a, b); }
+   static D    Mul(D a, D b) { return _mm256_mul_pd(a, b); }
+   static D    Div(D a, D b) { return _mm256_div_pd(a, b); }
+   static D    Gt(D a, D b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+   static D    Le(D a, D b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+   static D    Or(D a, D b) { return _mm256_or_pd(a, b); }
+   static D    Select(D mask, D a, D b) { return _mm256_blendv_pd(b, a, mask); }
+   static D    Floor(D v) { return _mm256_floor_pd(v); }
+
+   static D Extrapolate(const NoiseTables& t, D xsb, D ysb, D dx, D dy)
+   {
+      // Masked gathers with an explicit source avoid spurious uninitialized
+      // warnings from the unmasked intrinsics on some compilers
+      const __m128i byteMask = _mm_set1_epi32(0xff);
+      const __m128i all      = _mm_set1_epi32(-1);
+      const __m128i zeroI    = _mm_setzero_si128();
+      const D       allD     = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+      const D       zeroD    = _mm256_setzero_pd();
+
+      // Only the low 8 bits of the lattice coordinates are used, so they are
+      // reduced before conversion to remain in range for large coordinates
+      const D wrap        = Set(256.0);
+      const D inverseWrap = Set(1.0 / 256.0);
+      xsb = Sub(xsb, Mul(Floor(Mul(xsb, inverseWrap)), wrap));
+      ysb = Sub(ysb, Mul(Floor(Mul(ysb, inverseWrap)), wrap));
+
+      __m128i xi = _mm_and_si128(_mm256_cvttpd_epi32(xsb), byteMask);
+      __m128i yi = _mm256_cvttpd_epi32(ysb);
+
+      __m128i index = _mm_mask_i32gather_epi32(zeroI, t.perm_, xi, all, 4);
+      index         = _mm_and_si128(_mm_add_epi32(index, yi), byteMask);
+      index         = _mm_mask_i32gather_epi32(zeroI, t.perm_, index, all, 4);
+      index         = _mm_and_si128(index, _mm_set1_epi32(0x0e));
+
+      D gx = _mm256_mask_i32gather_pd(zeroD, t.gradientsX_, index, allD, 8);
+      D gy = _mm256_mask_i32gather_pd(zeroD, t.gradientsY_, index, allD, 8);
+
+      return Add(Mul(gx, dx), Mul(gy, dy));
+   }
+};
+
+} // namespace
+
+bool NoiseAvx2Compiled()
+{
+   return true;
+}
+
+void NoiseBatchAvx2(const NoiseTables& tables,
+                    const double*      x,
+                    const double*      y,
+                    size_t             count,
+                    uint32_t           octaves,
+                    double*            result)
+{
+   NoiseKernelDetail::Batch<Avx2Policy>(tables, x, y, count, octaves, result);
+}
+
+#else
+
+bool NoiseAvx2Compiled()
+{
+   return false;
+}
+
+void NoiseBatchAvx2(const NoiseTables&,
+                    const double*,
+                    const double*,
+                    size_t,
+                    uint32_t,
+                    double*)
+{
+}
+
+#endif
+
+} // namespace WorldEngine
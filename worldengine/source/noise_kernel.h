@@ -0,0 +1,243 @@
+#pragma once
+
+/**
+ * Batched 2D OpenSimplex noise kernel, written once against a vector policy
+ * and instantiated for each supported instruction set.
+ *
+ * This header is included by translation units compiled with instruction set
+ * specific flags, and must not instantiate any standard library templates.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+namespace WorldEngine
+{
+
+/**
+ * @brief Lookup tables derived from the noise seed
+ */
+struct NoiseTables
+{
+   int32_t perm_[256];
+   double  gradientsX_[16];
+   double  gradientsY_[16];
+};
+
+namespace NoiseKernelDetail
+{
+
+static const double STRETCH_CONSTANT_2D = -0.211324865405187;
+static const double SQUISH_CONSTANT_2D  = 0.366025403784439;
+static const double NORM_CONSTANT_2D    = 47.0;
+
+/**
+ * @brief OpenSimplex noise for V::WIDTH points. Operations are performed in the
+ * same order as the scalar reference implementation, and contributions are
+ * masked instead of branched.
+ */
+template<class V>
+inline typename V::D
+Evaluate(const NoiseTables& t, typename V::D x, typename V::D y)
+{
+   typedef typename V::D D;
+
+   const D zero    = V::Set(0.0);
+   const D one     = V::Set(1.0);
+   const D two     = V::Set(2.0);
+   const D squish  = V::Set(SQUISH_CONSTANT_2D);
+   const D squish2 = V::Set(2 * SQUISH_CONSTANT_2D);
+
+   // Place input coordinates onto grid
+   D stretchOffset = V::Mul(V::Add(x, y), V::Set(STRETCH_CONSTANT_2D));
+   D xs            = V::Add(x, stretchOffset);
+   D ys            = V::Add(y, stretchOffset);
+
+   // Floor to get grid coordinates of rhombus (stretched square) super-cell
+   // origin
+   D xsb = V::Floor(xs);
+   D ysb = V::Floor(ys);
+
+   // Skew out to get actual coordinates of rhombus origin
+   D squishOffset = V::Mul(V::Add(xsb, ysb), squish);
+   D xb           = V::Add(xsb, squishOffset);
+   D yb           = V::Add(ysb, squishOffset);
+
+   // Compute grid coordinates relative to rhombus origin
+   D xins  = V::Sub(xs, xsb);
+   D yins  = V::Sub(ys, ysb);
+   D inSum = V::Add(xins, yins);
+
+   // Positions relative to origin point
+   D dx0 = V::Sub(x, xb);
+   D dy0 = V::Sub(y, yb);
+
+   D value = zero;
+
+   auto Contribute = [&](D xsv, D ysv, D dx, D dy)
+   {
+      D attn = V::Sub(V::Sub(two, V::Mul(dx, dx)), V::Mul(dy, dy));
+      D mask = V::Gt(attn, zero);
+      attn   = V::Mul(attn, attn);
+      D c    = V::Mul(V::Mul(attn, attn), V::Extrapolate(t, xsv, ysv, dx, dy));
+      value  = V::Add(value, V::Select(mask, c, zero));
+   };
+
+   // Contribution (1, 0)
+   Contribute(V::Add(xsb, one),
+              ysb,
+              V::Sub(V::Sub(dx0, one), squish),
+              V::Sub(V::Sub(dy0, zero), squish));
+
+   // Contribution (0, 1)
+   Contribute(xsb,
+              V::Add(ysb, one),
+              V::Sub(V::Sub(dx0, zero), squish),
+              V::Sub(V::Sub(dy0, one), squish));
+
+   // Inside the triangle (2-simplex) at (0, 0), or at (1, 1)
+   D lower = V::Le(inSum, one);
+
+   // Lower triangle
+   D zinsL    = V::Sub(one, inSum);
+   D closestL = V::Or(V::Gt(zinsL, xins), V::Gt(zinsL, yins));
+
+   // Upper triangle
+   D zinsU    = V::Sub(two, inSum);
+   D closestU = V::Or(V::Gt(xins, zinsU), V::Gt(yins, zinsU));
+
+   D xGreater = V::Gt(xins, yins);
+
+   // Lower triangle, (0, 0) is one of the closest two triangular vertices
+   D xsvL0 = V::Select(xGreater, V::Add(xsb, one), V::Sub(xsb, one));
+   D ysvL0 = V::Select(xGreater, V::Sub(ysb, one), V::Add(ysb, one));
+   D dxL0  = V::Select(xGreater, V::Sub(dx0, one), V::Add(dx0, one));
+   D dyL0  = V::Select(xGreater, V::Add(dy0, one), V::Sub(dy0, one));
+
+   // Lower triangle, (1, 0) and (0, 1) are the closest two vertices
+   D xsvL1 = V::Add(xsb, one);
+   D ysvL1 = V::Add(ysb, one);
+   D dxL1  = V::Sub(V::Sub(dx0, one), squish2);
+   D dyL1  = V::Sub(V::Sub(dy0, one), squish2);
+
+   // Upper triangle, (0, 0) is one of the closest two triangular vertices
+   D xsvU0 = V::Select(xGreater, V::Add(xsb, two), xsb);
+   D ysvU0 = V::Select(xGreater, ysb, V::Add(ysb, two));
+   D dxU0  = V::Select(xGreater,
+                      V::Sub(V::Sub(dx0, two), squish2),
+                      V::Sub(V::Add(dx0, zero), squish2));
+   D dyU0  = V::Select(xGreater,
+                      V::Sub(V::Add(dy0, zero), squish2),
+                      V::Sub(V::Sub(dy0, two), squish2));
+
+   // Upper triangle, (1, 0) and (0, 1) are the closest two vertices
+   D xsvU1 = xsb;
+   D ysvU1 = ysb;
+   D dxU1  = dx0;
+   D dyU1  = dy0;
+
+   // Extra vertex
+   D xsvExt = V::Select(lower,
+                        V::Select(closestL, xsvL0, xsvL1),
+                        V::Select(closestU, xsvU0, xsvU1));
+   D ysvExt = V::Select(lower,
+                        V::Select(closestL, ysvL0, ysvL1),
+                        V::Select(closestU, ysvU0, ysvU1));
+   D dxExt  = V::Select(lower,
+                       V::Select(closestL, dxL0, dxL1),
+                       V::Select(closestU, dxU0, dxU1));
+   D dyExt  = V::Select(lower,
+                       V::Select(closestL, dyL0, dyL1),
+                       V::Select(closestU, dyU0, dyU1));
+
+   // Contribution (0, 0) or (1, 1)
+   Contribute(V::Select(lower, xsb, V::Add(xsb, one)),
+              V::Select(lower, ysb, V::Add(ysb, one)),
+              V::Select(lower, dx0, V::Sub(V::Sub(dx0, one), squish2)),
+              V::Select(lower, dy0, V::Sub(V::Sub(dy0, one), squish2)));
+
+   // Contribution of the extra vertex
+   Contribute(xsvExt, ysvExt, dxExt, dyExt);
+
+   return V::Div(value, V::Set(NORM_CONSTANT_2D));
+}
+
+/**
+ * @brief Fractal OpenSimplex noise for V::WIDTH points, matching the
+ * accumulation order of the scalar Noise() function
+ */
+template<class V>
+inline typename V::D Fractal(const NoiseTables& t,
+                             typename V::D      x,
+                             typename V::D      y,
+                             uint32_t           octaves)
+{
+   typedef typename V::D D;
+
+   static const double persistence = 0.5;
+   static const double lacunarity  = 2.0;
+
+   double freq  = 1.0;
+   double amp   = 1.0;
+   double max   = 1.0;
+   D      total = Evaluate<V>(t, x, y);
+
+   for (uint32_t i = 1; i < octaves; i++)
+   {
+      freq *= lacunarity;
+      amp *= persistence;
+      max += amp;
+
+      const D f = V::Set(freq);
+      total     = V::Add(total,
+                     V::Mul(Evaluate<V>(t, V::Mul(x, f), V::Mul(y, f)),
+                            V::Set(amp)));
+   }
+
+   return V::Div(total, V::Set(max));
+}
+
+/**
+ * @brief Fractal OpenSimplex noise for an arbitrary number of points. A
+ * trailing partial vector is padded with copies of the last point.
+ */
+template<class V>
+inline void Batch(const NoiseTables& t,
+                  const double*      x,
+                  const double*      y,
+                  size_t             count,
+                  uint32_t           octaves,
+                  double*            result)
+{
+   size_t i = 0;
+
+   for (; i + V::WIDTH <= count; i += V::WIDTH)
+   {
+      V::Store(result + i,
+               Fractal<V>(t, V::Load(x + i), V::Load(y + i), octaves));
+   }
+
+   if (i < count)
+   {
+      double px[V::WIDTH];
+      double py[V::WIDTH];
+      double pr[V::WIDTH];
+
+      for (size_t j = 0; j < V::WIDTH; j++)
+      {
+         size_t k = (i + j < count) ? i + j : count - 1;
+         px[j]    = x[k];
+         py[j]    = y[k];
+      }
+
+      V::Store(pr, Fractal<V>(t, V::Load(px), V::Load(py), octaves));
+
+      for (size_t j = 0; i + j < count; j++)
+      {
+         result[i + j] = pr[j];
+      }
+   }
+}
+
+} // namespace NoiseKernelDetail
+} // namespace WorldEngine
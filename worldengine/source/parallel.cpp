@@ -0,0 +1,275 @@
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace WorldEngine
+{
+
+// Number of chunks per thread, allowing faster threads to take on more work
+static const uint32_t CHUNKS_PER_THREAD = 4u;
+
+namespace
+{
+
+/**
+ * @brief Set while the current thread is processing indices of a ParallelFor
+ * call, so that nested calls run inline instead of adding work to the pool
+ */
+thread_local bool insideParallelFor = false;
+
+/**
+ * @brief Range of indices being processed by a call to ParallelFor
+ */
+struct ParallelJob
+{
+   const std::function<void(uint32_t)>& func_;
+   const uint32_t                       end_;
+   const uint32_t                       chunkSize_;
+   std::atomic<uint32_t>                next_;   /**< First unclaimed index */
+   uint32_t                             active_; /**< Workers on the job */
+   std::exception_ptr                   error_;  /**< First exception */
+
+   ParallelJob(const std::function<void(uint32_t)>& func,
+               uint32_t                             begin,
+               uint32_t                             end,
+               uint32_t                             chunkSize) :
+       func_(func),
+       end_(end),
+       chunkSize_(chunkSize),
+       next_(begin),
+       active_(0u),
+       error_(nullptr)
+   {
+   }
+};
+
+/**
+ * @brief Worker threads shared by every call to ParallelFor. Threads are
+ * started on first use, and live until the process exits. Calls made while
+ * other calls are running queue their jobs, and workers take chunks from the
+ * oldest job with chunks remaining.
+ */
+class ThreadPool
+{
+public:
+   static ThreadPool& Instance()
+   {
+      static ThreadPool pool(NumThreads() - 1u);
+      return pool;
+   }
+
+   ~ThreadPool() { Stop(); }
+
+   /**
+    * @brief Replace the pool's workers. No job may be running.
+    * @param numWorkers Number of worker threads
+    */
+   void Resize(uint32_t numWorkers)
+   {
+      if (numWorkers != threads_.size())
+      {
+         Stop();
+         Start(numWorkers);
+      }
+   }
+
+   /**
+    * @brief Process a job with the pool's workers, with the calling thread
+    * participating, and return once every index has been processed
+    */
+   void Run(ParallelJob& job)
+   {
+      {
+         std::unique_lock<std::mutex> lock(mutex_);
+         jobs_.push_back(&job);
+      }
+      workAvailable_.notify_all();
+
+      RunChunks(job);
+
+      std::unique_lock<std::mutex> lock(mutex_);
+      Retire(job);
+      jobDone_.wait(lock, [&]() { return job.active_ == 0u; });
+   }
+
+private:
+   std::mutex               mutex_;
+   std::condition_variable  workAvailable_;
+   std::condition_variable  jobDone_;
+   std::deque<ParallelJob*> jobs_;
+   std::vector<std::thread> threads_;
+   bool                     stop_;
+
+   explicit ThreadPool(uint32_t numWorkers) : stop_(false)
+   {
+      Start(numWorkers);
+   }
+
+   void Start(uint32_t numWorkers)
+   {
+      stop_ = false;
+
+      for (uint32_t i = 0; i < numWorkers; i++)
+      {
+         threads_.emplace_back([this]() { Worker(); });
+      }
+   }
+
+   void Stop()
+   {
+      {
+         std::unique_lock<std::mutex> lock(mutex_);
+         stop_ = true;
+      }
+      workAvailable_.notify_all();
+
+      for (std::thread& t : threads_)
+      {
+         t.join();
+      }
+      threads_.clear();
+   }
+
+   void Worker()
+   {
+      std::unique_lock<std::mutex> lock(mutex_);
+
+      while (true)
+      {
+         workAvailable_.wait(lock, [&]() { return stop_ || !jobs_.empty(); });
+
+         if (stop_)
+         {
+            break;
+         }
+
+         ParallelJob& job = *jobs_.front();
+         job.active_++;
+
+         lock.unlock();
+         RunChunks(job);
+         lock.lock();
+
+         // Every chunk has been claimed
+         Retire(job);
+
+         if (--job.active_ == 0u)
+         {
+            jobDone_.notify_all();
+         }
+      }
+   }
+
+   /**
+    * @brief Claim and process chunks of a job until none remain
+    */
+   void RunChunks(ParallelJob& job)
+   {
+      const bool nested = insideParallelFor;
+      insideParallelFor = true;
+
+      try
+      {
+         uint32_t chunkBegin;
+         while ((chunkBegin = job.next_.fetch_add(job.chunkSize_)) < job.end_)
+         {
+            const uint32_t chunkEnd =
+               std::min(job.end_, chunkBegin + job.chunkSize_);
+            for (uint32_t i = chunkBegin; i < chunkEnd; i++)
+            {
+               job.func_(i);
+            }
+         }
+      }
+      catch (...)
+      {
+         std::unique_lock<std::mutex> lock(mutex_);
+         if (job.error_ == nullptr)
+         {
+            job.error_ = std::current_exception();
+         }
+
+         // Stop remaining threads from claiming work
+         job.next_ = job.end_;
+      }
+
+      insideParallelFor = nested;
+   }
+
+   /**
+    * @brief Remove a job from the queue, if still present. The mutex must be
+    * held.
+    */
+   void Retire(ParallelJob& job)
+   {
+      auto it = std::find(jobs_.begin(), jobs_.end(), &job);
+      if (it != jobs_.end())
+      {
+         jobs_.erase(it);
+      }
+   }
+};
+
+/**
+ * @brief Number of threads set by SetNumThreads
+ */
+std::atomic<uint32_t> numThreads_(0u);
+
+} // namespace
+
+uint32_t NumThreads()
+{
+   static const uint32_t hardwareThreads =
+      std::max(1u, std::thread::hardware_concurrency());
+
+   const uint32_t numThreads = numThreads_;
+   return (numThreads != 0u) ? numThreads : hardwareThreads;
+}
+
+void SetNumThreads(uint32_t numThreads)
+{
+   numThreads_ = numThreads;
+   ThreadPool::Instance().Resize(NumThreads() - 1u);
+}
+
+void ParallelFor(uint32_t                             begin,
+                 uint32_t                             end,
+                 const std::function<void(uint32_t)>& func)
+{
+   if (end <= begin)
+   {
+      return;
+   }
+
+   const uint32_t count      = end - begin;
+   const uint32_t numThreads = std::min(NumThreads(), count);
+
+   if (numThreads == 1u || insideParallelFor)
+   {
+      for (uint32_t i = begin; i < end; i++)
+      {
+         func(i);
+      }
+      return;
+   }
+
+   const uint32_t chunkSize =
+      std::max(1u, count / (numThreads * CHUNKS_PER_THREAD));
+
+   ParallelJob job(func, begin, end, chunkSize);
+   ThreadPool::Instance().Run(job);
+
+   if (job.error_ != nullptr)
+   {
+      std::rethrow_exception(job.error_);
+   }
+}
+
+} // namespace WorldEngine
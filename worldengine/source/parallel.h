@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace WorldEngine
+{
+
+/**
+ * @brief Number of threads used for data parallel operations
+ * @return Number of threads set by SetNumThreads, or by default the number of
+ * hardware threads, at least 1
+ */
+uint32_t NumThreads();
+
+/**
+ * @brief Set the number of threads used for data parallel operations, and by
+ * default for running simulations concurrently. Must not be called while a
+ * parallel operation is running.
+ * @param numThreads Number of threads, 0 for the number of hardware threads
+ */
+void SetNumThreads(uint32_t numThreads);
+
+/**
+ * @brief Invoke a function for each index in [begin, end), partitioning the
+ * range across threads. The calling thread participates, and the function
+ * returns once every index has been processed. The function must not depend on
+ * the order in which indices are processed. If any invocation throws, the first
+ * exception is rethrown.
+ *
+ * Worker threads are shared by every call, and started on first use.
+ * Concurrent calls share the workers rather than starting their own. Calls
+ * made from within the function run inline on the calling thread.
+ * @param begin First index
+ * @param end One past the last index
+ * @param func Function to invoke for each index, typically a row
+ */
+void ParallelFor(uint32_t                             begin,
+                 uint32_t                             end,
+                 const std::function<void(uint32_t)>& func);
+
+} // namespace WorldEngine
@@ -1,133 +1,174 @@
 #include "path.h"
 
+#include <algorithm>
+
 #include <boost/log/trivial.hpp>
 
 namespace WorldEngine
 {
 
-struct Node;
-typedef std::shared_ptr<Node> NodePtr;
-typedef std::list<NodePtr>    NodeList;
-
 const uint32_t MAX_PATH_ITERATIONS = 10000u;
 
+// Upper bound on the number of cells reached by a search: the source, and up
+// to four neighbors of each expanded cell
+const uint32_t MAX_PATH_CELLS = 4u * (MAX_PATH_ITERATIONS + 1u) + 1u;
+
+// Initial number of slots in the search state table
+const uint32_t MIN_PATH_SLOTS = 1024u;
+
 /**
- * @brief The basic unit, pixel or location
+ * @brief Open set entry. Entries are not removed when a cell is improved or
+ * closed, and are instead skipped if their sequence number is out of date.
  */
-struct Node
+struct OpenNode
 {
-   Point   location_;     /**< Where the node is located */
-   float   movementCost_; /**< Total move cost to reach this node */
-   float   score_;        /**< Calculated score for this node */
-   NodePtr parent_;       /**< Parent node */
-
-   Node(Point location, float movementCost, NodePtr parent = nullptr) :
-       location_(location),
-       movementCost_(movementCost),
-       score_(0.0f),
-       parent_(parent)
-   {
-   }
+   float    score_;    /**< Movement cost plus estimated cost to destination */
+   uint32_t sequence_; /**< Order in which the entry was opened */
+   int32_t  index_;    /**< Cell index */
 };
 
-struct Path
-{
-   NodeList nodes_;
-   float    totalCost_;
-
-   Path(NodeList nodes, float totalCost) : nodes_(nodes), totalCost_(totalCost)
-   {
-   }
-};
-
-bool operator==(const Node& lhs, const Node& rhs)
+/**
+ * @brief Heap ordering, placing the lowest score on top. Equal scores are
+ * resolved in favor of the most recently opened cell.
+ */
+static bool operator<(const OpenNode& lhs, const OpenNode& rhs)
 {
-   return lhs.location_ == rhs.location_;
+   return lhs.score_ > rhs.score_ ||
+          (lhs.score_ == rhs.score_ && lhs.sequence_ < rhs.sequence_);
 }
 
 /**
- * @brief A simple square map implementation
+ * @brief Search state of a cell reached by a search
  */
-struct SQMapHandler
+struct PathNode
 {
-   const ElevationArrayType& mapData_;
-   const int32_t             width_;
-   const int32_t             height_;
-
-   SQMapHandler(const ElevationArrayType& mapData,
-                int32_t                   width,
-                int32_t                   height) :
-       mapData_(mapData), width_(width), height_(height)
-   {
-   }
+   int32_t  index_;        /**< Cell index */
+   uint32_t search_;       /**< Search which reached the cell */
+   float    movementCost_; /**< Total move cost to reach cell */
+   int32_t  parent_;       /**< Previous cell, or -1 */
+   uint32_t sequence_;     /**< Current open entry */
+   bool     closed_;       /**< Cell has been expanded */
+};
 
-   NodeList GetAdjacentNodes(NodePtr currentNode, Point destination) const
+/**
+ * @brief Search state, reused by subsequent searches of a path finder. Only
+ * the cells reached by a search are stored, in an open addressing hash table
+ * keyed by cell index. The table grows with the number of cells reached, which
+ * is bounded by MAX_PATH_CELLS regardless of the size of the map.
+ */
+struct PathScratch
+{
+   std::vector<PathNode> nodes_;   /**< Hash table, by cell index */
+   std::vector<OpenNode> openSet_; /**< Binary heap of open entries */
+   uint32_t              shift_  = 0u;
+   uint32_t              count_  = 0u;
+   uint32_t              search_ = 0u;
+
+   /**
+    * @brief Begin a new search, invalidating the state of every cell
+    */
+   void Begin()
    {
-      NodeList result;
-
-      const Point& cl = currentNode->location_;
-      const Point& dl = destination;
-
-      NodePtr n;
+      if (nodes_.empty())
+      {
+         Resize(MIN_PATH_SLOTS);
+      }
 
-      n = HandleNode(cl.first + 1, cl.second, currentNode, dl.first, dl.second);
-      if (n != nullptr)
+      if (++search_ == 0u)
       {
-         result.push_back(n);
+         for (PathNode& node : nodes_)
+         {
+            node.search_ = 0u;
+         }
+         search_ = 1u;
       }
 
-      n = HandleNode(cl.first - 1, cl.second, currentNode, dl.first, dl.second);
-      if (n != nullptr)
+      count_ = 0u;
+      openSet_.clear();
+   }
+
+   /**
+    * @brief Get the state of a cell reached by the current search
+    * @param index Cell index
+    */
+   PathNode& Get(int32_t index)
+   {
+      uint32_t slot = Slot(index);
+      while (nodes_[slot].search_ != search_ || nodes_[slot].index_ != index)
       {
-         result.push_back(n);
+         slot = (slot + 1u) & (nodes_.size() - 1u);
       }
+      return nodes_[slot];
+   }
 
-      n = HandleNode(cl.first, cl.second + 1, currentNode, dl.first, dl.second);
-      if (n != nullptr)
+   /**
+    * @brief Get the state of a cell, resetting it if it has not been reached
+    * by the current search. References to other cells are invalidated.
+    * @param index Cell index
+    * @param isNew Set to true if the cell has not been reached before
+    */
+   PathNode& Touch(int32_t index, bool& isNew)
+   {
+      uint32_t slot = Slot(index);
+      while (nodes_[slot].search_ == search_)
       {
-         result.push_back(n);
+         if (nodes_[slot].index_ == index)
+         {
+            isNew = false;
+            return nodes_[slot];
+         }
+         slot = (slot + 1u) & (nodes_.size() - 1u);
       }
 
-      n = HandleNode(cl.first, cl.second - 1, currentNode, dl.first, dl.second);
-      if (n != nullptr)
+      // Keep the table at most half full
+      if ((count_ + 1u) * 2u > nodes_.size())
       {
-         result.push_back(n);
+         Resize(nodes_.size() * 2u);
+         return Touch(index, isNew);
       }
 
-      return result;
+      PathNode& node = nodes_[slot];
+      node           = {index, search_, 0.0f, -1, 0u, false};
+      count_++;
+
+      isNew = true;
+      return node;
    }
 
-   NodePtr GetNode(Point location) const
+private:
+   /**
+    * @brief Fibonacci hash of a cell index. The upper bits are used, so that
+    * cells a row apart do not collide on maps of power of two width.
+    */
+   uint32_t Slot(int32_t index) const
    {
-      int32_t x = location.first;
-      int32_t y = location.second;
-      if (x < 0 || x >= width_ || y < 0 || y >= height_)
-      {
-         return nullptr;
-      }
-      float d = mapData_[y][x];
-      return std::make_shared<Node>(location, d);
+      return (static_cast<uint32_t>(index) * 0x9e3779b1u) >> shift_;
    }
 
-   NodePtr HandleNode(int32_t x,
-                      int32_t y,
-                      NodePtr fromNode,
-                      int32_t destX,
-                      int32_t destY) const
+   void Resize(size_t numSlots)
    {
-      NodePtr n = GetNode({x, y});
+      std::vector<PathNode> nodes(numSlots);
+      nodes.swap(nodes_);
 
-      if (n != nullptr)
+      shift_ = 32u;
+      for (size_t n = numSlots; n > 1u; n >>= 1)
       {
-         int32_t dx     = std::max(x, destX) - std::min(x, destX);
-         int32_t dy     = std::max(y, destY) - std::min(y, destY);
-         int32_t emCost = dx + dy;
-         n->movementCost_ += fromNode->movementCost_;
-         n->score_  = n->movementCost_ + emCost;
-         n->parent_ = fromNode;
+         shift_--;
       }
 
-      return n;
+      // Reinsert the cells reached by the current search
+      for (const PathNode& node : nodes)
+      {
+         if (node.search_ == search_)
+         {
+            uint32_t slot = Slot(node.index_);
+            while (nodes_[slot].search_ == search_)
+            {
+               slot = (slot + 1u) & (nodes_.size() - 1u);
+            }
+            nodes_[slot] = node;
+         }
+      }
    }
 };
 
@@ -136,142 +177,209 @@ struct SQMapHandler
  *
  * https://en.wikipedia.org/wiki/A*_search_algorithm
  *
- * TODO: Use Boost implementation
+ * Neighbors are visited in the order east, west, south, north. The search ends
+ * as soon as the destination is reached as a neighbor.
  */
-struct AStar
+class AStar
 {
-   const SQMapHandler& mapHandler_;
-   NodeList            openSet;
-   NodeList            closedSet;
-
-   AStar(const SQMapHandler& mapHandler) : mapHandler_(mapHandler) {}
+public:
+   AStar(const ElevationArrayType& mapData, PathScratch& scratch) :
+       mapData_(mapData),
+       width_(static_cast<int32_t>(mapData.shape()[1])),
+       height_(static_cast<int32_t>(mapData.shape()[0])),
+       scratch_(scratch),
+       nextSequence_(0u)
+   {
+   }
 
-   NodePtr GetBestOpenNode()
+   std::vector<Point> FindPath(Point fromLocation, Point toLocation)
    {
-      NodePtr bestNode = nullptr;
+      std::vector<Point> path;
+
+      if (!Contains(fromLocation.first, fromLocation.second))
+      {
+         return path;
+      }
+
+      scratch_.Begin();
+
+      bool      isNew;
+      int32_t   start     = Index(fromLocation.first, fromLocation.second);
+      PathNode& startNode = scratch_.Touch(start, isNew);
+      startNode.movementCost_ =
+         mapData_[fromLocation.second][fromLocation.first];
+      Open(startNode, 0.0f);
+
+      int32_t  nextNode = start;
+      uint32_t counter  = 0;
 
-      for (NodePtr n : openSet)
+      while (nextNode >= 0)
       {
-         if (bestNode == nullptr || n->score_ <= bestNode->score_)
+         if (counter > MAX_PATH_ITERATIONS)
          {
-            bestNode = n;
+            BOOST_LOG_TRIVIAL(warning) << "FindPath: Exceeded trial limit";
+            break;
          }
+
+         if (HandleNode(nextNode, toLocation))
+         {
+            return TracePath(nextNode, toLocation);
+         }
+
+         nextNode = GetBestOpenNode();
+         counter++;
       }
 
-      return bestNode;
+      return path;
    }
 
-   static Path TracePath(NodePtr n)
+private:
+   const ElevationArrayType& mapData_;
+   const int32_t             width_;
+   const int32_t             height_;
+   PathScratch&              scratch_;
+   uint32_t                  nextSequence_;
+
+   bool Contains(int32_t x, int32_t y) const
    {
-      NodeList nodes;
-      NodePtr  p         = n->parent_;
-      float    totalCost = n->movementCost_;
+      return (x >= 0 && x < width_ && y >= 0 && y < height_);
+   }
 
-      nodes.push_front(n);
+   int32_t Index(int32_t x, int32_t y) const { return y * width_ + x; }
 
-      while (p->parent_ != nullptr)
+   Point Location(int32_t index) const
+   {
+      return {index % width_, index / width_};
+   }
+
+   void Open(PathNode& node, float score)
+   {
+      node.sequence_ = nextSequence_;
+      scratch_.openSet_.push_back({score, nextSequence_, node.index_});
+      std::push_heap(scratch_.openSet_.begin(), scratch_.openSet_.end());
+      nextSequence_++;
+   }
+
+   int32_t GetBestOpenNode()
+   {
+      std::vector<OpenNode>& openSet = scratch_.openSet_;
+
+      while (!openSet.empty())
       {
-         nodes.push_front(p);
-         p = p->parent_;
+         OpenNode best = openSet.front();
+         std::pop_heap(openSet.begin(), openSet.end());
+         openSet.pop_back();
+
+         const PathNode& node = scratch_.Get(best.index_);
+         if (!node.closed_ && node.sequence_ == best.sequence_)
+         {
+            return best.index_;
+         }
       }
 
-      return Path(nodes, totalCost);
+      return -1;
    }
 
-   NodePtr HandleNode(NodePtr node, Point end)
+   /**
+    * @brief Close a cell and open its neighbors
+    * @return True if the destination is a neighbor of the cell
+    */
+   bool HandleNode(int32_t node, Point end)
    {
-      openSet.remove_if([&node](const NodePtr o) { return *node == *o; });
-      closedSet.push_back(node);
+      static const Point offsets[] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
 
-      NodeList nodes = mapHandler_.GetAdjacentNodes(node, end);
+      PathNode& current = scratch_.Get(node);
+      current.closed_   = true;
 
-      NodeList::iterator openNode;
+      const Point cl           = Location(node);
+      const float movementCost = current.movementCost_;
 
-      for (NodePtr n : nodes)
+      for (const Point& offset : offsets)
       {
-         if (n->location_ == end)
+         int32_t x = cl.first + offset.first;
+         int32_t y = cl.second + offset.second;
+
+         if (!Contains(x, y))
+         {
+            continue;
+         }
+
+         if (x == end.first && y == end.second)
          {
             // Reached the destination
-            return n;
+            return true;
          }
-         else if (std::find_if(closedSet.begin(), //
-                               closedSet.end(),
-                               [&n](const NodePtr o) { return *n == *o; }) !=
-                  closedSet.end())
+
+         bool      isNew;
+         int32_t   n        = Index(x, y);
+         float     nCost    = mapData_[y][x] + movementCost;
+         PathNode& neighbor = scratch_.Touch(n, isNew);
+
+         if (!isNew && neighbor.closed_)
          {
             // Already in closed set, skip this
             continue;
          }
-         else if ((openNode = std::find_if(openSet.begin(), //
-                                           openSet.end(),
-                                           [&n](const NodePtr o) {
-                                              return *n == *o;
-                                           })) != openSet.end())
+         else if (!isNew && !(nCost < neighbor.movementCost_))
          {
-            // Already in open set, check if better score
-            if (n->movementCost_ < (*openNode)->movementCost_)
-            {
-               openSet.erase(openNode);
-               openSet.push_back(n);
-            }
-         }
-         else
-         {
-            // New node, append to open set
-            openSet.push_back(n);
+            // Already in open set with a better or equal cost
+            continue;
          }
+
+         int32_t dx     = std::max(x, end.first) - std::min(x, end.first);
+         int32_t dy     = std::max(y, end.second) - std::min(y, end.second);
+         int32_t emCost = dx + dy;
+
+         // New node, or better cost than in open set
+         neighbor.movementCost_ = nCost;
+         neighbor.parent_       = node;
+         Open(neighbor, nCost + emCost);
       }
 
-      return nullptr;
+      return false;
    }
 
-   Path FindPath(Point fromLocation, Point toLocation)
+   /**
+    * @brief Build the path from the first step after the source to the
+    * destination
+    */
+   std::vector<Point> TracePath(int32_t node, Point end) const
    {
-      NodePtr nextNode = mapHandler_.GetNode(fromLocation);
-      openSet.push_back(nextNode);
+      std::vector<Point> path;
 
-      uint32_t counter = 0;
+      path.push_back(end);
 
-      while (nextNode != nullptr)
+      int32_t p = node;
+      int32_t parent;
+      while ((parent = scratch_.Get(p).parent_) >= 0)
       {
-         if (counter > MAX_PATH_ITERATIONS)
-         {
-            BOOST_LOG_TRIVIAL(warning) << "FindPath: Exceeded trial limit";
-            break;
-         }
-
-         NodePtr finish = HandleNode(nextNode, toLocation);
-         if (finish != nullptr)
-         {
-            return TracePath(finish);
-         }
-
-         nextNode = GetBestOpenNode();
-         counter++;
+         path.push_back(Location(p));
+         p = parent;
       }
 
-      return Path(NodeList(), 0.0f);
+      std::reverse(path.begin(), path.end());
+
+      return path;
    }
 };
 
-std::list<Point>
-FindPath(const ElevationArrayType& elevation, Point source, Point destination)
-{
-   std::list<Point> path;
-
-   const int32_t width  = static_cast<int32_t>(elevation.shape()[1]);
-   const int32_t height = static_cast<int32_t>(elevation.shape()[0]);
+PathFinder::PathFinder() : scratch_(std::make_unique<PathScratch>()) {}
 
-   SQMapHandler mapHandler(elevation, width, height);
-   AStar        pathFinder(mapHandler);
-   Path         p = pathFinder.FindPath(source, destination);
+PathFinder::~PathFinder() = default;
 
-   for (NodePtr n : p.nodes_)
-   {
-      path.push_back(n->location_);
-   }
+std::vector<Point> PathFinder::FindPath(const ElevationArrayType& elevation,
+                                        Point                     source,
+                                        Point                     destination)
+{
+   AStar pathFinder(elevation, *scratch_);
+   return pathFinder.FindPath(source, destination);
+}
 
-   return path;
+std::vector<Point>
+FindPath(const ElevationArrayType& elevation, Point source, Point destination)
+{
+   PathFinder pathFinder;
+   return pathFinder.FindPath(elevation, source, destination);
 }
 
 } // namespace WorldEngine
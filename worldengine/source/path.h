@@ -2,19 +2,56 @@
 
 #include "worldengine/world.h"
 
-#include <list>
+#include <memory>
+#include <vector>
 
 namespace WorldEngine
 {
 
+struct PathScratch;
+
+/**
+ * @brief Path finder, holding search state that is reused by subsequent
+ * searches. The state is sized to the cells reached by a search, not to the
+ * map. A path finder must not be used by more than one thread at a time.
+ */
+class PathFinder
+{
+public:
+   PathFinder();
+   ~PathFinder();
+
+   PathFinder(const PathFinder&)            = delete;
+   PathFinder& operator=(const PathFinder&) = delete;
+
+   /**
+    * @brief Find the best path between two points, using the elevation of
+    * each cell as its movement cost
+    * @param elevation
+    * @param source
+    * @param destination
+    * @return Path from the first step after the source to the destination, or
+    * an empty path if the destination could not be reached
+    */
+   std::vector<Point> FindPath(const ElevationArrayType& elevation,
+                               Point                     source,
+                               Point                     destination);
+
+private:
+   std::unique_ptr<PathScratch> scratch_;
+};
+
 /**
- * @brief Find the best path between two points
- * @param world
+ * @brief Find the best path between two points, using the elevation of each
+ * cell as its movement cost. Callers searching repeatedly should reuse a
+ * PathFinder instead.
+ * @param elevation
  * @param source
  * @param destination
- * @return
+ * @return Path from the first step after the source to the destination, or an
+ * empty path if the destination could not be reached
  */
-std::list<Point>
+std::vector<Point>
 FindPath(const ElevationArrayType& elevation, Point source, Point destination);
 
 } // namespace WorldEngine
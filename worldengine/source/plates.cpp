@@ -1,5 +1,6 @@
 #include "worldengine/plates.h"
 #include "worldengine/generation.h"
+#include "worldengine/plates_cache.h"
 #include "worldengine/world.h"
 
 #include <chrono>
@@ -28,20 +29,25 @@ namespace WorldEngine
  * @param numPlates Number of plates
  * @param oceanLevel The elevation representing the ocean level
  * @param step Generation steps to perform
- * @return A new world
+ * @param platesCache Cache of plates simulation results, or nullptr to always
+ * run the plates simulation
+ * @param platesBudget Limits on the plates simulation
+ * @return A new world, or nullptr if the plates simulation was cancelled
  */
 static std::shared_ptr<World>
 PlatesSimulation(const std::string&        name,
                  uint32_t                  width,
                  uint32_t                  height,
                  uint32_t                  seed,
-                 const std::vector<float>& temps       = DEFAULT_TEMPS,
-                 const std::vector<float>& humids      = DEFAULT_HUMIDS,
-                 float                     gammaCurve  = DEFAULT_GAMMA_CURVE,
-                 float                     curveOffset = DEFAULT_CURVE_OFFSET,
-                 uint32_t                  numPlates   = DEFAULT_NUM_PLATES,
-                 float                     oceanLevel  = DEFAULT_OCEAN_LEVEL,
-                 const Step&               step        = DEFAULT_STEP);
+                 const std::vector<float>& temps        = DEFAULT_TEMPS,
+                 const std::vector<float>& humids       = DEFAULT_HUMIDS,
+                 float                     gammaCurve   = DEFAULT_GAMMA_CURVE,
+                 float                     curveOffset  = DEFAULT_CURVE_OFFSET,
+                 uint32_t                  numPlates    = DEFAULT_NUM_PLATES,
+                 float                     oceanLevel   = DEFAULT_OCEAN_LEVEL,
+                 const Step&               step         = DEFAULT_STEP,
+                 PlatesCache*              platesCache  = nullptr,
+                 const PlatesBudget&       platesBudget = PlatesBudget());
 
 std::shared_ptr<World> WorldGen(const std::string&        name,
                                 uint32_t                  width,
@@ -54,7 +60,10 @@ std::shared_ptr<World> WorldGen(const std::string&        name,
                                 uint32_t                  numPlates,
                                 float                     oceanLevel,
                                 const Step&               step,
-                                bool                      fadeBorders)
+                                bool                      fadeBorders,
+                                ScratchArena*             scratch,
+                                PlatesCache*              platesCache,
+                                const PlatesBudget&       platesBudget)
 {
    std::chrono::steady_clock::time_point startTime;
    std::chrono::steady_clock::time_point endTime;
@@ -71,7 +80,15 @@ std::shared_ptr<World> WorldGen(const std::string&        name,
                                                    curveOffset,
                                                    numPlates,
                                                    oceanLevel,
-                                                   step);
+                                                   step,
+                                                   platesCache,
+                                                   platesBudget);
+
+   if (world == nullptr)
+   {
+      BOOST_LOG_TRIVIAL(info) << "WorldGen(): Plates simulation cancelled";
+      return nullptr;
+   }
 
    CenterLand(*world);
 
@@ -103,7 +120,7 @@ std::shared_ptr<World> WorldGen(const std::string&        name,
 
    if (fadeBorders)
       PlaceOceansAtMapBorders(*world);
-   InitializeOceanAndThresholds(*world);
+   InitializeOceanAndThresholds(*world, DEFAULT_OCEAN_LEVEL, scratch);
 
    endTime = std::chrono::steady_clock::now();
    elapsedTime =
@@ -113,23 +130,25 @@ std::shared_ptr<World> WorldGen(const std::string&        name,
    BOOST_LOG_TRIVIAL(debug) << "WorldGen(): oceans initialized. "
                             << "Elapsed time " << elapsedTime << "ms.";
 
-   GenerateWorld(*world, step, distribution(generator));
+   GenerateWorld(*world, step, distribution(generator), scratch);
 
    return world;
 }
 
-void* GeneratePlatesSimulation(float**    heightmap,
-                               uint32_t** platesmap,
-                               long       seed,
-                               uint32_t   width,
-                               uint32_t   height,
-                               float      seaLevel,
-                               uint32_t   erosionPeriod,
-                               float      foldingRatio,
-                               uint32_t   aggrOverlapAbs,
-                               float      aggrOverlapRel,
-                               uint32_t   cycleCount,
-                               uint32_t   numPlates)
+void* GeneratePlatesSimulation(float**             heightmap,
+                               uint32_t**          platesmap,
+                               long                seed,
+                               uint32_t            width,
+                               uint32_t            height,
+                               float               seaLevel,
+                               uint32_t            erosionPeriod,
+                               float               foldingRatio,
+                               uint32_t            aggrOverlapAbs,
+                               float               aggrOverlapRel,
+                               uint32_t            cycleCount,
+                               uint32_t            numPlates,
+                               const PlatesBudget& budget,
+                               PlatesStatus*       status)
 {
    std::chrono::steady_clock::time_point startTime;
    std::chrono::steady_clock::time_point endTime;
@@ -150,9 +169,11 @@ void* GeneratePlatesSimulation(float**    heightmap,
    // Note: To rescale the world's heightmap to roughly Earth's scale, multiply
    // by 2000
 
-   while (!platec_api_is_finished(p))
+   PlatesStatus result = StepPlatesSimulation(p, budget);
+
+   if (status != nullptr)
    {
-      platec_api_step(p);
+      *status = result;
    }
 
    *heightmap = platec_api_get_heightmap(p);
@@ -169,6 +190,43 @@ void* GeneratePlatesSimulation(float**    heightmap,
    return p;
 }
 
+PlatesStatus StepPlatesSimulation(void* p, const PlatesBudget& budget)
+{
+   const std::chrono::steady_clock::time_point startTime =
+      std::chrono::steady_clock::now();
+
+   PlatesProgress progress {0u, std::chrono::milliseconds(0)};
+
+   while (!platec_api_is_finished(p))
+   {
+      if ((budget.maxSteps_ != 0u && progress.step_ >= budget.maxSteps_) ||
+          (budget.maxTime_.count() != 0 &&
+           progress.elapsedTime_ >= budget.maxTime_))
+      {
+         BOOST_LOG_TRIVIAL(warning)
+            << "Plates simulation budget exhausted after " << progress.step_
+            << " steps, " << progress.elapsedTime_.count() << "ms";
+         return PlatesStatus::Truncated;
+      }
+
+      platec_api_step(p);
+
+      progress.step_++;
+      progress.elapsedTime_ =
+         std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime);
+
+      if (budget.callback_ && !budget.callback_(progress))
+      {
+         BOOST_LOG_TRIVIAL(debug) << "Plates simulation cancelled after "
+                                  << progress.step_ << " steps";
+         return PlatesStatus::Cancelled;
+      }
+   }
+
+   return PlatesStatus::Finished;
+}
+
 void PlatecApiDestroy(void* p)
 {
    platec_api_destroy(p);
@@ -180,27 +238,19 @@ static std::shared_ptr<World> PlatesSimulation(const std::string&        name,
                                                uint32_t                  seed,
                                                const std::vector<float>& temps,
                                                const std::vector<float>& humids,
-                                               float       gammaCurve,
-                                               float       curveOffset,
-                                               uint32_t    numPlates,
-                                               float       oceanLevel,
-                                               const Step& step)
+                                               float               gammaCurve,
+                                               float               curveOffset,
+                                               uint32_t            numPlates,
+                                               float               oceanLevel,
+                                               const Step&         step,
+                                               PlatesCache*        platesCache,
+                                               const PlatesBudget& platesBudget)
 {
-   float*    heightmap;
-   uint32_t* platesmap;
-
-   void* p = GeneratePlatesSimulation(&heightmap,
-                                      &platesmap,
-                                      seed,
-                                      width,
-                                      height,
-                                      DEFAULT_SEA_LEVEL,
-                                      DEFAULT_EROSION_PERIOD,
-                                      DEFAULT_FOLDING_RATIO,
-                                      DEFAULT_AGGR_OVERLAP_ABS,
-                                      DEFAULT_AGGR_OVERLAP_REL,
-                                      DEFAULT_CYCLE_COUNT,
-                                      numPlates);
+   PlatesParameters parameters;
+   parameters.seed_      = seed;
+   parameters.width_     = width;
+   parameters.height_    = height;
+   parameters.numPlates_ = numPlates;
 
    std::shared_ptr<World> world = std::shared_ptr<World>(
       new World(name,
@@ -212,6 +262,66 @@ static std::shared_ptr<World> PlatesSimulation(const std::string&        name,
                 gammaCurve,
                 curveOffset));
 
+   if (platesCache != nullptr)
+   {
+      // Read the elevation map directly into the storage of the world
+      ElevationArrayType& elevation = world->GetElevationData();
+      elevation.resize(boost::extents[height][width]);
+
+      std::vector<uint32_t> platesmap(elevation.num_elements());
+
+      if (platesCache->Load(parameters, elevation.data(), platesmap.data()))
+      {
+         BOOST_LOG_TRIVIAL(debug) << "PlatesSimulation(): Loaded from "
+                                  << platesCache->Filename(parameters);
+
+         world->SetPlatesData(platesmap.data());
+
+         return world;
+      }
+   }
+
+   float*       heightmap;
+   uint32_t*    platesmap;
+   PlatesStatus status;
+
+   void* p = GeneratePlatesSimulation(&heightmap,
+                                      &platesmap,
+                                      parameters.seed_,
+                                      parameters.width_,
+                                      parameters.height_,
+                                      parameters.seaLevel_,
+                                      parameters.erosionPeriod_,
+                                      parameters.foldingRatio_,
+                                      parameters.aggrOverlapAbs_,
+                                      parameters.aggrOverlapRel_,
+                                      parameters.cycleCount_,
+                                      parameters.numPlates_,
+                                      platesBudget,
+                                      &status);
+
+   if (status == PlatesStatus::Cancelled)
+   {
+      PlatecApiDestroy(p);
+      return nullptr;
+   }
+
+   // Only a converged simulation is determined by its parameters alone
+   if (platesCache != nullptr && status == PlatesStatus::Finished)
+   {
+      platesCache->Store(parameters, heightmap, platesmap);
+   }
+
+   if (status == PlatesStatus::Truncated)
+   {
+      BOOST_LOG_TRIVIAL(warning)
+         << "PlatesSimulation(): Budget exhausted before the simulation "
+            "converged";
+   }
+
+   world->GetGenerationRecord().platesStatus_ = status;
+
+   // The buffers are owned by the plates simulation, and released with it
    world->SetElevationData(heightmap);
    world->SetPlatesData(platesmap);
 
@@ -0,0 +1,215 @@
+#include "worldengine/plates_cache.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+#include <boost/log/trivial.hpp>
+
+namespace WorldEngine
+{
+
+/**
+ * @brief Identifies a plates cache file. A file written on a host of different
+ * byte order does not match, and is treated as a miss.
+ */
+static const uint32_t PLATES_CACHE_MAGIC = 0x43504557u; // "WEPC"
+
+/**
+ * @brief Version of the plates cache file format, and of the plates
+ * simulation. Incrementing the version invalidates existing files.
+ */
+static const uint32_t PLATES_CACHE_VERSION = 1u;
+
+typedef std::vector<uint8_t> KeyType;
+
+static KeyType PlatesCacheKey(const PlatesParameters& parameters);
+
+bool PlatesParameters::operator==(const PlatesParameters& other) const
+{
+   return PlatesCacheKey(*this) == PlatesCacheKey(other);
+}
+
+PlatesCache::PlatesCache(const std::string& directory) : directory_(directory)
+{
+}
+
+PlatesCache::~PlatesCache() = default;
+
+bool PlatesCache::Load(const PlatesParameters& parameters,
+                       std::vector<float>&     heightmap,
+                       std::vector<uint32_t>&  platesmap) const
+{
+   const size_t numCells =
+      static_cast<size_t>(parameters.width_) * parameters.height_;
+
+   heightmap.resize(numCells);
+   platesmap.resize(numCells);
+
+   if (!Load(parameters, heightmap.data(), platesmap.data()))
+   {
+      heightmap.clear();
+      platesmap.clear();
+      return false;
+   }
+
+   return true;
+}
+
+bool PlatesCache::Load(const PlatesParameters& parameters,
+                       float*                  heightmap,
+                       uint32_t*               platesmap) const
+{
+   const std::string filename = Filename(parameters);
+   const KeyType     key      = PlatesCacheKey(parameters);
+   const size_t      numCells =
+      static_cast<size_t>(parameters.width_) * parameters.height_;
+
+   std::ifstream ifs(filename, std::ios_base::in | std::ios_base::binary);
+   if (!ifs)
+   {
+      return false;
+   }
+
+   KeyType fileKey(key.size());
+   ifs.read(reinterpret_cast<char*>(fileKey.data()), fileKey.size());
+
+   if (!ifs || fileKey != key)
+   {
+      BOOST_LOG_TRIVIAL(warning)
+         << "Plates cache file does not match its parameters: " << filename;
+      return false;
+   }
+
+   ifs.read(reinterpret_cast<char*>(heightmap), numCells * sizeof(float));
+   ifs.read(reinterpret_cast<char*>(platesmap), numCells * sizeof(uint32_t));
+
+   // The file must end after the plates map
+   if (!ifs || ifs.peek() != std::ifstream::traits_type::eof())
+   {
+      BOOST_LOG_TRIVIAL(warning)
+         << "Plates cache file is truncated or corrupt: " << filename;
+      return false;
+   }
+
+   return true;
+}
+
+bool PlatesCache::Store(const PlatesParameters& parameters,
+                        const float*            heightmap,
+                        const uint32_t*         platesmap) const
+{
+   static std::atomic<uint32_t> tempCounter(0u);
+
+   const std::string filename = Filename(parameters);
+   const KeyType     key      = PlatesCacheKey(parameters);
+   const size_t      numCells =
+      static_cast<size_t>(parameters.width_) * parameters.height_;
+
+   std::error_code ec;
+   std::filesystem::create_directories(directory_, ec);
+   if (ec)
+   {
+      BOOST_LOG_TRIVIAL(warning) << "Unable to create plates cache directory "
+                                 << directory_ << ": " << ec.message();
+      return false;
+   }
+
+   // Write to a file unique to this thread, and rename it into place, so that
+   // a partially written file is never loaded
+   std::ostringstream tempFilename;
+   tempFilename << filename << ".tmp."
+                << std::hash<std::thread::id>()(std::this_thread::get_id())
+                << "." << tempCounter++ << "."
+                << std::chrono::steady_clock::now().time_since_epoch().count();
+
+   {
+      std::ofstream ofs(tempFilename.str(),
+                        std::ios_base::out | std::ios_base::binary);
+
+      ofs.write(reinterpret_cast<const char*>(key.data()), key.size());
+      ofs.write(reinterpret_cast<const char*>(heightmap),
+                numCells * sizeof(float));
+      ofs.write(reinterpret_cast<const char*>(platesmap),
+                numCells * sizeof(uint32_t));
+      ofs.close();
+
+      if (!ofs)
+      {
+         BOOST_LOG_TRIVIAL(warning)
+            << "Unable to write plates cache file " << tempFilename.str();
+         std::filesystem::remove(tempFilename.str(), ec);
+         return false;
+      }
+   }
+
+   std::filesystem::rename(tempFilename.str(), filename, ec);
+   if (ec)
+   {
+      BOOST_LOG_TRIVIAL(warning) << "Unable to write plates cache file "
+                                 << filename << ": " << ec.message();
+      std::filesystem::remove(tempFilename.str(), ec);
+      return false;
+   }
+
+   return true;
+}
+
+std::string PlatesCache::Filename(const PlatesParameters& parameters) const
+{
+   // FNV-1a
+   uint64_t hash = 0xcbf29ce484222325u;
+   for (uint8_t byte : PlatesCacheKey(parameters))
+   {
+      hash = (hash ^ byte) * 0x100000001b3u;
+   }
+
+   std::ostringstream filename;
+   filename << std::hex << std::setfill('0') << std::setw(16) << hash
+            << ".plates";
+
+   return (std::filesystem::path(directory_) / filename.str()).string();
+}
+
+const std::string& PlatesCache::directory() const
+{
+   return directory_;
+}
+
+/**
+ * @brief Serialize the parameters of a plates simulation, along with the file
+ * format, as the header of a cache file
+ */
+static KeyType PlatesCacheKey(const PlatesParameters& parameters)
+{
+   KeyType key;
+
+   auto Append = [&key](const auto& value)
+   {
+      const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+      key.insert(key.end(), bytes, bytes + sizeof(value));
+   };
+
+   Append(PLATES_CACHE_MAGIC);
+   Append(PLATES_CACHE_VERSION);
+   Append(parameters.seed_);
+   Append(parameters.width_);
+   Append(parameters.height_);
+   Append(parameters.seaLevel_);
+   Append(parameters.erosionPeriod_);
+   Append(parameters.foldingRatio_);
+   Append(parameters.aggrOverlapAbs_);
+   Append(parameters.aggrOverlapRel_);
+   Append(parameters.cycleCount_);
+   Append(parameters.numPlates_);
+
+   return key;
+}
+
+} // namespace WorldEngine
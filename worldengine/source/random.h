@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace WorldEngine
+{
+
+/**
+ * @brief Counter-based random number generator (Philox4x32-10). Each value is
+ * a function of a key and a counter only, so values can be generated in any
+ * order, and by any number of threads, with the same results.
+ *
+ * Salmon, J. K., Moraes, M. A., Dror, R. O., & Shaw, D. E. (2011). Parallel
+ * Random Numbers: As Easy as 1, 2, 3.
+ */
+class CounterRandom
+{
+public:
+   typedef std::array<uint32_t, 4> CounterType;
+
+   /**
+    * @brief Create a generator
+    * @param seed Seed of the world or simulation
+    * @param stream Independent stream for the seed, typically a simulation
+    * stage
+    */
+   CounterRandom(uint32_t seed, uint32_t stream) : key_({seed, stream}) {}
+
+   /**
+    * @brief Generate four values for a counter
+    */
+   CounterType Generate(CounterType counter) const
+   {
+      static const uint32_t multiplier0 = 0xd2511f53u;
+      static const uint32_t multiplier1 = 0xcd9e8d57u;
+      static const uint32_t weyl0       = 0x9e3779b9u;
+      static const uint32_t weyl1       = 0xbb67ae85u;
+      static const uint32_t numRounds   = 10u;
+
+      uint32_t key0 = key_[0];
+      uint32_t key1 = key_[1];
+
+      for (uint32_t round = 0; round < numRounds; round++)
+      {
+         uint64_t product0 = uint64_t(multiplier0) * counter[0];
+         uint64_t product1 = uint64_t(multiplier1) * counter[2];
+
+         counter = {static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key0,
+                    static_cast<uint32_t>(product1),
+                    static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key1,
+                    static_cast<uint32_t>(product0)};
+
+         key0 += weyl0;
+         key1 += weyl1;
+      }
+
+      return counter;
+   }
+
+   /**
+    * @brief Random value for a cell
+    * @param x
+    * @param y
+    * @param index Index of the value, when a cell requires more than one
+    */
+   uint32_t operator()(uint32_t x, uint32_t y, uint32_t index = 0u) const
+   {
+      return Generate({x, y, index, 0u})[0];
+   }
+
+   /**
+    * @brief Uniformly distributed value in [0, 1) for a cell
+    * @param x
+    * @param y
+    * @param index Index of the value, when a cell requires more than one
+    */
+   float Uniform(uint32_t x, uint32_t y, uint32_t index = 0u) const
+   {
+      // Use the 24 most significant bits, which a float represents exactly
+      return static_cast<float>((*this)(x, y, index) >> 8) * 0x1.0p-24f;
+   }
+
+   /**
+    * @brief Uniformly distributed integer in [0, range) for a cell
+    * @param range Number of possible values, greater than 0
+    * @param x
+    * @param y
+    * @param index Index of the value, when a cell requires more than one
+    */
+   uint32_t
+   Below(uint32_t range, uint32_t x, uint32_t y, uint32_t index = 0u) const
+   {
+      return static_cast<uint32_t>(
+         (uint64_t((*this)(x, y, index)) * range) >> 32);
+   }
+
+private:
+   std::array<uint32_t, 2> key_;
+};
+
+} // namespace WorldEngine
@@ -0,0 +1,203 @@
+#include "scheduler.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include <boost/log/trivial.hpp>
+
+namespace WorldEngine
+{
+
+/**
+ * @brief Determine whether a later stage must wait for an earlier stage
+ * @param earlier Stage added first
+ * @param later Stage added second
+ * @return True if the stages share a layer which either of them writes
+ */
+static bool Conflicts(const SimulationTask& earlier,
+                      const SimulationTask& later);
+
+SimulationScheduler::SimulationScheduler(uint32_t numThreads) :
+    numThreads_(numThreads), tasks_()
+{
+   if (numThreads_ == 0u)
+   {
+      numThreads_ = NumThreads();
+   }
+}
+
+void SimulationScheduler::Add(Simulation                   simulation,
+                              const std::vector<Layer>&    inputs,
+                              const std::vector<Layer>&    outputs,
+                              const std::function<void()>& execute)
+{
+   tasks_.emplace_back(simulation, inputs, outputs, execute);
+}
+
+std::vector<size_t> SimulationScheduler::Dependencies(size_t index) const
+{
+   std::vector<size_t> dependencies;
+
+   for (size_t i = 0; i < index && i < tasks_.size(); i++)
+   {
+      if (Conflicts(tasks_[i], tasks_[index]))
+      {
+         dependencies.push_back(i);
+      }
+   }
+
+   return dependencies;
+}
+
+void SimulationScheduler::Execute()
+{
+   const size_t numTasks = tasks_.size();
+
+   if (numThreads_ == 1u)
+   {
+      for (const SimulationTask& task : tasks_)
+      {
+         task.execute_();
+      }
+      return;
+   }
+
+   std::vector<std::vector<size_t>> dependents(numTasks);
+   std::vector<size_t>              pending(numTasks, 0u);
+   std::deque<size_t>               ready;
+
+   for (size_t i = 0; i < numTasks; i++)
+   {
+      for (size_t d : Dependencies(i))
+      {
+         dependents[d].push_back(i);
+         pending[i]++;
+      }
+
+      if (pending[i] == 0u)
+      {
+         ready.push_back(i);
+      }
+   }
+
+   std::mutex              mutex;
+   std::condition_variable cv;
+   size_t                  completed = 0u;
+   std::exception_ptr      error     = nullptr;
+
+   auto Worker = [&]()
+   {
+      std::unique_lock<std::mutex> lock(mutex);
+
+      while (true)
+      {
+         cv.wait(lock,
+                 [&]() { return !ready.empty() || completed == numTasks; });
+
+         if (ready.empty())
+         {
+            break;
+         }
+
+         size_t i = ready.front();
+         ready.pop_front();
+
+         bool skip = (error != nullptr);
+
+         lock.unlock();
+
+         std::exception_ptr taskError = nullptr;
+
+         if (!skip)
+         {
+            BOOST_LOG_TRIVIAL(trace)
+               << "Scheduler: " << tasks_[i].simulation_ << " start";
+
+            try
+            {
+               tasks_[i].execute_();
+            }
+            catch (...)
+            {
+               taskError = std::current_exception();
+            }
+         }
+
+         lock.lock();
+
+         if (taskError != nullptr && error == nullptr)
+         {
+            error = taskError;
+         }
+
+         completed++;
+         for (size_t d : dependents[i])
+         {
+            if (--pending[d] == 0u)
+            {
+               ready.push_back(d);
+            }
+         }
+
+         cv.notify_all();
+      }
+   };
+
+   const size_t numWorkers =
+      std::min(static_cast<size_t>(numThreads_), numTasks);
+
+   std::vector<std::thread> threads;
+   for (size_t i = 1; i < numWorkers; i++)
+   {
+      threads.emplace_back(Worker);
+   }
+
+   // The calling thread participates as a worker
+   Worker();
+
+   for (std::thread& t : threads)
+   {
+      t.join();
+   }
+
+   if (error != nullptr)
+   {
+      std::rethrow_exception(error);
+   }
+}
+
+static bool Conflicts(const SimulationTask& earlier,
+                      const SimulationTask& later)
+{
+   auto Contains = [](const std::vector<Layer>& layers, Layer layer)
+   {
+      return std::find(layers.cbegin(), layers.cend(), layer) != layers.cend();
+   };
+
+   for (Layer layer : earlier.outputs_)
+   {
+      // Read after write, write after write
+      if (Contains(later.inputs_, layer) || Contains(later.outputs_, layer))
+      {
+         return true;
+      }
+   }
+
+   for (Layer layer : earlier.inputs_)
+   {
+      // Write after read
+      if (Contains(later.outputs_, layer))
+      {
+         return true;
+      }
+   }
+
+   return false;
+}
+
+} // namespace WorldEngine
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "worldengine/common.h"
+
+#include <functional>
+#include <vector>
+
+namespace WorldEngine
+{
+
+/**
+ * @brief A simulation stage, along with the world layers it reads and writes.
+ * Thresholds belonging to a layer are considered part of that layer.
+ */
+struct SimulationTask
+{
+   Simulation            simulation_;
+   std::vector<Layer>    inputs_;
+   std::vector<Layer>    outputs_;
+   std::function<void()> execute_;
+
+   SimulationTask(Simulation                   simulation,
+                  const std::vector<Layer>&    inputs,
+                  const std::vector<Layer>&    outputs,
+                  const std::function<void()>& execute) :
+       simulation_(simulation),
+       inputs_(inputs),
+       outputs_(outputs),
+       execute_(execute)
+   {
+   }
+};
+
+/**
+ * @brief Runs simulation stages concurrently where their layers allow it.
+ *
+ * Stages are added in their serial order. A stage depends on every earlier
+ * stage which writes a layer it reads or writes, or which reads a layer it
+ * writes. Any schedule honoring these dependencies produces the same world as
+ * running the stages one after another.
+ */
+class SimulationScheduler
+{
+public:
+   /**
+    * @brief Create a scheduler
+    * @param numThreads Maximum number of stages to run at once, 0 to use the
+    * number of hardware threads
+    */
+   explicit SimulationScheduler(uint32_t numThreads = 0u);
+
+   /**
+    * @brief Add a stage to run after all previously added stages it conflicts
+    * with
+    * @param simulation Simulation type, used for logging
+    * @param inputs Layers read by the stage
+    * @param outputs Layers written by the stage
+    * @param execute Stage implementation
+    */
+   void Add(Simulation                   simulation,
+            const std::vector<Layer>&    inputs,
+            const std::vector<Layer>&    outputs,
+            const std::function<void()>& execute);
+
+   /**
+    * @brief Run all added stages, returning once every stage has finished. If
+    * a stage throws, stages which have not yet started are skipped and the
+    * first exception is rethrown.
+    */
+   void Execute();
+
+   /**
+    * @brief Stages which must finish before a given stage may start
+    * @param index Stage index, in the order added
+    * @return Indices of the stage's direct dependencies
+    */
+   std::vector<size_t> Dependencies(size_t index) const;
+
+private:
+   uint32_t                    numThreads_;
+   std::vector<SimulationTask> tasks_;
+};
+
+} // namespace WorldEngine
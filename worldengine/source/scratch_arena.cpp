@@ -0,0 +1,147 @@
+#include "worldengine/scratch_arena.h"
+
+#include <cassert>
+
+namespace WorldEngine
+{
+
+ScratchArena::ScratchArena(size_t blockSize) :
+    mutex_(), blocks_(), blockSize_(blockSize)
+{
+}
+
+ScratchArena::~ScratchArena() = default;
+
+void* ScratchArena::Allocate(size_t size, size_t alignment)
+{
+   assert(alignment > 0u && (alignment & (alignment - 1u)) == 0u &&
+          alignment <= SCRATCH_ALIGNMENT);
+
+   std::scoped_lock lock(mutex_);
+
+   if (!blocks_.empty())
+   {
+      Block& block  = blocks_.back();
+      size_t offset = (block.offset_ + alignment - 1u) & ~(alignment - 1u);
+
+      if (offset <= block.size_ && size <= block.size_ - offset)
+      {
+         block.offset_ = offset + size;
+         return block.begin_ + offset;
+      }
+   }
+
+   // Grow geometrically, so a batch of worlds settles on a single block after
+   // the first reset
+   size_t blockSize = std::max(blockSize_, size);
+   if (!blocks_.empty())
+   {
+      blockSize = std::max(blockSize, blocks_.back().size_ * 2u);
+   }
+
+   AddBlock(blockSize);
+
+   Block& block  = blocks_.back();
+   block.offset_ = size;
+   return block.begin_;
+}
+
+void ScratchArena::Reset()
+{
+   std::scoped_lock lock(mutex_);
+   ResetBlocks();
+}
+
+ScratchArena::Mark ScratchArena::GetMark() const
+{
+   std::scoped_lock lock(mutex_);
+
+   if (blocks_.empty())
+   {
+      return {0u, 0u};
+   }
+   return {blocks_.size(), blocks_.back().offset_};
+}
+
+void ScratchArena::Rewind(const Mark& mark)
+{
+   std::scoped_lock lock(mutex_);
+
+   // Nothing was allocated before the mark
+   if (mark.blocks_ <= 1u && mark.offset_ == 0u)
+   {
+      ResetBlocks();
+      return;
+   }
+
+   // Blocks added since the mark only hold allocations made after it
+   while (blocks_.size() > mark.blocks_)
+   {
+      blocks_.pop_back();
+   }
+
+   assert(blocks_.size() == mark.blocks_);
+   blocks_.back().offset_ = mark.offset_;
+}
+
+void ScratchArena::ResetBlocks()
+{
+   if (blocks_.size() > 1u)
+   {
+      size_t totalSize = 0u;
+      for (const Block& block : blocks_)
+      {
+         totalSize += block.size_;
+      }
+
+      blocks_.clear();
+      AddBlock(totalSize);
+   }
+   else if (!blocks_.empty())
+   {
+      blocks_.back().offset_ = 0u;
+   }
+}
+
+size_t ScratchArena::capacity() const
+{
+   std::scoped_lock lock(mutex_);
+
+   size_t totalSize = 0u;
+   for (const Block& block : blocks_)
+   {
+      totalSize += block.size_;
+   }
+   return totalSize;
+}
+
+size_t ScratchArena::used() const
+{
+   std::scoped_lock lock(mutex_);
+
+   size_t totalUsed = 0u;
+   for (const Block& block : blocks_)
+   {
+      totalUsed += block.offset_;
+   }
+   return totalUsed;
+}
+
+void ScratchArena::AddBlock(size_t size)
+{
+   Block block;
+   block.memory_.reset(new uint8_t[size + SCRATCH_ALIGNMENT - 1u]);
+
+   // Align the start of the block, so that offsets are aligned to the block
+   uintptr_t address = reinterpret_cast<uintptr_t>(block.memory_.get());
+   uintptr_t aligned =
+      (address + SCRATCH_ALIGNMENT - 1u) & ~(uintptr_t(SCRATCH_ALIGNMENT) - 1u);
+
+   block.begin_  = block.memory_.get() + (aligned - address);
+   block.size_   = size;
+   block.offset_ = 0u;
+
+   blocks_.push_back(std::move(block));
+}
+
+} // namespace WorldEngine
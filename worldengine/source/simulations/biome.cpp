@@ -1,216 +1,148 @@
 #include "biome.h"
+#include "../parallel.h"
 
+#include <array>
 #include <iomanip>
-#include <map>
 
 #include <boost/log/trivial.hpp>
 
 namespace WorldEngine
 {
 
-void BiomeSimulation(World& world)
+static constexpr size_t NUM_TEMPERATURE_LEVELS =
+   static_cast<size_t>(TemperatureLevel::Count);
+static constexpr size_t NUM_HUMIDITY_LEVELS =
+   static_cast<size_t>(HumidityLevel::Count);
+static constexpr size_t NUM_BIOMES = static_cast<size_t>(Biome::BareRock) + 1u;
+
+/**
+ * @brief Biome of a land cell, indexed by temperature level and humidity level
+ */
+static constexpr Biome
+   BIOME_TABLE[NUM_TEMPERATURE_LEVELS][NUM_HUMIDITY_LEVELS] = {
+      // Polar
+      {Biome::PolarDesert,
+       Biome::Ice,
+       Biome::Ice,
+       Biome::Ice,
+       Biome::Ice,
+       Biome::Ice,
+       Biome::Ice,
+       Biome::Ice},
+      // Alpine
+      {Biome::SubpolarDryTundra,
+       Biome::SubpolarMoistTundra,
+       Biome::SubpolarWetTundra,
+       Biome::SubpolarRainTundra,
+       Biome::SubpolarRainTundra,
+       Biome::SubpolarRainTundra,
+       Biome::SubpolarRainTundra,
+       Biome::SubpolarRainTundra},
+      // Boreal
+      {Biome::BorealDesert,
+       Biome::BorealDryScrub,
+       Biome::BorealMoistForest,
+       Biome::BorealWetForest,
+       Biome::BorealRainForest,
+       Biome::BorealRainForest,
+       Biome::BorealRainForest,
+       Biome::BorealRainForest},
+      // Cool
+      {Biome::CoolTemperateDesert,
+       Biome::CoolTemperateDesertScrub,
+       Biome::CoolTemperateSteppe,
+       Biome::CoolTemperateMoistForest,
+       Biome::CoolTemperateWetForest,
+       Biome::CoolTemperateRainForest,
+       Biome::CoolTemperateRainForest,
+       Biome::CoolTemperateRainForest},
+      // Warm
+      {Biome::WarmTemperateDesert,
+       Biome::WarmTemperateDesertScrub,
+       Biome::WarmTemperateThornScrub,
+       Biome::WarmTemperateDryForest,
+       Biome::WarmTemperateMoistForest,
+       Biome::WarmTemperateWetForest,
+       Biome::WarmTemperateRainForest,
+       Biome::WarmTemperateRainForest},
+      // Subtropical
+      {Biome::SubtropicalDesert,
+       Biome::SubtropicalDesertScrub,
+       Biome::SubtropicalThornWoodland,
+       Biome::SubtropicalDryForest,
+       Biome::SubtropicalMoistForest,
+       Biome::SubtropicalWetForest,
+       Biome::SubtropicalRainForest,
+       Biome::SubtropicalRainForest},
+      // Tropical
+      {Biome::TropicalDesert,
+       Biome::TropicalDesertScrub,
+       Biome::TropicalThornWoodland,
+       Biome::TropicalVeryDryForest,
+       Biome::TropicalDryForest,
+       Biome::TropicalMoistForest,
+       Biome::TropicalWetForest,
+       Biome::TropicalRainForest}};
+
+void BiomeSimulation(World& world, ScratchArena* scratch)
 {
    BOOST_LOG_TRIVIAL(info) << "Biome simulation start";
 
    uint32_t width  = world.width();
    uint32_t height = world.height();
 
-   BiomeArrayType& biome = world.GetBiomeData();
-   biome.resize(boost::extents[height][width]);
+   ScratchArena  localScratch;
+   ScratchArena& arena = (scratch != nullptr) ? *scratch : localScratch;
+   ScratchScope  scope(arena);
 
-   std::map<Biome, uint32_t> biomeCounts;
+   LayerView<uint8_t> temperatureLevels =
+      arena.AllocateLayer<uint8_t>(width, height);
+   LayerView<uint8_t> humidityLevels =
+      arena.AllocateLayer<uint8_t>(width, height);
 
-   for (uint32_t y = 0; y < height; y++)
-   {
-      for (uint32_t x = 0; x < width; x++)
-      {
-         if (world.IsOcean(x, y))
-         {
-            biome[y][x] = Biome::Ocean;
-         }
-         else
-         {
-            TemperatureLevel temperature   = world.GetTemperatureLevel(x, y);
-            HumidityLevel    humidityLevel = world.GetHumidityLevel(x, y);
-
-            switch (temperature)
-            {
-            case TemperatureLevel::Polar:
-               switch (humidityLevel)
-               {
-               case HumidityLevel::Superarid:
-                  biome[y][x] = Biome::PolarDesert;
-                  break;
-               default: //
-                  biome[y][x] = Biome::Ice;
-                  break;
-               }
-               break;
-
-            case TemperatureLevel::Alpine:
-               switch (humidityLevel)
-               {
-               case HumidityLevel::Superarid:
-                  biome[y][x] = Biome::SubpolarDryTundra;
-                  break;
-               case HumidityLevel::Perarid:
-                  biome[y][x] = Biome::SubpolarMoistTundra;
-                  break;
-               case HumidityLevel::Arid:
-                  biome[y][x] = Biome::SubpolarWetTundra;
-                  break;
-               default: //
-                  biome[y][x] = Biome::SubpolarRainTundra;
-                  break;
-               }
-               break;
-
-            case TemperatureLevel::Boreal:
-               switch (humidityLevel)
-               {
-               case HumidityLevel::Superarid:
-                  biome[y][x] = Biome::BorealDesert;
-                  break;
-               case HumidityLevel::Perarid:
-                  biome[y][x] = Biome::BorealDryScrub;
-                  break;
-               case HumidityLevel::Arid:
-                  biome[y][x] = Biome::BorealMoistForest;
-                  break;
-               case HumidityLevel::Semiarid:
-                  biome[y][x] = Biome::BorealWetForest;
-                  break;
-               default: //
-                  biome[y][x] = Biome::BorealRainForest;
-                  break;
-               }
-               break;
-
-            case TemperatureLevel::Cool:
-               switch (humidityLevel)
-               {
-               case HumidityLevel::Superarid:
-                  biome[y][x] = Biome::CoolTemperateDesert;
-                  break;
-               case HumidityLevel::Perarid:
-                  biome[y][x] = Biome::CoolTemperateDesertScrub;
-                  break;
-               case HumidityLevel::Arid:
-                  biome[y][x] = Biome::CoolTemperateSteppe;
-                  break;
-               case HumidityLevel::Semiarid:
-                  biome[y][x] = Biome::CoolTemperateMoistForest;
-                  break;
-               case HumidityLevel::Subhumid:
-                  biome[y][x] = Biome::CoolTemperateWetForest;
-                  break;
-               default: //
-                  biome[y][x] = Biome::CoolTemperateRainForest;
-                  break;
-               }
-               break;
-
-            case TemperatureLevel::Warm:
-               switch (humidityLevel)
-               {
-               case HumidityLevel::Superarid:
-                  biome[y][x] = Biome::WarmTemperateDesert;
-                  break;
-               case HumidityLevel::Perarid:
-                  biome[y][x] = Biome::WarmTemperateDesertScrub;
-                  break;
-               case HumidityLevel::Arid:
-                  biome[y][x] = Biome::WarmTemperateThornScrub;
-                  break;
-               case HumidityLevel::Semiarid:
-                  biome[y][x] = Biome::WarmTemperateDryForest;
-                  break;
-               case HumidityLevel::Subhumid:
-                  biome[y][x] = Biome::WarmTemperateMoistForest;
-                  break;
-               case HumidityLevel::Humid:
-                  biome[y][x] = Biome::WarmTemperateWetForest;
-                  break;
-               default: //
-                  biome[y][x] = Biome::WarmTemperateRainForest;
-                  break;
-               }
-               break;
-
-            case TemperatureLevel::Subtropical:
-               switch (humidityLevel)
-               {
-               case HumidityLevel::Superarid:
-                  biome[y][x] = Biome::SubtropicalDesert;
-                  break;
-               case HumidityLevel::Perarid:
-                  biome[y][x] = Biome::SubtropicalDesertScrub;
-                  break;
-               case HumidityLevel::Arid:
-                  biome[y][x] = Biome::SubtropicalThornWoodland;
-                  break;
-               case HumidityLevel::Semiarid:
-                  biome[y][x] = Biome::SubtropicalDryForest;
-                  break;
-               case HumidityLevel::Subhumid:
-                  biome[y][x] = Biome::SubtropicalMoistForest;
-                  break;
-               case HumidityLevel::Humid:
-                  biome[y][x] = Biome::SubtropicalWetForest;
-                  break;
-               default: //
-                  biome[y][x] = Biome::SubtropicalRainForest;
-                  break;
-               }
-               break;
-
-            case TemperatureLevel::Tropical:
-               switch (humidityLevel)
+   world.GetTemperatureLevels(temperatureLevels);
+   world.GetHumidityLevels(humidityLevels);
+
+   BiomeArrayType& biomeData = world.GetBiomeData();
+   biomeData.resize(boost::extents[height][width]);
+
+   LayerView<const OceanDataType> ocean = world.GetOceanView();
+   LayerView<Biome>               biome = world.GetBiomeView();
+
+   ParallelFor(0u,
+               height,
+               [&](uint32_t y)
                {
-               case HumidityLevel::Superarid:
-                  biome[y][x] = Biome::TropicalDesert;
-                  break;
-               case HumidityLevel::Perarid:
-                  biome[y][x] = Biome::TropicalDesertScrub;
-                  break;
-               case HumidityLevel::Arid:
-                  biome[y][x] = Biome::TropicalThornWoodland;
-                  break;
-               case HumidityLevel::Semiarid:
-                  biome[y][x] = Biome::TropicalVeryDryForest;
-                  break;
-               case HumidityLevel::Subhumid:
-                  biome[y][x] = Biome::TropicalDryForest;
-                  break;
-               case HumidityLevel::Humid:
-                  biome[y][x] = Biome::TropicalMoistForest;
-                  break;
-               case HumidityLevel::Perhumid:
-                  biome[y][x] = Biome::TropicalWetForest;
-                  break;
-               default: //
-                  biome[y][x] = Biome::TropicalRainForest;
-                  break;
-               }
-               break;
-
-            default: // Invalid
-               biome[y][x] = Biome::BareRock;
-               break;
-            }
-         }
-
-         biomeCounts[biome[y][x]]++;
-      }
+                  const bool*    oceanRow       = ocean[y];
+                  const uint8_t* temperatureRow = temperatureLevels[y];
+                  const uint8_t* humidityRow    = humidityLevels[y];
+                  Biome*         biomeRow       = biome[y];
+
+                  for (uint32_t x = 0; x < width; x++)
+                  {
+                     biomeRow[x] =
+                        oceanRow[x] ? Biome::Ocean
+                                    : BIOME_TABLE[temperatureRow[x]] //
+                                                 [humidityRow[x]];
+                  }
+               });
+
+   std::array<uint32_t, NUM_BIOMES> biomeCounts {};
+   for (size_t i = 0; i < biome.size(); i++)
+   {
+      biomeCounts[static_cast<size_t>(biome.data()[i])]++;
    }
 
    BOOST_LOG_TRIVIAL(debug) << "Biome obtained:";
-   for (auto const& bc : biomeCounts)
+   for (size_t i = 0; i < NUM_BIOMES; i++)
    {
-      BOOST_LOG_TRIVIAL(debug)
-         << "  " << std::left << std::setw(30) << std::setfill(' ') << bc.first
-         << ": " << std::right << std::setw(7) << std::setfill(' ')
-         << bc.second;
+      if (biomeCounts[i] > 0u)
+      {
+         BOOST_LOG_TRIVIAL(debug)
+            << "  " << std::left << std::setw(30) << std::setfill(' ')
+            << static_cast<Biome>(i) << ": " << std::right << std::setw(7)
+            << std::setfill(' ') << biomeCounts[i];
+      }
    }
 
    BOOST_LOG_TRIVIAL(info) << "Biome simulation finish";
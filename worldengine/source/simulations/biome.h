@@ -1,10 +1,18 @@
 #pragma once
 
+#include "worldengine/scratch_arena.h"
 #include "worldengine/world.h"
 
 namespace WorldEngine
 {
 
-void BiomeSimulation(World& world);
+/**
+ * @brief Classify the biome of each cell from its temperature and humidity
+ * levels
+ * @param world A world having oceans, temperature and humidity
+ * @param scratch Arena for temporary layers, which are released before
+ * returning, or nullptr to allocate them for this call only
+ */
+void BiomeSimulation(World& world, ScratchArena* scratch = nullptr);
 
 } // namespace WorldEngine
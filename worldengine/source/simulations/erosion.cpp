@@ -1,7 +1,12 @@
 #include "erosion.h"
+#include "../parallel.h"
 #include "../path.h"
 
+#include <algorithm>
+#include <list>
 #include <map>
+#include <tuple>
+#include <vector>
 
 #include <boost/log/trivial.hpp>
 
@@ -20,8 +25,64 @@ enum class Direction
 typedef float     WaterFlowDataType;
 typedef Direction WaterPathDataType;
 
-typedef boost::multi_array<WaterFlowDataType, 2> WaterFlowArrayType;
-typedef boost::multi_array<WaterPathDataType, 2> WaterPathArrayType;
+typedef LayerView<WaterFlowDataType> WaterFlowLayerType;
+typedef LayerView<WaterPathDataType> WaterPathLayerType;
+
+typedef std::vector<Point> RiverPath;
+
+/**
+ * @brief Location of a cell along the rivers found so far
+ */
+struct RiverIndexEntry
+{
+   int32_t river_;    //!< Index of the first river through the cell, or -1
+   int32_t position_; //!< Index of the cell's first occurrence in the river
+};
+
+/**
+ * @brief Lake formed while tracing a river
+ */
+struct LakeCandidate
+{
+   size_t checkpoint_; //!< Checkpoint after which the lake formed
+   Point  location_;   //!< Location of the lake
+   bool   unique_;     //!< Skip if the same as the previous lake
+};
+
+/**
+ * @brief Path of a river traced without regard for other rivers, and the
+ * points at which it may merge into another river
+ */
+struct RiverTrace
+{
+   RiverPath                  path_;
+   std::vector<size_t>        checkpoints_; //!< Path length at each merge check
+   std::vector<LakeCandidate> lakes_;
+};
+
+typedef LayerView<RiverIndexEntry> RiverIndexLayerType;
+typedef LayerView<int32_t>         RiverCellsLayerType;
+typedef LayerView<int32_t>         ReceiverLayerType;
+
+/**
+ * @brief Priority-flood queue entry
+ */
+struct FloodNode
+{
+   float    elevation_; //!< Filled elevation
+   uint32_t sequence_;  //!< Order in which the entry was queued
+   int32_t  index_;     //!< Cell index
+};
+
+/**
+ * @brief Heap ordering, placing the lowest elevation on top. Equal elevations
+ * are resolved in favor of the earliest queued cell.
+ */
+static bool operator<(const FloodNode& lhs, const FloodNode& rhs)
+{
+   return lhs.elevation_ > rhs.elevation_ ||
+          (lhs.elevation_ == rhs.elevation_ && lhs.sequence_ > rhs.sequence_);
+}
 
 static const std::unordered_map<Direction, Point> directionMap_ = {
    {Direction::Center, {0, 0}},
@@ -39,6 +100,9 @@ static bool wrap_ = true;
 
 static const float RIVER_THRESHOLD = 0.02f;
 
+// Number of river batches per thread, each reusing one path finder
+static const uint32_t RIVER_BATCHES_PER_THREAD = 4u;
+
 /**
  * @brief Try to find a lower elevation within a range of an increasing circle's
  * radius, try to find the best path, and return it
@@ -85,40 +149,114 @@ static bool InCircle(
  * @param world
  * @param waterPath
  */
-static void FindWaterFlow(const World& world, WaterPathArrayType& waterPath);
+static void FindWaterFlow(const World& world, WaterPathLayerType waterPath);
 
 /**
  * @brief Find places on map where sources of river can be found
  * @param world
  * @param waterPath
  * @param waterFlow
+ * @param arena Scratch storage
  * @return River sources
  */
-static std::list<Point> RiverSources(const World&              world,
-                                     const WaterPathArrayType& waterPath,
-                                     WaterFlowArrayType&       waterFlow);
+static std::vector<Point>
+RiverSources(const World&                       world,
+             LayerView<const WaterPathDataType> waterPath,
+             WaterFlowLayerType                 waterFlow,
+             ScratchArena&                      arena);
+
+/**
+ * @brief Add a river to the river index. Cells already belonging to an earlier
+ * river, or occurring earlier in the same river, are left unchanged.
+ * @param riverIndex
+ * @param river
+ * @param riverId Index of the river in the river list
+ */
+static void RiverIndexAdd(RiverIndexLayerType riverIndex,
+                          const RiverPath&    river,
+                          int32_t             riverId);
+
+/**
+ * @brief Fill depressions with a priority-flood from the sea, and assign each
+ * cell the neighbor it drains to over the filled surface.
+ *
+ * Barnes, R., Lehman, C., Mulla, D., 2014. Priority-Flood: An Optimal
+ * Depression-Filling and Watershed-Labeling Algorithm for Digital Elevation
+ * Models.
+ *
+ * @param world
+ * @param filled Filled elevation, never lower than the elevation
+ * @param receiver Index of the neighbor each cell drains to, or -1 for cells
+ * where water leaves the map (the sea, or the lowest cell of a world without
+ * sea)
+ * @param arena Scratch storage
+ */
+static void PriorityFlood(const World&      world,
+                          LayerView<float>  filled,
+                          ReceiverLayerType receiver,
+                          ScratchArena&     arena);
+
+/**
+ * @brief Find the river adjacent to a location
+ * @param world
+ * @param x
+ * @param y
+ * @param riverIndex Index of the cells in the river list
+ * @return First river adjacent to the location, with a river of -1 if there is
+ * none
+ */
+static RiverIndexEntry
+FindAdjacentRiver(const World&                     world,
+                  int32_t                          x,
+                  int32_t                          y,
+                  LayerView<const RiverIndexEntry> riverIndex);
 
 /**
  * @brief Simulate fluid dynamics by using starting point and flowing to the
- * lowest available point
+ * lowest available point. Other rivers are not considered, and are merged
+ * into by MergeRiverTrace.
  * @param world
  * @param source
- * @param riverList
- * @param lakeList
- * @return River flow path
+ * @param pathFinder Path finder owned by the calling task
+ * @param trace River flow path, checkpoints and lakes
  */
-static std::list<Point> RiverFlow(const World&                       world,
-                                  Point                              source,
-                                  const std::list<std::list<Point>>& riverList,
-                                  std::list<Point>&                  lakeList);
+static void RiverFlow(const World& world,
+                      Point        source,
+                      PathFinder&  pathFinder,
+                      RiverTrace&  trace);
 
 /**
- * @brief Validate that for each point in river is equal to or lower than the
- * last
+ * @brief Follow the receivers found by PriorityFlood from a starting point to
+ * the sea. Lakes form in the pits of the unfilled elevation that the river
+ * passes through. Other rivers are not considered, and are merged into by
+ * MergeRiverTrace.
  * @param world
- * @param river
+ * @param source
+ * @param filled Filled elevation
+ * @param receiver Receiver of each cell
+ * @param trace River flow path, checkpoints and lakes
  */
-static void CleanUpFlow(World& world, std::list<Point>& river);
+static void RiverFlowReceivers(const World&             world,
+                               Point                    source,
+                               LayerView<const float>   filled,
+                               LayerView<const int32_t> receiver,
+                               RiverTrace&              trace);
+
+/**
+ * @brief Merge a traced river into the first river it meets at a checkpoint,
+ * giving the same path and lakes as tracing it after the earlier rivers
+ * @param world
+ * @param trace Traced river, whose path is consumed
+ * @param riverList
+ * @param riverIndex Index of the cells in riverList
+ * @param lakeList
+ * @return River flow path
+ */
+static RiverPath MergeRiverTrace(const World&                     world,
+                                 RiverTrace&                      trace,
+                                 const std::vector<RiverPath>&    riverList,
+                                 LayerView<const RiverIndexEntry> riverIndex,
+                                 std::vector<Point>&              lakeList);
 
 /**
  * @brief Simulate erosion in heightmap based on river path.
@@ -127,8 +265,13 @@ static void CleanUpFlow(World& world, std::list<Point>& river);
  * - Sides of river are also eroded to slope into riverbed
  * @param world
  * @param river
+ * @param riverId Unique identifier of the river
+ * @param riverCells Scratch grid, set to riverId for cells within the river
  */
-static void RiverErosion(World& world, std::list<Point>& river);
+static void RiverErosion(World&              world,
+                         const RiverPath&    river,
+                         int32_t             riverId,
+                         RiverCellsLayerType riverCells);
 
 /**
  * @brief Update the river map with rainfall that is to become the waterflow
@@ -137,22 +280,32 @@ static void RiverErosion(World& world, std::list<Point>& river);
  * @param river
  * @param riverMap
  */
-static void RiverMapUpdate(const WaterFlowArrayType&     waterFlow,
-                           const PrecipitationArrayType& precipitations,
-                           const std::list<Point>&       river,
-                           RiverMapArrayType&            riverMap);
+static void RiverMapUpdate(LayerView<const WaterFlowDataType> waterFlow,
+                           const PrecipitationArrayType&      precipitations,
+                           const RiverPath&                   river,
+                           RiverMapArrayType&                 riverMap);
 
-void ErosionSimulation(World& world)
+void ErosionSimulation(World& world, ScratchArena* scratch, ErosionMode mode)
 {
    BOOST_LOG_TRIVIAL(info) << "Erosion simulation start";
 
    uint32_t width  = world.width();
    uint32_t height = world.height();
 
+   ScratchArena  localScratch;
+   ScratchArena& arena = (scratch != nullptr) ? *scratch : localScratch;
+   ScratchScope  scope(arena);
+
    const PrecipitationArrayType& precipitations = world.GetPrecipitationData();
 
-   WaterFlowArrayType waterFlow(precipitations);
-   WaterPathArrayType waterPath(boost::extents[height][width]);
+   WaterFlowLayerType waterFlow =
+      arena.AllocateLayer<WaterFlowDataType>(width, height);
+   WaterPathLayerType waterPath =
+      arena.AllocateLayer<WaterPathDataType>(width, height);
+
+   std::copy(precipitations.data(),
+             precipitations.data() + precipitations.num_elements(),
+             waterFlow.data());
 
    RiverMapArrayType& riverMap = world.GetRiverMapData();
    LakeMapArrayType&  lakeMap  = world.GetLakeMapData();
@@ -160,28 +313,87 @@ void ErosionSimulation(World& world)
    riverMap.resize(boost::extents[height][width]);
    lakeMap.resize(boost::extents[height][width]);
 
-   std::list<Point> riverSources;
+   // Clear rivers and lakes of a previous erosion
+   std::fill(riverMap.data(), riverMap.data() + riverMap.num_elements(), 0.0f);
+   std::fill(lakeMap.data(), lakeMap.data() + lakeMap.num_elements(), 0.0f);
+
+   std::vector<Point> riverSources;
+
+   std::vector<RiverPath> riverList;
+   std::vector<Point>     lakeList;
+
+   // First river through each cell, allowing new rivers to find and merge into
+   // existing rivers without searching each of them
+   RiverIndexLayerType riverIndex =
+      arena.AllocateLayer(width, height, RiverIndexEntry {-1, -1});
 
-   std::list<std::list<Point>> riverList;
-   std::list<Point>            lakeList;
+   // Filled elevation and drainage, when routing over a depression-free
+   // surface
+   LayerView<float>  filled;
+   ReceiverLayerType receiver;
+
+   if (mode == ErosionMode::PriorityFlood)
+   {
+      filled   = arena.AllocateLayer<float>(width, height);
+      receiver = arena.AllocateLayer<int32_t>(width, height);
+      PriorityFlood(world, filled, receiver, arena);
+   }
 
    // Step 1: Water flow per cell based on rainfall
    FindWaterFlow(world, waterPath);
 
    // Step 2: Find river sources (seeds)
-   riverSources = RiverSources(world, waterPath, waterFlow);
+   riverSources = RiverSources(world, waterPath, waterFlow, arena);
+
+   // Step 3: For each source, find a path to sea. Elevation is not modified
+   // until the rivers are eroded in step 4, so rivers only depend on earlier
+   // rivers where they merge. Each is traced independently, and merged in the
+   // order of their sources. Rivers are traced in interleaved batches, each
+   // reusing the search state of one path finder.
+   std::vector<RiverTrace> traces(riverSources.size());
+
+   const uint32_t numRivers  = static_cast<uint32_t>(riverSources.size());
+   const uint32_t numBatches =
+      std::min(numRivers, NumThreads() * RIVER_BATCHES_PER_THREAD);
+
+   ParallelFor(0u,
+               numBatches,
+               [&](uint32_t batch)
+               {
+                  PathFinder pathFinder;
 
-   // Step 3: For each source, find a path to sea
-   for (Point source : riverSources)
+                  for (uint32_t i = batch; i < numRivers; i += numBatches)
+                  {
+                     if (mode == ErosionMode::PriorityFlood)
+                     {
+                        RiverFlowReceivers(world,
+                                           riverSources[i],
+                                           filled,
+                                           receiver,
+                                           traces[i]);
+                     }
+                     else
+                     {
+                        RiverFlow(
+                           world, riverSources[i], pathFinder, traces[i]);
+                     }
+                  }
+               });
+
+   for (size_t i = 0; i < riverSources.size(); i++)
    {
-      std::list<Point> river = RiverFlow(world, source, riverList, lakeList);
+      Point     source = riverSources[i];
+      RiverPath river =
+         MergeRiverTrace(world, traces[i], riverList, riverIndex, lakeList);
       if (!river.empty())
       {
+         RiverIndexAdd(
+            riverIndex, river, static_cast<int32_t>(riverList.size()));
          riverList.push_back(river);
-         CleanUpFlow(world, river);
 
          Point riverEnd = river.back();
-         if (!world.IsOcean(riverEnd) && lakeList.back() != riverEnd)
+         if (!world.IsOcean(riverEnd) &&
+             (lakeList.empty() || lakeList.back() != riverEnd))
          {
             lakeList.push_back(riverEnd);
          }
@@ -192,10 +404,12 @@ void ErosionSimulation(World& world)
    }
 
    // Step 4: Simulate erosion and update river map
-   for (std::list<Point> river : riverList)
+   RiverCellsLayerType riverCells = arena.AllocateLayer(width, height, -1);
+
+   for (size_t i = 0; i < riverList.size(); i++)
    {
-      RiverErosion(world, river);
-      RiverMapUpdate(waterFlow, precipitations, river, riverMap);
+      RiverErosion(world, riverList[i], static_cast<int32_t>(i), riverCells);
+      RiverMapUpdate(waterFlow, precipitations, riverList[i], riverMap);
    }
 
    // Step 5: Rivers with no paths to sea form lakes
@@ -334,7 +548,7 @@ InCircle(int32_t radius, int32_t centerX, int32_t centerY, int32_t x, int32_t y)
    return squareDist <= radius * radius;
 }
 
-static void FindWaterFlow(const World& world, WaterPathArrayType& waterPath)
+static void FindWaterFlow(const World& world, WaterPathLayerType waterPath)
 {
    for (uint32_t y = 0; y < world.height(); y++)
    {
@@ -346,10 +560,15 @@ static void FindWaterFlow(const World& world, WaterPathArrayType& waterPath)
    }
 }
 
-static std::list<Point> RiverSources(const World&              world,
-                                     const WaterPathArrayType& waterPath,
-                                     WaterFlowArrayType&       waterFlow)
+static std::vector<Point>
+RiverSources(const World&                       world,
+             LayerView<const WaterPathDataType> waterPath,
+             WaterFlowLayerType                 waterFlow,
+             ScratchArena&                      arena)
 {
+   // Seeds are not created within this radius of another seed
+   static const int32_t seedRadius = 9;
+
    const int32_t width  = world.width();
    const int32_t height = world.height();
 
@@ -361,7 +580,46 @@ static std::list<Point> RiverSources(const World&              world,
     */
    const PrecipitationArrayType& precipitation = world.GetPrecipitationData();
 
-   std::list<Point> riverSources;
+   std::vector<Point> riverSources;
+
+   // Seeds bucketed by location, in buckets no smaller than the seed radius so
+   // that nearby seeds are in the same or an adjacent bucket
+   const int32_t        bucketsX = (width + seedRadius - 1) / seedRadius;
+   const int32_t        bucketsY = (height + seedRadius - 1) / seedRadius;
+   std::vector<int32_t> bucketHead(bucketsX * bucketsY, -1);
+   std::vector<int32_t> seedNext;
+
+   auto NeighborSeedFound = [&](int32_t cx, int32_t cy)
+   {
+      const int32_t bx = cx / seedRadius;
+      const int32_t by = cy / seedRadius;
+
+      for (int32_t ny = std::max(by - 1, 0);
+           ny <= std::min(by + 1, bucketsY - 1);
+           ny++)
+      {
+         for (int32_t nx = std::max(bx - 1, 0);
+              nx <= std::min(bx + 1, bucketsX - 1);
+              nx++)
+         {
+            for (int32_t s = bucketHead[ny * bucketsX + nx]; s >= 0;
+                 s         = seedNext[s])
+            {
+               const Point& seed = riverSources[s];
+               if (InCircle(seedRadius, cx, cy, seed.first, seed.second))
+               {
+                  return true;
+               }
+            }
+         }
+      }
+
+      return false;
+   };
+
+   // Walk which most recently visited each cell
+   LayerView<uint32_t> visited = arena.AllocateLayer(width, height, 0u);
+   uint32_t            walk    = 0u;
 
    // Step 1: Using flow direction, follow the path for each cell adding the
    // previous cell's flow to the current cell's flow.
@@ -386,46 +644,40 @@ static std::list<Point> RiverSources(const World&              world,
          int32_t cx = x;
          int32_t cy = y;
 
-         bool neighborSeedFound = false;
+         // Each step follows the flow direction of the starting location
+         int32_t dx;
+         int32_t dy;
+         std::tie(dx, dy) = directionMap_.at(waterPath[y][x]);
 
-         std::vector<Point> visited;
+         walk++;
 
          // Follow flow path to where it may lead
          while (true)
          {
             // If we have been here before, break out of the loop
-            if (std::find(visited.cbegin(), visited.cend(), Point(cx, cy)) !=
-                visited.cend())
+            if (visited[cy][cx] == walk)
             {
                break;
             }
 
             // Mark point as visited
-            visited.push_back(Point(cx, cy));
+            visited[cy][cx] = walk;
 
             // Have we found a seed?
             if (world.IsMountain(cx, cy) &&
                 waterFlow[cy][cx] >= RIVER_THRESHOLD)
             {
                // Try not to create seeds around other seeds
-               for (Point seed : riverSources)
-               {
-                  int32_t sx = seed.first;
-                  int32_t sy = seed.second;
-
-                  if (InCircle(9, cx, cy, sx, sy))
-                  {
-                     neighborSeedFound = true;
-                     break;
-                  }
-               }
-
-               if (neighborSeedFound)
+               if (NeighborSeedFound(cx, cy))
                {
                   // We do not want seeds for neighbors
                   break;
                }
 
+               int32_t bucket = (cy / seedRadius) * bucketsX + cx / seedRadius;
+               seedNext.push_back(bucketHead[bucket]);
+               bucketHead[bucket] = static_cast<int32_t>(riverSources.size());
+
                riverSources.push_back({cx, cy});
                break;
             }
@@ -436,11 +688,6 @@ static std::list<Point> RiverSources(const World&              world,
                break;
             }
 
-            // Follow path, add water flow from previous cell
-            int32_t dx;
-            int32_t dy;
-            std::tie(dx, dy) = directionMap_.at(waterPath[y][x]);
-
             // Calculate next cell
             int32_t nx = cx + dx;
             int32_t ny = cy + dy;
@@ -466,13 +713,39 @@ static std::list<Point> RiverSources(const World&              world,
    return riverSources;
 }
 
-static std::list<Point> RiverFlow(const World&                       world,
-                                  Point                              source,
-                                  const std::list<std::list<Point>>& riverList,
-                                  std::list<Point>&                  lakeList)
+static void RiverIndexAdd(RiverIndexLayerType riverIndex,
+                          const RiverPath&    river,
+                          int32_t             riverId)
 {
-   Point            currentLocation = source;
-   std::list<Point> path;
+   const int32_t width  = static_cast<int32_t>(riverIndex.width());
+   const int32_t height = static_cast<int32_t>(riverIndex.height());
+
+   for (size_t i = 0; i < river.size(); i++)
+   {
+      const int32_t x = river[i].first;
+      const int32_t y = river[i].second;
+
+      if (x < 0 || x >= width || y < 0 || y >= height)
+      {
+         continue;
+      }
+
+      RiverIndexEntry& entry = riverIndex[y][x];
+      if (entry.river_ < 0)
+      {
+         entry.river_    = riverId;
+         entry.position_ = static_cast<int32_t>(i);
+      }
+   }
+}
+
+static void RiverFlow(const World& world,
+                      Point        source,
+                      PathFinder&  pathFinder,
+                      RiverTrace&  trace)
+{
+   Point      currentLocation = source;
+   RiverPath& path            = trace.path_;
 
    path.push_back(source);
 
@@ -483,42 +756,7 @@ static std::list<Point> RiverFlow(const World&                       world,
       int32_t y = currentLocation.second;
 
       // If there is a nearby river, flow into it
-      for (Direction direction : dirNeighbors_)
-      {
-         int32_t dx;
-         int32_t dy;
-         std::tie(dx, dy) = directionMap_.at(direction);
-
-         int32_t ax = x + dx;
-         int32_t ay = y + dy;
-
-         if (wrap_)
-         {
-            ax %= world.width();
-            ay %= world.height();
-         }
-
-         for (std::list<Point> river : riverList)
-         {
-            if (std::find(river.begin(), river.end(), std::make_pair(ax, ay)) !=
-                river.end())
-            {
-               bool merge = false;
-
-               for (Point r : river)
-               {
-                  if (r == std::make_pair(ax, ay) || merge)
-                  {
-                     merge = true;
-                     path.push_back(r);
-                  }
-               }
-
-               // Skip the rest, return path
-               return path;
-            }
-         }
-      }
+      trace.checkpoints_.push_back(path.size());
 
       // Found at sea?
       if (world.IsOcean(x, y))
@@ -548,11 +786,11 @@ static std::list<Point> RiverFlow(const World&                       world,
          FindLowerElevation(world, x, y);
       if (foundLowerElevation && !isWrapped)
       {
-         std::list<Point> lowerPath =
-            FindPath(world.GetElevationData(), currentLocation, lowerElevation);
+         std::vector<Point> lowerPath = pathFinder.FindPath(
+            world.GetElevationData(), currentLocation, lowerElevation);
          if (!lowerPath.empty())
          {
-            path.splice(path.end(), lowerPath);
+            path.insert(path.end(), lowerPath.begin(), lowerPath.end());
             currentLocation = path.back();
          }
          else
@@ -609,28 +847,25 @@ static std::list<Point> RiverFlow(const World&                       world,
          }
 
          // Find our way to the edge
-         std::list<Point> edgePath =
-            FindPath(world.GetElevationData(), currentLocation, {lx, ly});
+         std::vector<Point> edgePath = pathFinder.FindPath(
+            world.GetElevationData(), currentLocation, {lx, ly});
          if (edgePath.empty())
          {
             // Can't find a path, make it a lake
-            lakeList.push_back(currentLocation);
+            trace.lakes_.push_back(
+               {trace.checkpoints_.size() - 1u, currentLocation, false});
             break;
          }
-         path.splice(path.end(), edgePath); // Add our newly found path
+         // Add our newly found path
+         path.insert(path.end(), edgePath.begin(), edgePath.end());
          path.push_back({nx, ny}); // Finally add our overflow to the other side
          currentLocation = path.back();
-
-         // Find our way to the lowest position originally found
-         std::list<Point> lowerPath =
-            FindPath(world.GetElevationData(), currentLocation, lowerElevation);
-         path.splice(path.end(), edgePath);
-         currentLocation = path.back();
       }
       else
       {
          // Can't find any other path, make it a lake
-         lakeList.push_back(currentLocation);
+         trace.lakes_.push_back(
+            {trace.checkpoints_.size() - 1u, currentLocation, false});
          break; // End of river
       }
 
@@ -640,38 +875,306 @@ static std::list<Point> RiverFlow(const World&                       world,
             << "RiverFlow: Out of bounds coordinates detected";
       }
    }
-
-   return path;
 }
 
-static void CleanUpFlow(World& world, std::list<Point>& river)
+static void PriorityFlood(const World&      world,
+                          LayerView<float>  filled,
+                          ReceiverLayerType receiver,
+                          ScratchArena&     arena)
 {
-   ElevationArrayType e = world.GetElevationData();
+   static const uint32_t unvisited = UINT32_MAX;
+   static const uint32_t queued    = UINT32_MAX - 1u;
 
-   float cElevation = 1.0;
+   // North, east, south, west
+   static const int32_t offsets[4][2] = {{0, -1}, {1, 0}, {0, 1}, {-1, 0}};
 
-   for (Point r : river)
+   const int32_t width    = world.width();
+   const int32_t height   = world.height();
+   const int32_t numCells = width * height;
+
+   const ElevationDataType* elevation = world.GetElevationData().data();
+   const OceanDataType*     ocean     = world.GetOceanData().data();
+   float*                   f         = filled.data();
+   int32_t*                 r         = receiver.data();
+
+   // Order in which each cell was removed from the queues
+   uint32_t* order = arena.AllocateLayer(width, height, unvisited).data();
+
+   // Cells raised to the level of the surrounding spill point are processed in
+   // FIFO order, each being queued at most once
+   int32_t* pit     = arena.AllocateLayer<int32_t>(width, height).data();
+   int32_t  pitHead = 0;
+   int32_t  pitTail = 0;
+
+   std::vector<FloodNode> open;
+   uint32_t               sequence = 0u;
+
+   auto Neighbor = [&](int32_t index, size_t direction) -> int32_t
    {
-      int32_t rx         = r.first;
-      int32_t ry         = r.second;
-      float&  rElevation = e[ry][rx];
-      if (rElevation <= cElevation)
+      int32_t nx = index % width + offsets[direction][0];
+      int32_t ny = index / width + offsets[direction][1];
+
+      if (wrap_)
+      {
+         nx = (nx + width) % width;
+         ny = (ny + height) % height;
+      }
+      else if (nx < 0 || nx >= width || ny < 0 || ny >= height)
       {
-         cElevation = rElevation;
+         return -1;
+      }
+
+      return ny * width + nx;
+   };
+
+   // Water leaves the map through the sea
+   int32_t lowest = 0;
+   for (int32_t i = 0; i < numCells; i++)
+   {
+      if (ocean[i])
+      {
+         f[i]     = elevation[i];
+         order[i] = queued;
+         open.push_back({f[i], sequence++, i});
+      }
+      if (elevation[i] < elevation[lowest])
+      {
+         lowest = i;
+      }
+   }
+
+   // Without sea, water collects at the lowest cell
+   if (open.empty() && numCells > 0)
+   {
+      f[lowest]     = elevation[lowest];
+      order[lowest] = queued;
+      open.push_back({f[lowest], sequence++, lowest});
+   }
+
+   std::make_heap(open.begin(), open.end());
+
+   uint32_t numVisited = 0u;
+   while (pitHead < pitTail || !open.empty())
+   {
+      int32_t c;
+      if (pitHead < pitTail)
+      {
+         c = pit[pitHead++];
       }
       else
       {
-         rElevation = cElevation;
+         c = open.front().index_;
+         std::pop_heap(open.begin(), open.end());
+         open.pop_back();
+      }
+
+      order[c] = numVisited++;
+
+      for (size_t d = 0; d < 4u; d++)
+      {
+         int32_t n = Neighbor(c, d);
+         if (n < 0 || order[n] != unvisited)
+         {
+            continue;
+         }
+
+         order[n] = queued;
+
+         if (elevation[n] <= f[c])
+         {
+            // Within a depression, raise to the spill level
+            f[n]           = f[c];
+            pit[pitTail++] = n;
+         }
+         else
+         {
+            f[n] = elevation[n];
+            open.push_back({f[n], sequence++, n});
+            std::push_heap(open.begin(), open.end());
+         }
+      }
+   }
+
+   // Each cell drains to its lowest neighbor on the filled surface that was
+   // flooded before it, which always includes the neighbor it was reached
+   // from. Receivers therefore lead to the sea without cycles, and only the
+   // first cell flooded in a world without sea has no receiver.
+   for (int32_t c = 0; c < numCells; c++)
+   {
+      r[c] = -1;
+
+      if (ocean[c])
+      {
+         continue;
+      }
+
+      for (size_t d = 0; d < 4u; d++)
+      {
+         int32_t n = Neighbor(c, d);
+         if (n < 0 || order[n] >= order[c])
+         {
+            continue;
+         }
+
+         if (r[c] < 0 || f[n] < f[r[c]] ||
+             (f[n] == f[r[c]] && order[n] < order[r[c]]))
+         {
+            r[c] = n;
+         }
+      }
+   }
+}
+
+static RiverIndexEntry
+FindAdjacentRiver(const World&                     world,
+                  int32_t                          x,
+                  int32_t                          y,
+                  LayerView<const RiverIndexEntry> riverIndex)
+{
+   for (Direction direction : dirNeighbors_)
+   {
+      int32_t dx;
+      int32_t dy;
+      std::tie(dx, dy) = directionMap_.at(direction);
+
+      int32_t ax = x + dx;
+      int32_t ay = y + dy;
+
+      if (wrap_)
+      {
+         ax %= world.width();
+         ay %= world.height();
+      }
+
+      if (!world.Contains(ax, ay))
+      {
+         continue;
+      }
+
+      const RiverIndexEntry& entry = riverIndex[ay][ax];
+      if (entry.river_ >= 0)
+      {
+         return entry;
       }
    }
+
+   return {-1, -1};
 }
 
-static void RiverErosion(World& world, std::list<Point>& river)
+static void RiverFlowReceivers(const World&             world,
+                               Point                    source,
+                               LayerView<const float>   filled,
+                               LayerView<const int32_t> receiver,
+                               RiverTrace&              trace)
+{
+   const ElevationArrayType& elevation = world.GetElevationData();
+   const int32_t             width     = world.width();
+
+   Point      currentLocation = source;
+   RiverPath& path            = trace.path_;
+
+   path.push_back(source);
+
+   while (true)
+   {
+      int32_t x = currentLocation.first;
+      int32_t y = currentLocation.second;
+
+      // If there is a nearby river, flow into it
+      trace.checkpoints_.push_back(path.size());
+
+      // Found at sea?
+      if (world.IsOcean(x, y))
+      {
+         break;
+      }
+
+      int32_t next = receiver[y][x];
+      if (next < 0)
+      {
+         // No sea to flow to, make it a lake
+         trace.lakes_.push_back(
+            {trace.checkpoints_.size() - 1u, currentLocation, false});
+         break;
+      }
+
+      // A pit in a filled depression holds a lake, which the river flows on
+      // from once full
+      if (elevation[y][x] < filled[y][x] &&
+          std::get<0>(FindQuickPath(world, x, y)) == Direction::Center)
+      {
+         trace.lakes_.push_back(
+            {trace.checkpoints_.size() - 1u, currentLocation, true});
+      }
+
+      currentLocation = {next % width, next / width};
+      path.push_back(currentLocation);
+   }
+}
+
+static RiverPath MergeRiverTrace(const World&                     world,
+                                 RiverTrace&                      trace,
+                                 const std::vector<RiverPath>&    riverList,
+                                 LayerView<const RiverIndexEntry> riverIndex,
+                                 std::vector<Point>&              lakeList)
+{
+   RiverPath& path = trace.path_;
+
+   // Find the first checkpoint adjacent to an earlier river
+   size_t          merge = trace.checkpoints_.size();
+   RiverIndexEntry entry = {-1, -1};
+
+   for (size_t i = 0; i < trace.checkpoints_.size(); i++)
+   {
+      const Point& p = path[trace.checkpoints_[i] - 1u];
+
+      entry = FindAdjacentRiver(world, p.first, p.second, riverIndex);
+      if (entry.river_ >= 0)
+      {
+         merge = i;
+         break;
+      }
+   }
+
+   // Lakes form after the merge check at their checkpoint
+   for (const LakeCandidate& lake : trace.lakes_)
+   {
+      if (lake.checkpoint_ < merge &&
+          (!lake.unique_ || lakeList.empty() ||
+           lakeList.back() != lake.location_))
+      {
+         lakeList.push_back(lake.location_);
+      }
+   }
+
+   if (merge < trace.checkpoints_.size())
+   {
+      // Merge with the river from the point of contact
+      const RiverPath& river = riverList[entry.river_];
+      path.resize(trace.checkpoints_[merge]);
+      path.insert(path.end(), river.begin() + entry.position_, river.end());
+   }
+
+   return std::move(path);
+}
+
+static void RiverErosion(World&              world,
+                         const RiverPath&    river,
+                         int32_t             riverId,
+                         RiverCellsLayerType riverCells)
 {
    const int32_t radius = 2;
 
    ElevationArrayType& e = world.GetElevationData();
 
+   for (Point r : river)
+   {
+      if (world.Contains(r.first, r.second))
+      {
+         riverCells[r.second][r.first] = riverId;
+      }
+   }
+
    // Erosion around river, create river valley
    for (Point r : river)
    {
@@ -691,8 +1194,7 @@ static void RiverErosion(World& world, std::list<Point>& river)
             int32_t wx = x % world.width();
             int32_t wy = y % world.width();
 
-            if (std::find(river.begin(), river.end(), std::make_pair(wx, wy)) !=
-                river.end())
+            if (world.Contains(wx, wy) && riverCells[wy][wx] == riverId)
             {
                // Ignore points within the river
                continue;
@@ -740,10 +1242,10 @@ static void RiverErosion(World& world, std::list<Point>& river)
    }
 }
 
-static void RiverMapUpdate(const WaterFlowArrayType&     waterFlow,
-                           const PrecipitationArrayType& precipitations,
-                           const std::list<Point>&       river,
-                           RiverMapArrayType&            riverMap)
+static void RiverMapUpdate(LayerView<const WaterFlowDataType> waterFlow,
+                           const PrecipitationArrayType&      precipitations,
+                           const RiverPath&                   river,
+                           RiverMapArrayType&                 riverMap)
 {
    bool    isSeed = true;
    int32_t px     = 0;
@@ -1,10 +1,22 @@
 #pragma once
 
+#include "worldengine/scratch_arena.h"
 #include "worldengine/world.h"
 
 namespace WorldEngine
 {
 
-void ErosionSimulation(World& world);
+/**
+ * @brief Simulate river erosion, forming rivers and lakes
+ * @param world A world having elevation, oceans and precipitation
+ * @param scratch Arena for temporary layers, which are released before
+ * returning, or nullptr to allocate them for this call only
+ * @param mode Search routes rivers out of pits by searching for lower
+ * elevation. PriorityFlood fills depressions once, and routes every cell to the
+ * sea along the filled surface.
+ */
+void ErosionSimulation(World&        world,
+                       ScratchArena* scratch = nullptr,
+                       ErosionMode   mode    = ErosionMode::Search);
 
 } // namespace WorldEngine
@@ -12,29 +12,28 @@ void HumiditySimulation(World& world)
 {
    BOOST_LOG_TRIVIAL(info) << "Humidity simulation start";
 
+   HumidityCalculation(world);
+   HumidityThresholds(world);
+
+   BOOST_LOG_TRIVIAL(info) << "Humidity simulation finish";
+}
+
+void HumidityThresholds(World& world)
+{
    const OceanArrayType&    ocean = world.GetOceanData();
    const HumidityArrayType& h     = world.GetHumidityData();
 
-   HumidityCalculation(world);
+   std::vector<float> thresholds = FindThresholdsF(h, world.humids(), &ocean);
 
-   world.SetThreshold(HumidityLevel::Superarid,
-                      FindThresholdF(h, world.humids()[0], &ocean));
-   world.SetThreshold(HumidityLevel::Perarid,
-                      FindThresholdF(h, world.humids()[1], &ocean));
-   world.SetThreshold(HumidityLevel::Arid,
-                      FindThresholdF(h, world.humids()[2], &ocean));
-   world.SetThreshold(HumidityLevel::Semiarid,
-                      FindThresholdF(h, world.humids()[3], &ocean));
-   world.SetThreshold(HumidityLevel::Subhumid,
-                      FindThresholdF(h, world.humids()[4], &ocean));
-   world.SetThreshold(HumidityLevel::Humid,
-                      FindThresholdF(h, world.humids()[5], &ocean));
-   world.SetThreshold(HumidityLevel::Perhumid,
-                      FindThresholdF(h, world.humids()[6], &ocean));
+   world.SetThreshold(HumidityLevel::Superarid, thresholds[0]);
+   world.SetThreshold(HumidityLevel::Perarid, thresholds[1]);
+   world.SetThreshold(HumidityLevel::Arid, thresholds[2]);
+   world.SetThreshold(HumidityLevel::Semiarid, thresholds[3]);
+   world.SetThreshold(HumidityLevel::Subhumid, thresholds[4]);
+   world.SetThreshold(HumidityLevel::Humid, thresholds[5]);
+   world.SetThreshold(HumidityLevel::Perhumid, thresholds[6]);
    world.SetThreshold(HumidityLevel::Superhumid,
                       std::numeric_limits<float>::max());
-
-   BOOST_LOG_TRIVIAL(info) << "Humidity simulation finish";
 }
 
 static void HumidityCalculation(World& world)
@@ -45,17 +44,22 @@ static void HumidityCalculation(World& world)
    float precipitationWeight = 1.0f;
    float irrigationWeight    = 3.0f;
 
-   const PrecipitationArrayType& p = world.GetPrecipitationData();
-   const IrrigationArrayType&    i = world.GetIrrigationData();
-   HumidityArrayType&            h = world.GetHumidityData();
-   h.resize(boost::extents[height][width]);
+   world.GetHumidityData().resize(boost::extents[height][width]);
+
+   LayerView<const PrecipitationDataType> p = world.GetPrecipitationView();
+   LayerView<const IrrigationDataType>    i = world.GetIrrigationView();
+   LayerView<HumidityDataType>            h = world.GetHumidityView();
 
    for (uint32_t y = 0; y < height; y++)
    {
+      const PrecipitationDataType* pRow = p[y];
+      const IrrigationDataType*    iRow = i[y];
+      HumidityDataType*            hRow = h[y];
+
       for (uint32_t x = 0; x < width; x++)
       {
-         h[y][x] =
-            (p[y][x] * precipitationWeight - i[y][x] * irrigationWeight) /
+         hRow[x] =
+            (pRow[x] * precipitationWeight - iRow[x] * irrigationWeight) /
             (precipitationWeight + irrigationWeight);
       }
    }
@@ -7,4 +7,10 @@ namespace WorldEngine
 
 void HumiditySimulation(World& world);
 
+/**
+ * @brief Calculate the humidity level thresholds from the world's humids
+ * @param world A world having oceans and humidity
+ */
+void HumidityThresholds(World& world);
+
 } // namespace WorldEngine
@@ -1,6 +1,11 @@
 #include "hydrology.h"
 #include "../basic.h"
+#include "../parallel.h"
+#include "../random.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <random>
 
 #include <boost/log/trivial.hpp>
@@ -9,101 +14,253 @@
 namespace WorldEngine
 {
 
-static void Droplet(World& world, uint32_t x, uint32_t y, float q);
+/**
+ * @brief Neighbor of a cell which is lower than the cell
+ */
+struct Lower
+{
+   uint32_t share_; /**< Relative amount of water flowing to the neighbor */
+   uint32_t x_;
+   uint32_t y_;
+};
+
+/**
+ * @brief Water flowing from a cell, which remains to be distributed to its
+ * lower neighbors
+ */
+struct DropletFrame
+{
+   float    f_;         /**< Amount of water per share */
+   uint32_t numLowers_; /**< Number of lower neighbors */
+   uint32_t next_;      /**< Next lower neighbor to receive water */
+   Lower    lowers_[8];
+};
+
+/**
+ * @brief Find the neighbors lower than a cell, in the order returned by
+ * World::GetTilesAround
+ * @param world
+ * @param x
+ * @param y
+ * @param height Function returning the height of water at a cell
+ * @param lowers Lower neighbors
+ * @param totLowers Sum of shares of all lower neighbors
+ * @return Number of lower neighbors
+ */
+template<typename H>
+static uint32_t FindLowers(const World& world,
+                           uint32_t     x,
+                           uint32_t     y,
+                           H&&          height,
+                           Lower        lowers[8],
+                           uint32_t&    totLowers);
+
+/**
+ * @brief Follow a droplet of water downhill from a cell. Water is distributed
+ * to each lower neighbor depth first, in the same order as a recursive
+ * implementation.
+ * @param world
+ * @param stack Reusable stack of cells with water remaining to distribute
+ * @param x
+ * @param y
+ * @param q Amount of water
+ * @param height Function returning the height of water at a cell
+ * @param deposit Function adding water to a cell
+ */
+template<typename H, typename D>
+static void Droplet(const World&               world,
+                    std::vector<DropletFrame>& stack,
+                    uint32_t                   x,
+                    uint32_t                   y,
+                    float                      q,
+                    H&&                        height,
+                    D&&                        deposit);
 static void WatermapExecute(World& world, uint32_t numSamples, uint32_t seed);
 
+/**
+ * @brief Follow droplets from randomly sampled land cells in parallel. Each
+ * sample is chosen by a counter-based generator. Droplets follow the terrain
+ * without the water left by other droplets, and water is summed in fixed
+ * point, so the result does not depend on the order of the droplets.
+ * @param world
+ * @param numSamples Number of droplets
+ * @param seed
+ */
+static void
+WatermapExecuteCounter(World& world, uint32_t numSamples, uint32_t seed);
+
+/**
+ * @brief Route the rainfall of every land cell to its lower neighbors,
+ * visiting cells from highest to lowest elevation. Drainage basins, the sets of
+ * land cells connected by flow, are routed concurrently.
+ * @param world
+ * @param singleFlow Route all water to the lowest neighbor, instead of dividing
+ * it among all lower neighbors
+ */
+static void WatermapAccumulate(World& world, bool singleFlow);
+
 static const uint32_t NUM_SAMPLES = 20000u;
 
-void WatermapSimulation(World& world, uint32_t seed)
+// Water summed by parallel droplets is stored in units of 2^-32
+static const double DROPLET_FIXED_SCALE = 4294967296.0;
+
+// Number of tasks following parallel droplets
+static const uint32_t DROPLET_CHUNKS = 64u;
+
+void WatermapSimulation(World&       world,
+                        uint32_t     seed,
+                        WatermapMode mode,
+                        RandomMode   randomMode)
 {
    BOOST_LOG_TRIVIAL(info) << "Watermap simulation start";
 
    const WaterMapArrayType& watermap = world.GetWaterMapData();
    const OceanArrayType&    ocean    = world.GetOceanData();
 
-   WatermapExecute(world, NUM_SAMPLES, seed);
+   if (mode == WatermapMode::Accumulation ||
+       mode == WatermapMode::AccumulationD8)
+   {
+      WatermapAccumulate(world, mode == WatermapMode::AccumulationD8);
+   }
+   else if (randomMode == RandomMode::CounterBased)
+   {
+      WatermapExecuteCounter(world, NUM_SAMPLES, seed);
+   }
+   else
+   {
+      WatermapExecute(world, NUM_SAMPLES, seed);
+   }
+
+   std::vector<float> thresholds =
+      FindThresholdsF(watermap, {0.05f, 0.02f, 0.007f}, &ocean);
 
-   world.SetThreshold(WaterThreshold::Creek,
-                      FindThresholdF(watermap, 0.05f, &ocean));
-   world.SetThreshold(WaterThreshold::River,
-                      FindThresholdF(watermap, 0.02f, &ocean));
-   world.SetThreshold(WaterThreshold::MainRiver,
-                      FindThresholdF(watermap, 0.007f, &ocean));
+   world.SetThreshold(WaterThreshold::Creek, thresholds[0]);
+   world.SetThreshold(WaterThreshold::River, thresholds[1]);
+   world.SetThreshold(WaterThreshold::MainRiver, thresholds[2]);
 
    BOOST_LOG_TRIVIAL(info) << "Watermap simulation finish";
 }
 
-static void Droplet(World& world, uint32_t x, uint32_t y, float q)
+template<typename H>
+static uint32_t FindLowers(const World& world,
+                           uint32_t     x,
+                           uint32_t     y,
+                           H&&          height,
+                           Lower        lowers[8],
+                           uint32_t&    totLowers)
 {
-   if (q < 0)
-   {
-      return;
-   }
-
-   const ElevationArrayType& elevation = world.GetElevationData();
-   WaterMapArrayType&        watermap  = world.GetWaterMapData();
-
-   std::vector<std::pair<uint32_t, uint32_t>>            tilesAround;
-   std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> lowers;
+   const int32_t w = world.width();
+   const int32_t h = world.height();
 
-   float    posElev   = elevation[y][x] + watermap[y][x];
+   float    posElev   = height(x, y);
    float    minLower  = std::numeric_limits<float>::max();
-   uint32_t totLowers = 0;
+   uint32_t numLowers = 0;
 
-   world.GetTilesAround(tilesAround, x, y);
+   totLowers = 0;
 
-   for (const auto& p : tilesAround)
+   for (int32_t dx = -1; dx <= 1; dx++)
    {
-      uint32_t px = p.first;
-      uint32_t py = p.second;
-      float    e  = elevation[py][px] + watermap[py][px];
+      int32_t nx = static_cast<int32_t>(x) + dx;
+      if (nx < 0 || nx >= w)
+      {
+         continue;
+      }
 
-      if (e < posElev)
+      for (int32_t dy = -1; dy <= 1; dy++)
       {
-         uint32_t dq = static_cast<uint32_t>(posElev - e) << 2;
-         if (e < minLower)
+         int32_t ny = static_cast<int32_t>(y) + dy;
+         if (ny < 0 || ny >= h || (dx == 0 && dy == 0))
+         {
+            continue;
+         }
+
+         uint32_t px = static_cast<uint32_t>(nx);
+         uint32_t py = static_cast<uint32_t>(ny);
+         float    e  = height(px, py);
+
+         if (e < posElev)
          {
-            minLower = e;
-            if (dq == 0)
+            uint32_t dq = static_cast<uint32_t>(posElev - e) << 2;
+            if (e < minLower)
             {
-               dq = 1;
+               minLower = e;
+               if (dq == 0)
+               {
+                  dq = 1;
+               }
             }
+            lowers[numLowers++] = {dq, px, py};
+            totLowers += dq;
          }
-         lowers.push_back({dq, px, py});
-         totLowers += dq;
       }
    }
 
-   if (!lowers.empty())
+   return numLowers;
+}
+
+template<typename H, typename D>
+static void Droplet(const World&               world,
+                    std::vector<DropletFrame>& stack,
+                    uint32_t                   x,
+                    uint32_t                   y,
+                    float                      q,
+                    H&&                        height,
+                    D&&                        deposit)
+{
+   if (q < 0)
+   {
+      return;
+   }
+
+   auto Push = [&](uint32_t px, uint32_t py, float pq)
    {
-      float f = q / static_cast<float>(totLowers);
+      DropletFrame frame;
+      uint32_t     totLowers;
+
+      frame.numLowers_ =
+         FindLowers(world, px, py, height, frame.lowers_, totLowers);
 
-      for (const auto& t : lowers)
+      if (frame.numLowers_ == 0)
       {
-         uint32_t s;
-         uint32_t px;
-         uint32_t py;
+         deposit(px, py, pq);
+         return;
+      }
 
-         std::tie(s, px, py) = t;
+      frame.f_    = pq / static_cast<float>(totLowers);
+      frame.next_ = 0;
+      stack.push_back(frame);
+   };
 
-         if (!world.IsOcean(px, py))
-         {
-            float ql    = f * s;
-            bool  going = ql > 0.05f;
+   Push(x, y, q);
 
-            watermap[py][px] += ql;
+   while (!stack.empty())
+   {
+      DropletFrame& frame = stack.back();
 
-            if (going)
-            {
-               Droplet(world, px, py, ql);
-            }
+      if (frame.next_ == frame.numLowers_)
+      {
+         stack.pop_back();
+         continue;
+      }
+
+      const Lower& lower = frame.lowers_[frame.next_++];
+      uint32_t     px    = lower.x_;
+      uint32_t     py    = lower.y_;
+
+      if (!world.IsOcean(px, py))
+      {
+         float ql    = frame.f_ * lower.share_;
+         bool  going = ql > 0.05f;
+
+         deposit(px, py, ql);
+
+         if (going)
+         {
+            // Invalidates frame
+            Push(px, py, ql);
          }
       }
    }
-   else
-   {
-      watermap[y][x] += q;
-   }
 }
 
 static void WatermapExecute(World& world, uint32_t numSamples, uint32_t seed)
@@ -133,6 +290,16 @@ static void WatermapExecute(World& world, uint32_t numSamples, uint32_t seed)
 
    world.GetRandomLand(landSamples, numSamples, distribution(generator));
 
+   std::vector<DropletFrame> stack;
+   stack.reserve(64u);
+
+   const ElevationArrayType& elevation = world.GetElevationData();
+
+   auto Height = [&](uint32_t px, uint32_t py)
+   { return elevation[py][px] + watermap[py][px]; };
+   auto Deposit = [&](uint32_t px, uint32_t py, float pq)
+   { watermap[py][px] += pq; };
+
    for (uint32_t i = 0; i < landSamples.size(); i++)
    {
       uint32_t x = landSamples[i].first;
@@ -141,9 +308,273 @@ static void WatermapExecute(World& world, uint32_t numSamples, uint32_t seed)
 
       if (q > 0)
       {
-         Droplet(world, x, y, q);
+         Droplet(world, stack, x, y, q, Height, Deposit);
+      }
+   }
+}
+
+static void
+WatermapExecuteCounter(World& world, uint32_t numSamples, uint32_t seed)
+{
+   BOOST_LOG_TRIVIAL(debug) << "Seed: " << seed;
+
+   const uint32_t width  = world.width();
+   const uint32_t height = world.height();
+
+   const ElevationArrayType&     elevation      = world.GetElevationData();
+   const PrecipitationArrayType& precipitations = world.GetPrecipitationData();
+   WaterMapArrayType&            watermap       = world.GetWaterMapData();
+   watermap.resize(boost::extents[height][width]);
+
+   std::vector<uint32_t> land;
+   for (uint32_t y = 0; y < height; y++)
+   {
+      for (uint32_t x = 0; x < width; x++)
+      {
+         if (!world.IsOcean(x, y))
+         {
+            land.push_back(y * width + x);
+         }
       }
    }
+
+   std::vector<std::atomic<uint64_t>> water(watermap.num_elements());
+   for (std::atomic<uint64_t>& w : water)
+   {
+      w.store(0u, std::memory_order_relaxed);
+   }
+
+   if (!land.empty())
+   {
+      CounterRandom random(seed, static_cast<uint32_t>(Simulation::Watermap));
+
+      auto Height = [&](uint32_t px, uint32_t py)
+      { return elevation[py][px]; };
+      auto Deposit = [&](uint32_t px, uint32_t py, float pq)
+      {
+         water[py * width + px].fetch_add(
+            static_cast<uint64_t>(std::llround(pq * DROPLET_FIXED_SCALE)),
+            std::memory_order_relaxed);
+      };
+
+      const uint32_t numLand = static_cast<uint32_t>(land.size());
+
+      ParallelFor(0u,
+                  DROPLET_CHUNKS,
+                  [&](uint32_t chunk)
+                  {
+                     std::vector<DropletFrame> stack;
+                     stack.reserve(64u);
+
+                     for (uint32_t i = chunk; i < numSamples;
+                          i += DROPLET_CHUNKS)
+                     {
+                        uint32_t index = land[random.Below(numLand, i, 0u)];
+                        uint32_t x     = index % width;
+                        uint32_t y     = index / width;
+                        float    q     = precipitations[y][x];
+
+                        if (q > 0)
+                        {
+                           Droplet(world, stack, x, y, q, Height, Deposit);
+                        }
+                     }
+                  });
+   }
+
+   std::transform(water.begin(),
+                  water.end(),
+                  watermap.data(),
+                  [](const std::atomic<uint64_t>& w) -> float {
+                     return static_cast<float>(
+                        w.load(std::memory_order_relaxed) /
+                        DROPLET_FIXED_SCALE);
+                  });
+}
+
+static void WatermapAccumulate(World& world, bool singleFlow)
+{
+   static const uint32_t noBasin = UINT32_MAX;
+
+   const uint32_t width  = world.width();
+   const uint32_t height = world.height();
+
+   const ElevationArrayType&     elevation      = world.GetElevationData();
+   const PrecipitationArrayType& precipitations = world.GetPrecipitationData();
+   WaterMapArrayType&            watermap       = world.GetWaterMapData();
+   watermap.resize(boost::extents[height][width]);
+
+   std::fill(watermap.data(), watermap.data() + watermap.num_elements(), 0.0f);
+
+   auto Height = [&](uint32_t px, uint32_t py) { return elevation[py][px]; };
+
+   auto FindReceivers =
+      [&](uint32_t x, uint32_t y, Lower lowers[8], uint32_t& totLowers)
+   {
+      uint32_t numLowers = FindLowers(world, x, y, Height, lowers, totLowers);
+
+      if (singleFlow && numLowers > 0)
+      {
+         // Keep the first of the lowest neighbors
+         uint32_t lowest = 0;
+         for (uint32_t i = 1; i < numLowers; i++)
+         {
+            if (Height(lowers[i].x_, lowers[i].y_) <
+                Height(lowers[lowest].x_, lowers[lowest].y_))
+            {
+               lowest = i;
+            }
+         }
+
+         lowers[0]        = lowers[lowest];
+         lowers[0].share_ = 1;
+         totLowers        = 1;
+         numLowers        = 1;
+      }
+
+      return numLowers;
+   };
+
+   // Water flowing out of each cell, starting with its own rainfall
+   std::vector<float>    flow(watermap.num_elements(), 0.0f);
+   std::vector<uint32_t> order;
+   order.reserve(watermap.num_elements());
+
+   // Land cells connected by flow, as a disjoint set forest
+   std::vector<uint32_t> basin(watermap.num_elements(), noBasin);
+
+   auto FindBasin = [&](uint32_t index)
+   {
+      while (basin[index] != index)
+      {
+         basin[index] = basin[basin[index]];
+         index        = basin[index];
+      }
+      return index;
+   };
+
+   for (uint32_t y = 0; y < height; y++)
+   {
+      for (uint32_t x = 0; x < width; x++)
+      {
+         if (!world.IsOcean(x, y))
+         {
+            flow[y * width + x]  = std::max(precipitations[y][x], 0.0f);
+            basin[y * width + x] = y * width + x;
+            order.push_back(y * width + x);
+         }
+      }
+   }
+
+   Lower lowers[8];
+
+   for (uint32_t index : order)
+   {
+      uint32_t totLowers;
+      uint32_t numLowers =
+         FindReceivers(index % width, index / width, lowers, totLowers);
+
+      for (uint32_t i = 0; i < numLowers; i++)
+      {
+         uint32_t lower = lowers[i].y_ * width + lowers[i].x_;
+         if (basin[lower] != noBasin)
+         {
+            basin[FindBasin(index)] = FindBasin(lower);
+         }
+      }
+   }
+
+   // Water only flows to strictly lower cells, which are visited later
+   std::sort(order.begin(),
+             order.end(),
+             [&](uint32_t a, uint32_t b)
+             {
+                float ea = elevation[a / width][a % width];
+                float eb = elevation[b / width][b % width];
+                return ea > eb || (ea == eb && a < b);
+             });
+
+   // Group the cells of each basin, preserving elevation order within basins
+   std::vector<uint32_t> basinId(watermap.num_elements(), noBasin);
+   std::vector<uint32_t> basinOffset;
+
+   for (uint32_t index : order)
+   {
+      uint32_t& id = basinId[FindBasin(index)];
+      if (id == noBasin)
+      {
+         id = static_cast<uint32_t>(basinOffset.size());
+         basinOffset.push_back(0u);
+      }
+      basinOffset[id]++;
+   }
+
+   uint32_t numBasins = static_cast<uint32_t>(basinOffset.size());
+   uint32_t total     = 0u;
+   for (uint32_t& offset : basinOffset)
+   {
+      uint32_t count = offset;
+      offset         = total;
+      total += count;
+   }
+   basinOffset.push_back(total);
+
+   std::vector<uint32_t> basinOrder(order.size());
+   {
+      std::vector<uint32_t> next(basinOffset.begin(), basinOffset.end() - 1);
+      for (uint32_t index : order)
+      {
+         basinOrder[next[basinId[FindBasin(index)]]++] = index;
+      }
+   }
+
+   // Water never leaves its basin, so each cell receives water in the same
+   // order as when routing the whole map at once
+   ParallelFor(
+      0u,
+      numBasins,
+      [&](uint32_t b)
+      {
+         Lower lowers[8];
+
+         for (uint32_t i = basinOffset[b]; i < basinOffset[b + 1]; i++)
+         {
+            uint32_t index = basinOrder[i];
+            uint32_t x     = index % width;
+            uint32_t y     = index / width;
+            float    q     = flow[index];
+
+            if (q <= 0.0f)
+            {
+               continue;
+            }
+
+            uint32_t totLowers;
+            uint32_t numLowers = FindReceivers(x, y, lowers, totLowers);
+
+            if (numLowers == 0)
+            {
+               watermap[y][x] += q;
+               continue;
+            }
+
+            float f = q / static_cast<float>(totLowers);
+
+            for (uint32_t j = 0; j < numLowers; j++)
+            {
+               uint32_t px = lowers[j].x_;
+               uint32_t py = lowers[j].y_;
+
+               if (!world.IsOcean(px, py))
+               {
+                  float ql = f * lowers[j].share_;
+
+                  watermap[py][px] += ql;
+                  flow[py * width + px] += ql;
+               }
+            }
+         }
+      });
 }
 
 } // namespace WorldEngine
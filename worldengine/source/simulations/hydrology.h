@@ -5,6 +5,21 @@
 namespace WorldEngine
 {
 
-void WatermapSimulation(World& world, uint32_t seed);
+/**
+ * @brief Simulate the flow of rainfall over land
+ * @param world World containing elevation, ocean and precipitation data
+ * @param seed Seed used to sample droplet sources
+ * @param mode Droplets follows rainfall from randomly sampled land cells.
+ * Accumulation routes the rainfall of every land cell in a single pass, divided
+ * among all lower neighbors. AccumulationD8 routes it to the lowest neighbor
+ * only.
+ * @param randomMode Sequential follows droplets one at a time, each flowing
+ * over the water left by earlier droplets. CounterBased follows droplets in
+ * parallel over the terrain alone.
+ */
+void WatermapSimulation(World&       world,
+                        uint32_t     seed,
+                        WatermapMode mode       = WatermapMode::Droplets,
+                        RandomMode   randomMode = RandomMode::Sequential);
 
 } // namespace WorldEngine
@@ -1,5 +1,7 @@
 #include "icecap.h"
 #include "../basic.h"
+#include "../parallel.h"
+#include "../random.h"
 
 #include <random>
 
@@ -25,23 +27,21 @@ static const float SURROUNDING_TILE_INFLUENCE = 0.5f;
 
 static const uint32_t NUM_SURROUNDING_TILES = 8u;
 
-void IcecapSimulation(World& world, uint32_t seed)
+void IcecapSimulation(World& world, uint32_t seed, RandomMode mode)
 {
    BOOST_LOG_TRIVIAL(info) << "Icecap simulation start";
 
-   std::mt19937                                    generator(seed);
-   boost::random::uniform_real_distribution<float> distribution(0.0f, 1.0f);
-
    const int32_t width  = world.width();
    const int32_t height = world.height();
 
-   const OceanArrayType&       ocean       = world.GetOceanData();
-   const TemperatureArrayType& temperature = world.GetTemperatureData();
+   LayerView<const OceanDataType>       ocean = world.GetOceanView();
+   LayerView<const TemperatureDataType> temperature =
+      world.GetTemperatureView();
 
    // Secondary constants
    // Coldest spot in the world
    const float minTemp = *std::min_element(
-      temperature.data(), temperature.data() + temperature.num_elements());
+      temperature.data(), temperature.data() + temperature.size());
 
    // Upper temperature-limit for freezing effects
    const float freezeLimit = world.GetThreshold(TemperatureLevel::Polar);
@@ -53,70 +53,113 @@ void IcecapSimulation(World& world, uint32_t seed)
    const float freezeChanceThreshold =
       freezeThreshold * (1.0f - FREEZE_CHANCE_WINDOW);
 
-   IcecapArrayType& icecap = world.GetIcecapData();
-   icecap.resize(boost::extents[height][width]);
+   world.GetIcecapData().resize(boost::extents[height][width]);
+
+   LayerView<IcecapDataType> icecap = world.GetIcecapView();
+   std::fill(icecap.data(), icecap.data() + icecap.size(), 0.0f);
 
    // Map that is true whenever there is land or (certain) ice around
-   SolidArrayType solidMap(boost::extents[height][width]);
+   SolidArrayType           solidArray(boost::extents[height][width]);
+   LayerView<SolidDataType> solidMap = MakeLayerView(solidArray);
    for (int32_t y = 0; y < height; y++)
    {
+      const OceanDataType*       oceanRow       = ocean[y];
+      const TemperatureDataType* temperatureRow = temperature[y];
+      SolidDataType*             solidRow       = solidMap[y];
+
       for (int32_t x = 0; x < width; x++)
       {
-         solidMap[y][x] = !ocean[y][x] || (temperature[y][x] <=
-                                           freezeChanceThreshold + minTemp);
+         solidRow[x] = !oceanRow[x] ||
+                       (temperatureRow[x] <= freezeChanceThreshold + minTemp);
       }
    }
 
    // Will freeze: [minTemp, freezeChanceThreshold]
    // Can freeze:  (freezeChanceThreshold, freezeThreshold)
-   static const std::vector<std::pair<float, float>> freezePoints(
+   const std::vector<std::pair<float, float>> freezePoints(
       {{minTemp, 1.0f},
        {freezeChanceThreshold, 1.0f},
        {freezeThreshold, 0.0f}});
    static const std::vector<std::pair<uint32_t, float>> chancePoints(
       {{0, -1.0f}, {NUM_SURROUNDING_TILES, 1.0f}});
 
-   for (int32_t y = 0; y < height; y++)
+   // Determine whether an ocean tile may freeze, and the chance it freezes
+   auto CanFreeze = [&](int32_t x, int32_t y, float& chance) -> bool
    {
-      for (int32_t x = 0; x < width; x++)
+      float t = temperature[y][x];
+
+      if (!ocean[y][x] || !(t - minTemp < freezeThreshold))
       {
-         if (world.IsOcean(x, y))
-         {
-            float t = temperature[y][x];
+         return false;
+      }
 
-            if (t - minTemp < freezeThreshold)
-            {
-               // Map temperature to freeze-chance (linear interpolation)
-               float chance = Interpolate(t, freezePoints);
+      // Map temperature to freeze-chance (linear interpolation)
+      chance = Interpolate(t, freezePoints);
 
-               // Count number of frozen/solid tiles around this one
-               if (0 < x && x < width - 1 && 0 < y &&
-                   y < height - 1) // Exclude borders
+      // Count number of frozen/solid tiles around this one
+      if (0 < x && x < width - 1 && 0 < y && y < height - 1) // Exclude borders
+      {
+         // Count number of frozen/solid tiles around this one
+         uint32_t frozenTiles = 0;
+         for (int32_t ny = y - 1; ny <= y + 1; ny++)
+         {
+            for (int32_t nx = x - 1; nx <= x + 1; nx++)
+            {
+               if ((nx != x || ny != y) && solidMap[ny][nx])
                {
-                  // Count number of frozen/solid tiles around this one
-                  uint32_t frozenTiles = 0;
-                  for (int32_t ny = y - 1; ny <= y + 1; ny++)
+                  frozenTiles++;
+               }
+            }
+         }
+
+         // Map number of tiles to chance-modifier
+         float chanceMod = Interpolate(frozenTiles, chancePoints);
+         chance += chanceMod * SURROUNDING_TILE_INFLUENCE;
+      }
+
+      return true;
+   };
+
+   if (mode == RandomMode::CounterBased)
+   {
+      // Neighbors are counted before any tile freezes, so that rows are
+      // independent
+      CounterRandom random(seed, static_cast<uint32_t>(Simulation::Icecap));
+
+      ParallelFor(0u,
+                  static_cast<uint32_t>(height),
+                  [&](uint32_t y)
                   {
-                     for (int32_t nx = x - 1; nx <= x + 1; nx++)
+                     for (uint32_t x = 0; x < static_cast<uint32_t>(width);
+                          x++)
                      {
-                        if ((nx != x || ny != y) && solidMap[ny][nx])
+                        float chance;
+
+                        if (CanFreeze(x, y, chance) &&
+                            random.Uniform(x, y) < chance)
                         {
-                           frozenTiles++;
+                           icecap[y][x] = freezeThreshold -
+                                          (temperature[y][x] - minTemp);
                         }
                      }
-                  }
+                  });
+   }
+   else
+   {
+      std::mt19937                                    generator(seed);
+      boost::random::uniform_real_distribution<float> distribution(0.0f, 1.0f);
 
-                  // Map number of tiles to chance-modifier
-                  float chanceMod = Interpolate(frozenTiles, chancePoints);
-                  chance += chanceMod * SURROUNDING_TILE_INFLUENCE;
-               }
+      for (int32_t y = 0; y < height; y++)
+      {
+         for (int32_t x = 0; x < width; x++)
+         {
+            float chance;
 
-               if (distribution(generator) <= chance)
-               {
-                  solidMap[y][x] = true; // Mark tile as frozen
-                  icecap[y][x] =
-                     freezeThreshold - (t - minTemp); // Ice thickness
-               }
+            if (CanFreeze(x, y, chance) && distribution(generator) <= chance)
+            {
+               solidMap[y][x] = true; // Mark tile as frozen
+               icecap[y][x] = freezeThreshold -
+                              (temperature[y][x] - minTemp); // Ice thickness
             }
          }
       }
@@ -5,6 +5,17 @@
 namespace WorldEngine
 {
 
-void IcecapSimulation(World& world, uint32_t seed);
+/**
+ * @brief Freeze cold ocean tiles. Tiles are more likely to freeze next to land
+ * or other ice.
+ * @param world
+ * @param seed
+ * @param mode Sequential visits tiles in order, counting tiles frozen earlier
+ * as ice. CounterBased counts only land and certain ice, and processes rows in
+ * parallel.
+ */
+void IcecapSimulation(World&     world,
+                      uint32_t   seed,
+                      RandomMode mode = RandomMode::Sequential);
 
 } // namespace WorldEngine
@@ -1,26 +1,31 @@
 #include "irrigation.h"
+#include "../parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 #include <boost/log/trivial.hpp>
 
 namespace WorldEngine
 {
 
-static void IrrigationExecute(World& world);
+static void IrrigationExecute(World& world, int32_t radius);
 
-void IrrigationSimulation(World& world)
+void IrrigationSimulation(World& world, int32_t radius)
 {
    BOOST_LOG_TRIVIAL(info) << "Irrigation simulation start";
 
-   IrrigationExecute(world);
+   IrrigationExecute(world, radius);
 
    BOOST_LOG_TRIVIAL(info) << "Irrigation simulation finish";
 }
 
-static void IrrigationExecute(World& world)
+static void IrrigationExecute(World& world, int32_t radius)
 {
    const int32_t width  = world.width();
    const int32_t height = world.height();
-   const int32_t radius = 10;
+   const int32_t size   = radius * 2 + 1;
 
    const WaterMapArrayType& watermap   = world.GetWaterMapData();
    IrrigationArrayType&     irrigation = world.GetIrrigationData();
@@ -30,16 +35,15 @@ static void IrrigationExecute(World& world)
       irrigation.data(), irrigation.data() + irrigation.num_elements(), 0.0f);
 
    // Create array of pre-calculated values
-   boost::multi_array<float, 2> logs(
-      boost::extents[radius * 2 + 1][radius * 2 + 1]);
-   for (int32_t y = 0; y <= radius * 2; y++)
+   boost::multi_array<float, 2> logs(boost::extents[size][size]);
+   for (int32_t y = 0; y < size; y++)
    {
-      // Y distance to center: [-10, 10]
+      // Y distance to center: [-radius, radius]
       float dy = static_cast<float>(y - radius);
 
-      for (int32_t x = 0; x <= radius * 2; x++)
+      for (int32_t x = 0; x < size; x++)
       {
-         // X distance to center: [-10, 10]
+         // X distance to center: [-radius, radius]
          float dx = static_cast<float>(x - radius);
 
          // Calculate final matrix: ln(sqrt(x^2 + y^2) + 1) + 1
@@ -47,41 +51,51 @@ static void IrrigationExecute(World& world)
       }
    }
 
+   // Only ocean cells contribute to irrigation. Land cells contribute zero,
+   // which leaves each sum unchanged.
+   std::vector<float> sources(watermap.num_elements(), 0.0f);
    for (int32_t y = 0; y < height; y++)
    {
       for (int32_t x = 0; x < width; x++)
       {
          if (world.IsOcean(x, y))
          {
-            // Coordinates (top-left / bottom-right) used for the values slice
-            uint32_t tlXV = std::max(x - radius, 0);
-            uint32_t tlYV = std::max(y - radius, 0);
-            uint32_t brXV = std::min(x + radius, width - 1);
-            uint32_t brYV = std::min(y + radius, height - 1);
-
-            // Coordinates (top-left / bottom-right) used for the logs slice
-            uint32_t tlXL = std::max(radius - x, 0);
-            uint32_t tlYL = std::max(radius - y, 0);
-            uint32_t brXL = std::min(radius - x + width - 1, 2 * radius);
-            uint32_t brYL = std::min(radius - y + height - 1, 2 * radius);
-
-            // Values slice and logs slice should be the same size and
-            // dimensions
-
-            for (uint32_t vy = tlYV, ly = tlYL; //
-                 vy <= brYV && ly <= brYL;
-                 vy++, ly++)
+            sources[y * width + x] = watermap[y][x];
+         }
+      }
+   }
+
+   // Each cell gathers from the ocean cells within radius. Sources are visited
+   // in row-major order, which is the order the contributions would be added
+   // when scattered from each ocean cell.
+   ParallelFor(
+      0u,
+      static_cast<uint32_t>(height),
+      [&](uint32_t row)
+      {
+         const int32_t y   = static_cast<int32_t>(row);
+         float*        out = irrigation.data() + y * width;
+
+         for (int32_t sy = std::max(y - radius, 0);
+              sy <= std::min(y + radius, height - 1);
+              sy++)
+         {
+            const float*  in = sources.data() + sy * width;
+            const int32_t ly = radius - (sy - y);
+
+            for (int32_t dx = -radius; dx <= radius; dx++)
             {
-               for (uint32_t vx = tlXV, lx = tlXL; //
-                    vx <= brXV && lx <= brXL;
-                    vx++, lx++)
+               const float   l      = logs[ly][radius - dx];
+               const int32_t xBegin = std::max(0, -dx);
+               const int32_t xEnd   = std::min(width, width - dx);
+
+               for (int32_t x = xBegin; x < xEnd; x++)
                {
-                  irrigation[vy][vx] += watermap[y][x] / logs[ly][lx];
+                  out[x] += in[x + dx] / l;
                }
             }
          }
-      }
-   }
+      });
 }
 
 } // namespace WorldEngine
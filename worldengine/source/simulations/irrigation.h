@@ -5,6 +5,17 @@
 namespace WorldEngine
 {
 
-void IrrigationSimulation(World& world);
+/**
+ * @brief Default distance over which ocean water irrigates nearby cells
+ */
+const int32_t IRRIGATION_RADIUS = 10;
+
+/**
+ * @brief Calculate irrigation from the water in nearby ocean cells, weighted
+ * by ln(distance + 1) + 1
+ * @param world World containing ocean and watermap data
+ * @param radius Distance over which each ocean cell contributes
+ */
+void IrrigationSimulation(World& world, int32_t radius = IRRIGATION_RADIUS);
 
 } // namespace WorldEngine
@@ -1,67 +1,80 @@
 #include "temperature.h"
 #include "../basic.h"
+#include "../random.h"
 
 #include <random>
 
 #include <boost/log/trivial.hpp>
 #include <boost/random.hpp>
 
-#include <OpenSimplexNoise.h>
-
 namespace WorldEngine
 {
 
-static void PermeabilityCalculation(World& world, uint32_t seed);
+static void
+PermeabilityCalculation(World& world, uint32_t seed, RandomMode mode);
 
-void PermeabilitySimulation(World& world, uint32_t seed)
+void PermeabilitySimulation(World& world, uint32_t seed, RandomMode mode)
 {
    BOOST_LOG_TRIVIAL(info) << "Permeability simulation start";
 
    const PermeabilityArrayType& perm  = world.GetPermeabilityData();
    const OceanArrayType&        ocean = world.GetOceanData();
 
-   PermeabilityCalculation(world, seed);
+   PermeabilityCalculation(world, seed, mode);
+
+   std::vector<float> thresholds =
+      FindThresholdsF(perm, {0.75f, 0.25f}, &ocean);
 
-   world.SetThreshold(PermeabilityLevel::Low,
-                      FindThresholdF(perm, 0.75f, &ocean));
-   world.SetThreshold(PermeabilityLevel::Medium,
-                      FindThresholdF(perm, 0.25f, &ocean));
+   world.SetThreshold(PermeabilityLevel::Low, thresholds[0]);
+   world.SetThreshold(PermeabilityLevel::Medium, thresholds[1]);
    world.SetThreshold(PermeabilityLevel::High,
                       std::numeric_limits<float>::max());
 
    BOOST_LOG_TRIVIAL(info) << "Permeability simulation finish";
 }
 
-static void PermeabilityCalculation(World& world, uint32_t seed)
+static void
+PermeabilityCalculation(World& world, uint32_t seed, RandomMode mode)
 {
    BOOST_LOG_TRIVIAL(debug) << "Seed: " << seed;
 
-   std::mt19937                                      generator(seed);
-   boost::random::uniform_int_distribution<uint32_t> distribution;
+   uint32_t noiseSeed;
+
+   if (mode == RandomMode::CounterBased)
+   {
+      CounterRandom random(seed,
+                           static_cast<uint32_t>(Simulation::Permeability));
+      noiseSeed = random(0u, 0u);
+   }
+   else
+   {
+      std::mt19937                                      generator(seed);
+      boost::random::uniform_int_distribution<uint32_t> distribution;
+      noiseSeed = distribution(generator);
+   }
 
-   OpenSimplexNoise::Noise noise(distribution(generator));
+   NoiseGenerator noise(noiseSeed);
 
    uint32_t width  = world.width();
    uint32_t height = world.height();
 
-   PermeabilityArrayType& perm = world.GetPermeabilityData();
-   perm.resize(boost::extents[height][width]);
+   world.GetPermeabilityData().resize(boost::extents[height][width]);
+
+   LayerView<PermeabilityDataType> perm = world.GetPermeabilityView();
 
    const uint32_t octaves = 6u;
    const float    freq    = 64.0f * octaves;
    const float    nScale  = 1.0f;
 
-   for (uint32_t y = 0; y < height; y++)
-   {
-      for (uint32_t x = 0; x < width; x++)
-      {
-         double n   = Noise(noise, //
-                          x * nScale / freq,
-                          y * nScale / freq,
-                          octaves);
-         perm[y][x] = static_cast<float>(n);
-      }
-   }
+   NoiseField(noise,
+              width,
+              height,
+              nScale,
+              freq,
+              octaves,
+              false,
+              [&](int32_t x, int32_t y, double n)
+              { perm[y][x] = static_cast<float>(n); });
 }
 
 } // namespace WorldEngine
@@ -5,6 +5,14 @@
 namespace WorldEngine
 {
 
-void PermeabilitySimulation(World& world, uint32_t seed);
+/**
+ * @brief Generate permeability from noise
+ * @param world
+ * @param seed
+ * @param mode Random numbers used to seed the noise
+ */
+void PermeabilitySimulation(World&     world,
+                            uint32_t   seed,
+                            RandomMode mode = RandomMode::Sequential);
 
 } // namespace WorldEngine
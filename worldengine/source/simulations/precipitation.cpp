@@ -1,37 +1,73 @@
 #include "precipitation.h"
 #include "../basic.h"
 
+#include <limits>
 #include <random>
 
 #include <boost/log/trivial.hpp>
 #include <boost/random.hpp>
 
-#include <OpenSimplexNoise.h>
-
 namespace WorldEngine
 {
 
-static void PrecipitationCalculation(World& world, uint32_t seed);
+/**
+ * @brief Range of values, accumulated for each row and then reduced, so the
+ * result does not depend on the number of threads
+ */
+struct ValueRange
+{
+   float min_ = std::numeric_limits<float>::max();
+   float max_ = std::numeric_limits<float>::lowest();
 
-void PrecipitationSimulation(World& world, uint32_t seed)
+   void Add(float value)
+   {
+      min_ = std::min(min_, value);
+      max_ = std::max(max_, value);
+   }
+
+   void Add(const ValueRange& other)
+   {
+      min_ = std::min(min_, other.min_);
+      max_ = std::max(max_, other.max_);
+   }
+};
+
+static void PrecipitationCalculation(World&              world,
+                                     uint32_t            seed,
+                                     GammaMode           mode,
+                                     std::vector<float>& landValues);
+
+void PrecipitationSimulation(World& world, uint32_t seed, GammaMode mode)
 {
    BOOST_LOG_TRIVIAL(info) << "Precipitation simulation start";
 
-   const OceanArrayType&         ocean = world.GetOceanData();
-   const PrecipitationArrayType& p     = world.GetPrecipitationData();
+   std::vector<float> landValues;
+
+   PrecipitationCalculation(world, seed, mode, landValues);
 
-   PrecipitationCalculation(world, seed);
+   std::vector<float> thresholds = SelectThresholdsF(landValues, {0.75f, 0.3f});
 
-   world.SetThreshold(PrecipitationLevel::Low,
-                      FindThresholdF(p, 0.75f, &ocean));
-   world.SetThreshold(PrecipitationLevel::Medium,
-                      FindThresholdF(p, 0.3f, &ocean));
+   world.SetThreshold(PrecipitationLevel::Low, thresholds[0]);
+   world.SetThreshold(PrecipitationLevel::Medium, thresholds[1]);
    world.SetThreshold(PrecipitationLevel::High, 0.0f);
 
    BOOST_LOG_TRIVIAL(info) << "Precipitation simulation finish";
 }
 
-static void PrecipitationCalculation(World& world, uint32_t seed)
+/**
+ * @brief Generate precipitation in three passes over the map. The first pass
+ * generates noise, and finds the ranges of precipitation and temperature. The
+ * second applies the gamma curve, and finds the range of the result. The third
+ * renormalizes precipitation, and gathers the land values for thresholds.
+ * @param world A world having oceans and temperature
+ * @param seed Seed of the precipitation noise
+ * @param mode Evaluation of the gamma curve
+ * @param landValues Receives the precipitation of each land cell
+ */
+static void PrecipitationCalculation(World&              world,
+                                     uint32_t            seed,
+                                     GammaMode           mode,
+                                     std::vector<float>& landValues)
 {
    BOOST_LOG_TRIVIAL(debug) << "Seed: " << seed;
 
@@ -40,58 +76,67 @@ static void PrecipitationCalculation(World& world, uint32_t seed)
    boost::random::uniform_int_distribution<uint32_t> distribution(0,
                                                                   UINT32_MAX);
 
-   OpenSimplexNoise::Noise noise(distribution(generator));
+   NoiseGenerator noise(distribution(generator));
 
    const int32_t width  = world.width();
    const int32_t height = world.height();
-   const int32_t border = width / 4;
 
    float curveGamma = world.gammaCurve();
    float curveBonus = world.curveOffset();
 
-   const TemperatureArrayType& temperature   = world.GetTemperatureData();
-   PrecipitationArrayType&     precipitation = world.GetPrecipitationData();
-   precipitation.resize(boost::extents[height][width]);
+   world.GetPrecipitationData().resize(boost::extents[height][width]);
+
+   LayerView<const OceanDataType>       ocean = world.GetOceanView();
+   LayerView<const TemperatureDataType> temperature =
+      world.GetTemperatureView();
+   LayerView<PrecipitationDataType>     precipitation =
+      world.GetPrecipitationView();
+
+   const bool useOcean = (ocean.size() == precipitation.size());
+
+   std::vector<ValueRange> precipRanges(height);
+   std::vector<ValueRange> tempRanges(height);
+   std::vector<size_t>     landOffsets(height + 1u, 0u);
 
    uint32_t octaves = 6;
    float    freq    = 64.0f * octaves;
    float    nScale  = 1024.0f / static_cast<float>(height);
 
+   NoiseField(noise,
+              width,
+              height,
+              nScale,
+              freq,
+              octaves,
+              true,
+              [&](int32_t x, int32_t y, double n)
+              {
+                 precipitation[y][x] = static_cast<float>(n);
+
+                 precipRanges[y].Add(precipitation[y][x]);
+                 tempRanges[y].Add(temperature[y][x]);
+
+                 if (!useOcean || !ocean[y][x])
+                 {
+                    landOffsets[y + 1]++;
+                 }
+              });
+
+   // Find ranges, and where the land values of each row begin
+   ValueRange precipRange;
+   ValueRange tempRange;
+
    for (int32_t y = 0; y < height; y++)
    {
-      for (int32_t x = 0; x < width; x++)
-      {
-         double n = Noise(noise, //
-                          x * nScale / freq,
-                          y * nScale / freq,
-                          octaves);
-
-         if (x <= border)
-         {
-            n *= static_cast<double>(x) / border;
-            n += Noise(noise,
-                       (x * nScale + width) / freq,
-                       y * nScale / freq,
-                       octaves) *
-                 (border - x) / border;
-         }
-
-         precipitation[y][x] = static_cast<float>(n);
-      }
+      precipRange.Add(precipRanges[y]);
+      tempRange.Add(tempRanges[y]);
+      landOffsets[y + 1] += landOffsets[y];
    }
 
-   // Find ranges
-   std::pair<PrecipitationDataType*, PrecipitationDataType*> minmaxPrecip =
-      std::minmax_element(precipitation.data(),
-                          precipitation.data() + precipitation.num_elements());
-   float minPrecip = *minmaxPrecip.first;
-   float maxPrecip = *minmaxPrecip.second;
-
-   auto minmaxTemp =
-      std::minmax_element(temperature.data(), //
-                          temperature.data() + temperature.num_elements());
-   float minTemp = *minmaxTemp.first;
-   float maxTemp = *minmaxTemp.second;
+   float minPrecip = precipRange.min_;
+   float maxPrecip = precipRange.max_;
+   float minTemp   = tempRange.min_;
+   float maxTemp   = tempRange.max_;
 
    float precipDelta = maxPrecip - minPrecip;
    float tempDelta   = maxTemp - minTemp;
@@ -101,63 +146,99 @@ static void PrecipitationCalculation(World& world, uint32_t seed)
    BOOST_LOG_TRIVIAL(debug)
       << "Temperature minmax: " << minTemp << ", " << maxTemp;
 
-   for (int32_t y = 0; y < height; y++)
+   /*
+    * Ok, some explanation here because why the formula is doing htis may be a
+    * little confusing. We are going to generate a modified gamma curve based on
+    * normalized temperature and multiply our precipitation amounts by it.
+    *
+    * std::pow(t, curveGamma) generates a standard gamma curve. However we
+    * probably don't want to be multiplying precipitation by 0 at the far side
+    * of the curve. To avoid this we multiply the curve by (1 - curveBonus) and
+    * then add back curveBonus. Thus, if we have a curve bonus of 0.2 then the
+    * range of our modified gamma curve goes from 0-1 to 0-0.8 after we multiply
+    * and then to 0.2-1 after we add back the curveBonus.
+    *
+    * Because we renormalize there is not much point to offsetting the opposite
+    * end of the curve so it is less than or more than 1. We are trying to avoid
+    * setting the start of the curve to 0 because f(t) * p would equal 0 when t
+    * equals 0. However f(t) * p does not automatically equal 1 when t equals 1
+    * and if we raise or lower the value for f(t) at 1 it would have negligible
+    * impact after renormalizing.
+    */
+   auto ApplyCurve = [&](auto pow)
+   {
+      ParallelFor(0u,
+                  static_cast<uint32_t>(height),
+                  [&](uint32_t y)
+                  {
+                     PrecipitationDataType*     precipRow = precipitation[y];
+                     const TemperatureDataType* tempRow   = temperature[y];
+
+                     for (int32_t x = 0; x < width; x++)
+                     {
+                        // Normalize temperature and precipitation arrays
+                        float t = (tempRow[x] - minTemp) / tempDelta;
+                        float p = (precipRow[x] - minPrecip) / precipDelta;
+
+                        // Modify precipitation based on temperature
+                        float curve =
+                           pow(t, curveGamma) * (1 - curveBonus) + curveBonus;
+                        precipRow[x] = p * curve;
+                     }
+
+                     for (int32_t x = 0; x < width; x++)
+                     {
+                        precipRanges[y].Add(precipRow[x]);
+                     }
+                  });
+   };
+
+   precipRanges.assign(height, ValueRange());
+
+   if (mode == GammaMode::Approximate)
    {
-      for (int32_t x = 0; x < width; x++)
-      {
-         // Normalize temperature and precipitation arrays
-         float t = (temperature[y][x] - minTemp) / tempDelta;
-         float p = (precipitation[y][x] - minPrecip) / precipDelta;
-
-         /*
-          * Ok, some explanation here because why the formula is doing htis may
-          * be a little confusing. We are going to generate a modified gamma
-          * curve based on normalized temperature and multiply our precipitation
-          * amounts by it.
-          *
-          * std::pow(t, curveGamma) generates a standard gamma curve. However
-          * we probably don't want to be multiplying precipitation by 0 at the
-          * far side of the curve. To avoid this we multiply the curve by (1 -
-          * curveBonus) and then add back curveBonus. Thus, if we have a curve
-          * bonus of 0.2 then the range of our modified gamma curve goes from
-          * 0-1 to 0-0.8 after we multiply and then to 0.2-1 after we add back
-          * the curveBonus.
-          *
-          * Because we renormalize there is not much point to offsetting the
-          * opposite end of the curve so it is less than or more than 1. We are
-          * trying to avoid setting the start of the curve to 0 because f(t) * p
-          * would equal 0 when t equals 0. However f(t) * p does not
-          * automatically equal 1 when t equals 1 and if we raise or lower the
-          * value for f(t) at 1 it would have negligible impact after
-          * renormalizing.
-          */
-
-         // Modify precipitation based on temperature
-         float curve = std::pow(t, curveGamma) * (1 - curveBonus) + curveBonus;
-         precipitation[y][x] = p * curve;
-      }
+      ApplyCurve([](float t, float gamma) { return PowApprox(t, gamma); });
+   }
+   else
+   {
+      ApplyCurve([](float t, float gamma) { return std::pow(t, gamma); });
    }
 
    // Renormalize precipitation because the precipitiation changes will probably
    // not fully extend from -1 to 1
-   minmaxPrecip =
-      std::minmax_element(precipitation.data(),
-                          precipitation.data() + precipitation.num_elements());
-   minPrecip   = *minmaxPrecip.first;
-   maxPrecip   = *minmaxPrecip.second;
+   precipRange = ValueRange();
+   for (int32_t y = 0; y < height; y++)
+   {
+      precipRange.Add(precipRanges[y]);
+   }
+
+   minPrecip   = precipRange.min_;
+   maxPrecip   = precipRange.max_;
    precipDelta = maxPrecip - minPrecip;
 
    BOOST_LOG_TRIVIAL(debug)
       << "Precipitation minmax (modified): " << minPrecip << ", " << maxPrecip;
 
-   for (int32_t y = 0; y < height; y++)
-   {
-      for (int32_t x = 0; x < width; x++)
-      {
-         precipitation[y][x] =
-            (precipitation[y][x] - minPrecip) / precipDelta * 2 - 1;
-      }
-   }
+   landValues.resize(landOffsets[height]);
+
+   ParallelFor(0u,
+               static_cast<uint32_t>(height),
+               [&](uint32_t y)
+               {
+                  PrecipitationDataType* precipRow = precipitation[y];
+                  size_t                 i         = landOffsets[y];
+
+                  for (int32_t x = 0; x < width; x++)
+                  {
+                     precipRow[x] =
+                        (precipRow[x] - minPrecip) / precipDelta * 2 - 1;
+
+                     if (!useOcean || !ocean[y][x])
+                     {
+                        landValues[i++] = precipRow[x];
+                     }
+                  }
+               });
 }
 
 } // namespace WorldEngine
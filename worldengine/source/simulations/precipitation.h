@@ -5,6 +5,14 @@
 namespace WorldEngine
 {
 
-void PrecipitationSimulation(World& world, uint32_t seed);
+/**
+ * @brief Simulate precipitation from noise, modified by temperature
+ * @param world A world having oceans and temperature
+ * @param seed Seed of the precipitation noise
+ * @param mode Evaluation of the gamma curve applied by temperature
+ */
+void PrecipitationSimulation(World&    world,
+                             uint32_t  seed,
+                             GammaMode mode = GammaMode::Exact);
 
 } // namespace WorldEngine
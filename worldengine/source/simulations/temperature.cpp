@@ -7,64 +7,64 @@
 #include <boost/log/trivial.hpp>
 #include <boost/random.hpp>
 
-#include <OpenSimplexNoise.h>
-
 namespace WorldEngine
 {
 
 static const float SQRT_2XLN2 = sqrtf(2 * logf(2));
 
-static void TemperatureCalculation(World&              world,
-                                   uint32_t            seed,
-                                   ElevationArrayType& elevation,
-                                   float               mountainLevel);
+static void TemperatureCalculation(World&                             world,
+                                   uint32_t                           seed,
+                                   LayerView<const ElevationDataType> elevation,
+                                   float mountainLevel);
 
 void TemperatureSimulation(World& world, uint32_t seed)
 {
    BOOST_LOG_TRIVIAL(info) << "Temperature simulation start";
 
-   ElevationArrayType& elevation = world.GetElevationData();
+   LayerView<const ElevationDataType> elevation = world.GetElevationView();
    float mountainLevel = world.GetThreshold(ElevationThreshold::Mountain);
+
+   TemperatureCalculation(world, seed, elevation, mountainLevel);
+   TemperatureThresholds(world);
+
+   BOOST_LOG_TRIVIAL(info) << "Temperature simulation finish";
+}
+
+void TemperatureThresholds(World& world)
+{
    const OceanArrayType&       ocean = world.GetOceanData();
    const TemperatureArrayType& t     = world.GetTemperatureData();
 
-   TemperatureCalculation(world, seed, elevation, mountainLevel);
+   std::vector<float> thresholds = FindThresholdsF(t, world.temps(), &ocean);
 
-   world.SetThreshold(TemperatureLevel::Polar,
-                      FindThresholdF(t, world.temps()[0], &ocean));
-   world.SetThreshold(TemperatureLevel::Alpine,
-                      FindThresholdF(t, world.temps()[1], &ocean));
-   world.SetThreshold(TemperatureLevel::Boreal,
-                      FindThresholdF(t, world.temps()[2], &ocean));
-   world.SetThreshold(TemperatureLevel::Cool,
-                      FindThresholdF(t, world.temps()[3], &ocean));
-   world.SetThreshold(TemperatureLevel::Warm,
-                      FindThresholdF(t, world.temps()[4], &ocean));
-   world.SetThreshold(TemperatureLevel::Subtropical,
-                      FindThresholdF(t, world.temps()[5], &ocean));
+   world.SetThreshold(TemperatureLevel::Polar, thresholds[0]);
+   world.SetThreshold(TemperatureLevel::Alpine, thresholds[1]);
+   world.SetThreshold(TemperatureLevel::Boreal, thresholds[2]);
+   world.SetThreshold(TemperatureLevel::Cool, thresholds[3]);
+   world.SetThreshold(TemperatureLevel::Warm, thresholds[4]);
+   world.SetThreshold(TemperatureLevel::Subtropical, thresholds[5]);
    world.SetThreshold(TemperatureLevel::Tropical,
                       std::numeric_limits<float>::max());
-
-   BOOST_LOG_TRIVIAL(info) << "Temperature simulation finish";
 }
 
-static void TemperatureCalculation(World&              world,
-                                   uint32_t            seed,
-                                   ElevationArrayType& elevation,
-                                   float               mountainLevel)
+static void TemperatureCalculation(World&                             world,
+                                   uint32_t                           seed,
+                                   LayerView<const ElevationDataType> elevation,
+                                   float mountainLevel)
 {
    BOOST_LOG_TRIVIAL(debug) << "Seed: " << seed;
 
    std::mt19937                                      generator(seed);
    boost::random::uniform_int_distribution<uint32_t> distribution;
 
-   OpenSimplexNoise::Noise noise(distribution(generator));
+   NoiseGenerator noise(distribution(generator));
 
    const int32_t width  = world.width();
    const int32_t height = world.height();
 
-   TemperatureArrayType& temperature = world.GetTemperatureData();
-   temperature.resize(boost::extents[height][width]);
+   world.GetTemperatureData().resize(boost::extents[height][width]);
+
+   LayerView<TemperatureDataType> temperature = world.GetTemperatureView();
 
    /*
     * Set up variables to take care of some orbital paramters:
@@ -110,7 +110,6 @@ static void TemperatureCalculation(World&              world,
 
    BOOST_LOG_TRIVIAL(debug) << "Axial tilt: " << axialTilt;
 
-   int32_t  border  = width / 4;
    uint32_t octaves = 8; // Number of passes for noise generator
    float    freq    = 16.0f * octaves;
    float    nScale  = 1024.0f / static_cast<float>(height);
@@ -119,6 +118,7 @@ static void TemperatureCalculation(World&              world,
                                                   {axialTilt, 1.0f},
                                                   {axialTilt + 0.5f, 0.0f}};
 
+   std::vector<float> latitudeFactors(height);
    for (int32_t y = 0; y < height; y++)
    {
       // yScaled = -0.5..0.5
@@ -128,27 +128,21 @@ static void TemperatureCalculation(World&              world,
       // most sunlight hits the world:
       //     1.0 = hottest zone
       //     0.0 = coldest zone
-      float latitudeFactor = Interpolate(yScaled, points);
+      latitudeFactors[y] = Interpolate(yScaled, points);
+   }
 
-      for (int32_t x = 0; x < width; x++)
+   // Noise wraps around right and left
+   NoiseField(
+      noise,
+      width,
+      height,
+      nScale,
+      freq,
+      octaves,
+      true,
+      [&](int32_t x, int32_t y, double n)
       {
-         double n = Noise(noise, //
-                          x * nScale / freq,
-                          y * nScale / freq,
-                          octaves);
-
-         // Added to allow noise pattern to wrap around right and left
-         if (x <= border)
-         {
-            n *= static_cast<double>(x) / border;
-            n += Noise(noise,
-                       (x * nScale + width) / freq,
-                       y * nScale / freq,
-                       octaves) *
-                 (border - x) / border;
-         }
-
-         float t = static_cast<float>((latitudeFactor * 12 + n) / 13.0 /
+         float t = static_cast<float>((latitudeFactors[y] * 12 + n) / 13.0 /
                                       distanceToSun);
 
          // Vary temperature based on height
@@ -170,8 +164,7 @@ static void TemperatureCalculation(World&              world,
          }
 
          temperature[y][x] = t;
-      }
-   }
+      });
 }
 
 } // namespace WorldEngine
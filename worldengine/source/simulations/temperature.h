@@ -7,4 +7,10 @@ namespace WorldEngine
 
 void TemperatureSimulation(World& world, uint32_t seed);
 
+/**
+ * @brief Calculate the temperature level thresholds from the world's temps
+ * @param world A world having oceans and temperature
+ */
+void TemperatureThresholds(World& world);
+
 } // namespace WorldEngine
@@ -1,5 +1,8 @@
 #include "worldengine/world.h"
+#include "basic.h"
 
+#include <array>
+#include <atomic>
 #include <random>
 
 #if defined(_MSC_VER)
@@ -219,10 +222,24 @@ static const std::unordered_map<Biome, BiomeGroup> biomeGroups_ = {
    {Biome::BareRock, BiomeGroup::None},
 };
 
+static std::atomic<bool> layerDiagnostics_(false);
+
+void SetLayerDiagnostics(bool enabled)
+{
+   layerDiagnostics_.store(enabled, std::memory_order_relaxed);
+}
+
+bool LayerDiagnostics()
+{
+   return layerDiagnostics_.load(std::memory_order_relaxed);
+}
+
 World::World() :
     seed_(0),
     gammaCurve_(DEFAULT_GAMMA_CURVE),
-    curveOffset_(DEFAULT_CURVE_OFFSET)
+    curveOffset_(DEFAULT_CURVE_OFFSET),
+    layerVersions_(),
+    generationRecord_()
 {
 }
 
@@ -259,7 +276,9 @@ World::World(const std::string&          name,
     permeabilityThresholds_(),
     precipitationThresholds_(),
     temperatureThresholds_(),
-    waterThresholds_()
+    waterThresholds_(),
+    layerVersions_(),
+    generationRecord_()
 {
 }
 
@@ -517,6 +536,146 @@ WaterMapArrayType& World::GetWaterMapData()
    return waterMap_;
 }
 
+LayerView<const ElevationDataType> World::GetElevationView() const
+{
+   return MakeLayerView(elevation_);
+}
+
+LayerView<const OceanDataType> World::GetOceanView() const
+{
+   return MakeLayerView(ocean_);
+}
+
+LayerView<const PlateDataType> World::GetPlateView() const
+{
+   return MakeLayerView(plates_);
+}
+
+LayerView<const Biome> World::GetBiomeView() const
+{
+   return MakeLayerView(biome_);
+}
+
+LayerView<const HumidityDataType> World::GetHumidityView() const
+{
+   return MakeLayerView(humidity_);
+}
+
+LayerView<const IcecapDataType> World::GetIcecapView() const
+{
+   return MakeLayerView(icecap_);
+}
+
+LayerView<const IrrigationDataType> World::GetIrrigationView() const
+{
+   return MakeLayerView(irrigation_);
+}
+
+LayerView<const LakeMapDataType> World::GetLakeMapView() const
+{
+   return MakeLayerView(lakeMap_);
+}
+
+LayerView<const PermeabilityDataType> World::GetPermeabilityView() const
+{
+   return MakeLayerView(permeability_);
+}
+
+LayerView<const PrecipitationDataType> World::GetPrecipitationView() const
+{
+   return MakeLayerView(precipitation_);
+}
+
+LayerView<const RiverMapDataType> World::GetRiverMapView() const
+{
+   return MakeLayerView(riverMap_);
+}
+
+LayerView<const SeaDepthDataType> World::GetSeaDepthView() const
+{
+   return MakeLayerView(seaDepth_);
+}
+
+LayerView<const TemperatureDataType> World::GetTemperatureView() const
+{
+   return MakeLayerView(temperature_);
+}
+
+LayerView<const WaterMapDataType> World::GetWaterMapView() const
+{
+   return MakeLayerView(waterMap_);
+}
+
+LayerView<ElevationDataType> World::GetElevationView()
+{
+   return MakeLayerView(elevation_);
+}
+
+LayerView<OceanDataType> World::GetOceanView()
+{
+   return MakeLayerView(ocean_);
+}
+
+LayerView<PlateDataType> World::GetPlateView()
+{
+   return MakeLayerView(plates_);
+}
+
+LayerView<Biome> World::GetBiomeView()
+{
+   return MakeLayerView(biome_);
+}
+
+LayerView<HumidityDataType> World::GetHumidityView()
+{
+   return MakeLayerView(humidity_);
+}
+
+LayerView<IcecapDataType> World::GetIcecapView()
+{
+   return MakeLayerView(icecap_);
+}
+
+LayerView<IrrigationDataType> World::GetIrrigationView()
+{
+   return MakeLayerView(irrigation_);
+}
+
+LayerView<LakeMapDataType> World::GetLakeMapView()
+{
+   return MakeLayerView(lakeMap_);
+}
+
+LayerView<PermeabilityDataType> World::GetPermeabilityView()
+{
+   return MakeLayerView(permeability_);
+}
+
+LayerView<PrecipitationDataType> World::GetPrecipitationView()
+{
+   return MakeLayerView(precipitation_);
+}
+
+LayerView<RiverMapDataType> World::GetRiverMapView()
+{
+   return MakeLayerView(riverMap_);
+}
+
+LayerView<SeaDepthDataType> World::GetSeaDepthView()
+{
+   return MakeLayerView(seaDepth_);
+}
+
+LayerView<TemperatureDataType> World::GetTemperatureView()
+{
+   return MakeLayerView(temperature_);
+}
+
+LayerView<WaterMapDataType> World::GetWaterMapView()
+{
+   return MakeLayerView(waterMap_);
+}
+
 float World::GetThreshold(ElevationThreshold type) const
 {
    float threshold = std::numeric_limits<float>::max();
@@ -642,6 +801,33 @@ bool World::IsMountain(uint32_t x, uint32_t y) const
    return elevation_[y][x] > GetThreshold(ElevationThreshold::Mountain);
 }
 
+uint32_t World::GetLayerVersion(Layer layer) const
+{
+   return layerVersions_[static_cast<size_t>(layer)];
+}
+
+void World::SetLayerVersion(Layer layer, uint32_t version)
+{
+   layerVersions_[static_cast<size_t>(layer)] = version;
+}
+
+uint32_t World::MarkLayerEdited(Layer layer)
+{
+   uint32_t version = ++generationRecord_.lastVersion_;
+   SetLayerVersion(layer, version);
+   return version;
+}
+
+const GenerationRecord& World::GetGenerationRecord() const
+{
+   return generationRecord_;
+}
+
+GenerationRecord& World::GetGenerationRecord()
+{
+   return generationRecord_;
+}
+
 TemperatureLevel World::GetTemperatureLevel(uint32_t x, uint32_t y) const
 {
    uint32_t width  = static_cast<uint32_t>(temperature_.shape()[1]);
@@ -688,6 +874,49 @@ HumidityLevel World::GetHumidityLevel(uint32_t x, uint32_t y) const
    return HumidityLevel::Last;
 }
 
+void World::GetTemperatureLevels(LayerView<uint8_t> levels) const
+{
+   static const uint8_t numLevels =
+      static_cast<uint8_t>(TemperatureLevel::Count);
+
+   LayerView<const TemperatureDataType> temperature = GetTemperatureView();
+
+   if (levels.width() != temperature.width() ||
+       levels.height() != temperature.height())
+   {
+      throw std::invalid_argument("Level layer size mismatch");
+   }
+
+   std::array<float, numLevels> thresholds;
+   for (TemperatureLevel type : TemperatureIterator())
+   {
+      thresholds[static_cast<size_t>(type)] = GetThreshold(type);
+   }
+
+   QuantizeLevels(temperature, thresholds.data(), numLevels, levels);
+}
+
+void World::GetHumidityLevels(LayerView<uint8_t> levels) const
+{
+   static const uint8_t numLevels = static_cast<uint8_t>(HumidityLevel::Count);
+
+   LayerView<const HumidityDataType> humidity = GetHumidityView();
+
+   if (levels.width() != humidity.width() ||
+       levels.height() != humidity.height())
+   {
+      throw std::invalid_argument("Level layer size mismatch");
+   }
+
+   std::array<float, numLevels> thresholds;
+   for (HumidityLevel type : HumidityIterator())
+   {
+      thresholds[static_cast<size_t>(type)] = GetThreshold(type);
+   }
+
+   QuantizeLevels(humidity, thresholds.data(), numLevels, levels);
+}
+
 void World::GetRandomLand(std::vector<Point>& landSamples,
                           uint32_t            numSamples,
                           uint32_t            seed) const
@@ -752,15 +981,22 @@ void World::SetElevationData(const float* heightmap)
 {
    SetArrayData(heightmap, elevation_);
 
-   BOOST_LOG_TRIVIAL(debug) << "Elevation multi_array:" << std::endl
-                            << elevation_;
+   if (LayerDiagnostics())
+   {
+      BOOST_LOG_TRIVIAL(debug) << "Elevation multi_array:" << std::endl
+                               << elevation_;
+   }
 }
 
 void World::SetPlatesData(const uint32_t* platesmap)
 {
    SetArrayData(platesmap, plates_);
 
-   BOOST_LOG_TRIVIAL(debug) << "Platesmap multi_array:" << std::endl << plates_;
+   if (LayerDiagnostics())
+   {
+      BOOST_LOG_TRIVIAL(debug) << "Platesmap multi_array:" << std::endl
+                               << plates_;
+   }
 }
 
 void World::SetThreshold(ElevationThreshold type, float value)
@@ -793,6 +1029,26 @@ void World::SetThreshold(WaterThreshold type, float value)
    waterThresholds_[type] = value;
 }
 
+void World::SetTemps(const std::vector<float>& temps)
+{
+   temps_ = temps;
+}
+
+void World::SetHumids(const std::vector<float>& humids)
+{
+   humids_ = humids;
+}
+
+void World::SetGammaCurve(float gammaCurve)
+{
+   gammaCurve_ = gammaCurve;
+}
+
+void World::SetCurveOffset(float curveOffset)
+{
+   curveOffset_ = curveOffset;
+}
+
 bool World::ProtobufSerialize(std::string& output) const
 {
    bool success = false;
@@ -1580,15 +1836,11 @@ void World::SetArrayData(const U* source, boost::multi_array<T, 2>& dest)
 {
    dest.resize(boost::extents[size_.height_][size_.width_]);
 
-   for (uint32_t y = 0; y < size_.height_; y++)
-   {
-      uint32_t rowOffset = y * size_.width_;
-
-      for (uint32_t x = 0; x < size_.width_; x++)
-      {
-         dest[y][x] = static_cast<T>(source[x + rowOffset]);
-      }
-   }
+   // World layers are contiguous, so the source is copied as a single array
+   std::transform(source,
+                  source + dest.num_elements(),
+                  dest.data(),
+                  [](const U& value) { return static_cast<T>(value); });
 }
 
 template<class T, class U, class V>
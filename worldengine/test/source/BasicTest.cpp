@@ -2,6 +2,8 @@
 
 #include <basic.h>
 
+#include <OpenSimplexNoise.h>
+
 namespace WorldEngine
 {
 
@@ -97,6 +99,57 @@ TEST(BasicTest, AntiAlias5x3Test)
    EXPECT_FLOAT_EQ(map[1][2], 0.49181818f);
 }
 
+TEST(BasicTest, AntiAliasReferenceTest)
+{
+   const int32_t width  = 29;
+   const int32_t height = 37;
+   const size_t  steps  = 3;
+
+   boost::multi_array<float, 2> map(boost::extents[height][width]);
+   for (int32_t y = 0; y < height; y++)
+   {
+      for (int32_t x = 0; x < width; x++)
+      {
+         map[y][x] = static_cast<float>((x * 7 + y * y * 3) % 23) / 11.0f;
+      }
+   }
+
+   // Direct 3x3 neighborhood, wrapping around both axes
+   boost::multi_array<float, 2> expected(map);
+   boost::multi_array<float, 2> next(map);
+   for (size_t i = 0; i < steps; i++)
+   {
+      for (int32_t y = 0; y < height; y++)
+      {
+         for (int32_t x = 0; x < width; x++)
+         {
+            float sum = 0.0f;
+            for (int32_t dy = -1; dy <= 1; dy++)
+            {
+               for (int32_t dx = -1; dx <= 1; dx++)
+               {
+                  sum += expected[(y + dy + height) % height]
+                                 [(x + dx + width) % width];
+               }
+            }
+            next[y][x] = sum / 11.0f + map[y][x] * 2.0f / 11.0f;
+         }
+      }
+      expected = next;
+   }
+
+   AntiAlias(map, steps);
+
+   for (int32_t y = 0; y < height; y++)
+   {
+      for (int32_t x = 0; x < width; x++)
+      {
+         EXPECT_NEAR(map[y][x], expected[y][x], 1e-5f)
+            << "(x, y) = (" << x << ", " << y << ")";
+      }
+   }
+}
+
 TEST(BasicTest, CountNeighborsTest)
 {
    boost::multi_array<bool, 2> map(boost::extents[3][3]);
@@ -123,4 +176,243 @@ TEST(BasicTest, CountNeighborsTest)
    EXPECT_EQ(n[2][2], 3);
 }
 
+TEST(BasicTest, DistanceTransformTest)
+{
+   const int32_t width  = 37;
+   const int32_t height = 23;
+
+   boost::multi_array<bool, 2>  features(boost::extents[height][width]);
+   boost::multi_array<float, 2> distance(boost::extents[height][width]);
+
+   // No features
+   std::fill(features.data(), features.data() + features.num_elements(), false);
+   DistanceTransform(MakeLayerView(features),
+                     MakeLayerView(distance),
+                     DistanceMetric::Euclidean);
+   EXPECT_TRUE(std::isinf(distance[11][18]));
+
+   // Sparse features, compared against a brute force search
+   for (int32_t y = 0; y < height; y++)
+   {
+      for (int32_t x = 0; x < width; x++)
+      {
+         features[y][x] = ((x * 7 + y * 13) % 41 == 0);
+      }
+   }
+
+   for (DistanceMetric metric :
+        {DistanceMetric::Chebyshev, DistanceMetric::Euclidean})
+   {
+      DistanceTransform(
+         MakeLayerView(features), MakeLayerView(distance), metric);
+
+      for (int32_t y = 0; y < height; y++)
+      {
+         for (int32_t x = 0; x < width; x++)
+         {
+            float expected = std::numeric_limits<float>::infinity();
+
+            for (int32_t fy = 0; fy < height; fy++)
+            {
+               for (int32_t fx = 0; fx < width; fx++)
+               {
+                  if (features[fy][fx])
+                  {
+                     float dx = static_cast<float>(std::abs(fx - x));
+                     float dy = static_cast<float>(std::abs(fy - y));
+                     float d  = (metric == DistanceMetric::Chebyshev)
+                                   ? std::max(dx, dy)
+                                   : std::sqrt(dx * dx + dy * dy);
+                     expected = std::min(expected, d);
+                  }
+               }
+            }
+
+            EXPECT_FLOAT_EQ(distance[y][x], expected)
+               << "(x, y) = (" << x << ", " << y << ")";
+         }
+      }
+   }
+}
+
+TEST(BasicTest, CountNeighborsRadiusTest)
+{
+   const int32_t width  = 83;
+   const int32_t height = 71;
+
+   boost::multi_array<bool, 2>  mask(boost::extents[height][width]);
+   boost::multi_array<float, 2> maskF(boost::extents[height][width]);
+
+   for (int32_t y = 0; y < height; y++)
+   {
+      for (int32_t x = 0; x < width; x++)
+      {
+         mask[y][x]  = ((x * x + y * 5) % 7 < 3);
+         maskF[y][x] = mask[y][x] ? 0.5f : 0.0f;
+      }
+   }
+
+   for (int32_t radius : {0, 1, 3, 9, 40, 100})
+   {
+      boost::multi_array<uint32_t, 2> n  = CountNeighbors(mask, radius);
+      boost::multi_array<uint32_t, 2> nF = CountNeighbors(maskF, radius);
+
+      for (int32_t y = 0; y < height; y++)
+      {
+         for (int32_t x = 0; x < width; x++)
+         {
+            uint32_t expected = 0u;
+            for (int32_t ny = std::max(y - radius, 0);
+                 ny <= std::min(y + radius, height - 1);
+                 ny++)
+            {
+               for (int32_t nx = std::max(x - radius, 0);
+                    nx <= std::min(x + radius, width - 1);
+                    nx++)
+               {
+                  if ((nx != x || ny != y) && mask[ny][nx])
+                  {
+                     expected++;
+                  }
+               }
+            }
+
+            ASSERT_EQ(n[y][x], expected)
+               << "radius " << radius << ", (x, y) = (" << x << ", " << y
+               << ")";
+            ASSERT_EQ(nF[y][x], expected)
+               << "radius " << radius << ", (x, y) = (" << x << ", " << y
+               << ")";
+         }
+      }
+   }
+}
+
+TEST(BasicTest, FindThresholdTest)
+{
+   const size_t width  = 10;
+   const size_t height = 10;
+
+   boost::multi_array<float, 2> mapData(boost::extents[height][width]);
+   OceanArrayType               ocean(boost::extents[height][width]);
+
+   // Values 0-99 in reverse order, with the lower half of the values in ocean
+   for (size_t y = 0; y < height; y++)
+   {
+      for (size_t x = 0; x < width; x++)
+      {
+         float value   = static_cast<float>(99 - (y * width + x));
+         mapData[y][x] = value;
+         ocean[y][x]   = (value < 50.0f);
+      }
+   }
+
+   std::vector<float> thresholds =
+      FindThresholdsF(mapData, {1.0f, 0.5f, 0.1f, 0.0f});
+
+   ASSERT_EQ(thresholds.size(), 4u);
+   EXPECT_FLOAT_EQ(thresholds[0], 0.0f);
+   EXPECT_FLOAT_EQ(thresholds[1], 49.5f);
+   EXPECT_FLOAT_EQ(thresholds[2], 89.1f);
+   EXPECT_FLOAT_EQ(thresholds[3], 99.0f);
+
+   EXPECT_FLOAT_EQ(FindThresholdF(mapData, 0.5f, &ocean), 74.5f);
+   EXPECT_FLOAT_EQ(FindThresholdF(mapData, 0.02f, &ocean), 98.02f);
+
+   // Without land, thresholds are 0
+   std::fill(ocean.data(), ocean.data() + ocean.num_elements(), true);
+   EXPECT_EQ(FindThresholdF(mapData, 0.5f, &ocean), 0.0f);
+}
+
+TEST(BasicTest, PowApproxTest)
+{
+   EXPECT_EQ(PowApprox(0.0f, 1.25f), 0.0f);
+   EXPECT_FLOAT_EQ(PowApprox(1.0f, 1.25f), 1.0f);
+
+   for (float exponent : {0.5f, 1.0f, 1.25f, 2.0f, 3.7f})
+   {
+      for (uint32_t i = 1; i <= 1000; i++)
+      {
+         float base     = i / 1000.0f;
+         float expected = std::pow(base, exponent);
+
+         EXPECT_NEAR(PowApprox(base, exponent), expected, expected * 1e-5f)
+            << base << " ^ " << exponent;
+      }
+   }
+}
+
+TEST(BasicTest, QuantizeLevelsTest)
+{
+   const uint32_t width  = 5;
+   const uint32_t height = 2;
+
+   const float thresholds[] = {0.0f, 1.0f, 1.0f, 4.0f};
+
+   const float values[height][width] = {
+      {-1.0f, 0.0f, 0.5f, 1.0f, 3.0f},
+      {4.0f, 100.0f, std::numeric_limits<float>::quiet_NaN(), -0.1f, 0.9f}};
+   const uint8_t expected[height][width] = {{0, 1, 1, 3, 3}, //
+                                            {3, 3, 3, 0, 1}};
+
+   uint8_t levels[height][width];
+
+   QuantizeLevels(LayerView<const float>(&values[0][0], width, height, width),
+                  thresholds,
+                  4u,
+                  LayerView<uint8_t>(&levels[0][0], width, height, width));
+
+   for (uint32_t y = 0; y < height; y++)
+   {
+      for (uint32_t x = 0; x < width; x++)
+      {
+         EXPECT_EQ(levels[y][x], expected[y][x]) << x << ", " << y;
+      }
+   }
+}
+
+TEST(BasicTest, NoiseFieldTest)
+{
+   const int32_t  width   = 40;
+   const int32_t  height  = 30;
+   const uint32_t octaves = 6;
+   const float    freq    = 64.0f * octaves;
+   const float    nScale  = 1024.0f / height;
+   const int32_t  border  = width / 4;
+
+   NoiseGenerator noise(1618);
+
+   boost::multi_array<double, 2> field(boost::extents[height][width]);
+
+   NoiseField(noise,
+              width,
+              height,
+              nScale,
+              freq,
+              octaves,
+              true,
+              [&](int32_t x, int32_t y, double n) { field[y][x] = n; });
+
+   for (int32_t y = 0; y < height; y++)
+   {
+      for (int32_t x = 0; x < width; x++)
+      {
+         double n = Noise(
+            noise.noise(), x * nScale / freq, y * nScale / freq, octaves);
+
+         if (x <= border)
+         {
+            n *= static_cast<double>(x) / border;
+            n += Noise(noise.noise(),
+                       (x * nScale + width) / freq,
+                       y * nScale / freq,
+                       octaves) *
+                 (border - x) / border;
+         }
+
+         EXPECT_EQ(field[y][x], n) << "(x, y) = (" << x << ", " << y << ")";
+      }
+   }
+}
+
 } // namespace WorldEngine
@@ -1,10 +1,17 @@
 #include "Functions.h"
 
+#include <filesystem>
+#include <random>
+
 #include <gtest/gtest.h>
 
 #include <basic.h>
+#include <parallel.h>
+#include <simulations/biome.h>
+#include <simulations/erosion.h>
 #include <worldengine/generation.h>
 #include <worldengine/plates.h>
+#include <worldengine/plates_cache.h>
 
 namespace WorldEngine
 {
@@ -18,6 +25,201 @@ TEST(PlatesTest, WorldGenTest)
    EXPECT_NE(world, nullptr);
 }
 
+TEST(PlatesTest, PlatesBudgetTest)
+{
+   static const uint32_t width  = 32u;
+   static const uint32_t height = 16u;
+   static const uint32_t seed   = 7u;
+
+   float*       heightmap;
+   uint32_t*    platesmap;
+   PlatesStatus status;
+   uint32_t     numCallbacks = 0u;
+
+   // Without limits, the simulation converges, reporting each step
+   PlatesBudget budget;
+   budget.callback_ = [&](const PlatesProgress& progress)
+   {
+      EXPECT_EQ(progress.step_, ++numCallbacks);
+      return true;
+   };
+
+   void* p = GeneratePlatesSimulation(&heightmap,
+                                      &platesmap,
+                                      seed,
+                                      width,
+                                      height,
+                                      DEFAULT_SEA_LEVEL,
+                                      DEFAULT_EROSION_PERIOD,
+                                      DEFAULT_FOLDING_RATIO,
+                                      DEFAULT_AGGR_OVERLAP_ABS,
+                                      DEFAULT_AGGR_OVERLAP_REL,
+                                      DEFAULT_CYCLE_COUNT,
+                                      DEFAULT_NUM_PLATES,
+                                      budget,
+                                      &status);
+   PlatecApiDestroy(p);
+
+   EXPECT_EQ(status, PlatesStatus::Finished);
+   ASSERT_GT(numCallbacks, 1u);
+
+   // A step budget truncates the simulation
+   const uint32_t numSteps = numCallbacks;
+   numCallbacks            = 0u;
+   budget.maxSteps_        = numSteps - 1u;
+
+   p = GeneratePlatesSimulation(&heightmap,
+                                &platesmap,
+                                seed,
+                                width,
+                                height,
+                                DEFAULT_SEA_LEVEL,
+                                DEFAULT_EROSION_PERIOD,
+                                DEFAULT_FOLDING_RATIO,
+                                DEFAULT_AGGR_OVERLAP_ABS,
+                                DEFAULT_AGGR_OVERLAP_REL,
+                                DEFAULT_CYCLE_COUNT,
+                                DEFAULT_NUM_PLATES,
+                                budget,
+                                &status);
+   PlatecApiDestroy(p);
+
+   EXPECT_EQ(status, PlatesStatus::Truncated);
+   EXPECT_EQ(numCallbacks, numSteps - 1u);
+
+   // A world reports whether its plates simulation was truncated
+   auto GenerateWithBudget = [&](const PlatesBudget& platesBudget)
+   {
+      return WorldGen("Dummy",
+                      width,
+                      height,
+                      seed,
+                      DEFAULT_TEMPS,
+                      DEFAULT_HUMIDS,
+                      DEFAULT_GAMMA_CURVE,
+                      DEFAULT_CURVE_OFFSET,
+                      DEFAULT_NUM_PLATES,
+                      DEFAULT_OCEAN_LEVEL,
+                      DEFAULT_STEP,
+                      DEFAULT_FADE_BORDERS,
+                      nullptr,
+                      nullptr,
+                      platesBudget);
+   };
+
+   PlatesBudget tinyBudget;
+   tinyBudget.maxSteps_ = 1u;
+
+   std::shared_ptr<World> truncated = GenerateWithBudget(tinyBudget);
+   ASSERT_NE(truncated, nullptr);
+   EXPECT_EQ(truncated->GetGenerationRecord().platesStatus_,
+             PlatesStatus::Truncated);
+
+   std::shared_ptr<World> finished = GenerateWithBudget(PlatesBudget());
+   ASSERT_NE(finished, nullptr);
+   EXPECT_EQ(finished->GetGenerationRecord().platesStatus_,
+             PlatesStatus::Finished);
+
+   // Cancelling the simulation cancels world generation
+   PlatesBudget cancelBudget;
+   cancelBudget.callback_ = [](const PlatesProgress&) { return false; };
+
+   std::shared_ptr<World> world = WorldGen("Dummy",
+                                           width,
+                                           height,
+                                           seed,
+                                           DEFAULT_TEMPS,
+                                           DEFAULT_HUMIDS,
+                                           DEFAULT_GAMMA_CURVE,
+                                           DEFAULT_CURVE_OFFSET,
+                                           DEFAULT_NUM_PLATES,
+                                           DEFAULT_OCEAN_LEVEL,
+                                           DEFAULT_STEP,
+                                           DEFAULT_FADE_BORDERS,
+                                           nullptr,
+                                           nullptr,
+                                           cancelBudget);
+
+   EXPECT_EQ(world, nullptr);
+}
+
+TEST(PlatesTest, PlatesCacheTest)
+{
+   static const uint32_t width  = 32u;
+   static const uint32_t height = 16u;
+   static const uint32_t seed   = 7u;
+
+   const std::filesystem::path directory =
+      std::filesystem::temp_directory_path() / "worldengine_plates_cache_test";
+   std::filesystem::remove_all(directory);
+
+   PlatesCache cache(directory.string());
+
+   PlatesParameters parameters;
+   parameters.seed_   = seed;
+   parameters.width_  = width;
+   parameters.height_ = height;
+
+   std::vector<float>    heightmap;
+   std::vector<uint32_t> platesmap;
+
+   EXPECT_FALSE(cache.Load(parameters, heightmap, platesmap));
+
+   // The first world populates the cache, and the second loads from it
+   std::shared_ptr<World> expected = WorldGen("Dummy", width, height, seed);
+   std::shared_ptr<World> populated = WorldGen("Dummy",
+                                               width,
+                                               height,
+                                               seed,
+                                               DEFAULT_TEMPS,
+                                               DEFAULT_HUMIDS,
+                                               DEFAULT_GAMMA_CURVE,
+                                               DEFAULT_CURVE_OFFSET,
+                                               DEFAULT_NUM_PLATES,
+                                               DEFAULT_OCEAN_LEVEL,
+                                               DEFAULT_STEP,
+                                               DEFAULT_FADE_BORDERS,
+                                               nullptr,
+                                               &cache);
+
+   ASSERT_TRUE(cache.Load(parameters, heightmap, platesmap));
+   EXPECT_EQ(heightmap.size(), width * height);
+   EXPECT_EQ(platesmap.size(), width * height);
+
+   std::shared_ptr<World> loaded = WorldGen("Dummy",
+                                            width,
+                                            height,
+                                            seed,
+                                            DEFAULT_TEMPS,
+                                            DEFAULT_HUMIDS,
+                                            DEFAULT_GAMMA_CURVE,
+                                            DEFAULT_CURVE_OFFSET,
+                                            DEFAULT_NUM_PLATES,
+                                            DEFAULT_OCEAN_LEVEL,
+                                            DEFAULT_STEP,
+                                            DEFAULT_FADE_BORDERS,
+                                            nullptr,
+                                            &cache);
+
+   for (const std::shared_ptr<World>& w : {populated, loaded})
+   {
+      EXPECT_EQ(w->GetElevationData(), expected->GetElevationData());
+      EXPECT_EQ(w->GetBiomeData(), expected->GetBiomeData());
+   }
+
+   // Other parameters do not match the cached result
+   PlatesParameters otherParameters = parameters;
+   otherParameters.numPlates_++;
+   EXPECT_NE(cache.Filename(otherParameters), cache.Filename(parameters));
+   EXPECT_FALSE(cache.Load(otherParameters, heightmap, platesmap));
+
+   // A truncated file is a miss
+   std::filesystem::resize_file(cache.Filename(parameters), 64u);
+   EXPECT_FALSE(cache.Load(parameters, heightmap, platesmap));
+
+   std::filesystem::remove_all(directory);
+}
+
 TEST(GenerationTest, CenterLandTest)
 {
    const std::string      worldFilename = "/data/seed_1618.world";
@@ -108,6 +310,456 @@ TEST(GenerationTest, SeaDepthTest)
    }
 }
 
+TEST(GenerationTest, FillOceanTest)
+{
+   static const size_t width      = 9u;
+   static const size_t height     = 7u;
+   static const float  oceanLevel = 1.0f;
+
+   // Cells below sea level are marked '.', or 'o' if connected to the border.
+   // Diagonal steps connect cells.
+   static const char* map[height] = {"oo#######",
+                                     "#oo######",
+                                     "##o##...#",
+                                     "###o#.#.#",
+                                     "#####...#",
+                                     "#o#######",
+                                     "o#ooooooo"};
+
+   // Fill the ocean of a map, using the scanline fill with one thread and
+   // the parallel labeling otherwise
+   auto FillOcean = [](size_t   width,
+                       size_t   height,
+                       auto     elevationAt,
+                       uint32_t numThreads)
+   {
+      std::shared_ptr<World> w = std::make_shared<World>(
+         "fillOcean",
+         Size(width, height),
+         0,
+         GenerationParameters(0, oceanLevel, StepType::Full));
+
+      ElevationArrayType& elevation = w->GetElevationData();
+      elevation.resize(boost::extents[height][width]);
+
+      for (size_t y = 0; y < height; y++)
+      {
+         for (size_t x = 0; x < width; x++)
+         {
+            elevation[y][x] = elevationAt(x, y);
+         }
+      }
+
+      SetNumThreads(numThreads);
+      InitializeOceanAndThresholds(*w, oceanLevel);
+      SetNumThreads(0u);
+
+      return OceanArrayType(w->GetOceanData());
+   };
+
+   auto MapElevation = [&](size_t x, size_t y)
+   { return (map[y][x] == '#') ? 2.0f : 0.0f; };
+
+   for (uint32_t numThreads : {1u, 4u})
+   {
+      OceanArrayType ocean = FillOcean(width, height, MapElevation, numThreads);
+
+      for (size_t y = 0; y < height; y++)
+      {
+         for (size_t x = 0; x < width; x++)
+         {
+            EXPECT_EQ(ocean[y][x], map[y][x] == 'o')
+               << "(x, y) = (" << x << ", " << y << "), numThreads = "
+               << numThreads;
+         }
+      }
+   }
+
+   // Both fills agree on a map with many basins, some spanning several bands
+   // of rows. Cells are below sea level near the percolation threshold.
+   std::mt19937                          generator(1u);
+   std::uniform_real_distribution<float> distribution(0.0f, 2.4f);
+   boost::multi_array<float, 2>          noise(boost::extents[96][128]);
+   std::generate(noise.data(),
+                 noise.data() + noise.num_elements(),
+                 [&]() { return distribution(generator); });
+
+   auto NoiseElevation = [&](size_t x, size_t y) { return noise[y][x]; };
+
+   OceanArrayType ocean = FillOcean(128u, 96u, NoiseElevation, 1u);
+
+   auto numOcean =
+      std::count(ocean.data(), ocean.data() + ocean.num_elements(), true);
+   auto numBelow = std::count_if(noise.data(),
+                                 noise.data() + noise.num_elements(),
+                                 [](float e) { return e < oceanLevel; });
+   EXPECT_GT(numOcean, 0);
+   EXPECT_LT(numOcean, numBelow);
+
+   EXPECT_EQ(ocean, FillOcean(128u, 96u, NoiseElevation, 4u));
+}
+
+TEST(GenerationTest, LayerViewTest)
+{
+   static const uint32_t width  = 5u;
+   static const uint32_t height = 3u;
+
+   World w("layerView",
+           Size(width, height),
+           0,
+           GenerationParameters(0, 1.0f, StepType::Full));
+
+   ElevationArrayType& elevation = w.GetElevationData();
+   elevation.resize(boost::extents[height][width]);
+
+   LayerView<ElevationDataType> view = w.GetElevationView();
+
+   EXPECT_EQ(view.data(), elevation.data());
+   EXPECT_EQ(view.width(), width);
+   EXPECT_EQ(view.height(), height);
+   EXPECT_EQ(view.size(), elevation.num_elements());
+   EXPECT_TRUE(view.contiguous());
+
+   for (uint32_t y = 0; y < height; y++)
+   {
+      for (uint32_t x = 0; x < width; x++)
+      {
+         view[y][x] = static_cast<float>(y * width + x);
+      }
+   }
+
+   LayerView<const ElevationDataType> constView = view;
+
+   for (uint32_t y = 0; y < height; y++)
+   {
+      for (uint32_t x = 0; x < width; x++)
+      {
+         EXPECT_EQ(elevation[y][x], static_cast<float>(y * width + x));
+         EXPECT_EQ(constView(x, y), elevation[y][x]);
+      }
+   }
+}
+
+TEST(GenerationTest, SetLayerDataTest)
+{
+   static const uint32_t width  = 5u;
+   static const uint32_t height = 3u;
+
+   World w("setLayerData",
+           Size(width, height),
+           0,
+           GenerationParameters(0, 1.0f, StepType::Full));
+
+   std::vector<float>    heightmap(width * height);
+   std::vector<uint32_t> platesmap(width * height);
+
+   for (uint32_t i = 0; i < width * height; i++)
+   {
+      heightmap[i] = static_cast<float>(i) * 0.5f;
+      platesmap[i] = i % 4u;
+   }
+
+   EXPECT_FALSE(LayerDiagnostics());
+
+   w.SetElevationData(heightmap.data());
+   w.SetPlatesData(platesmap.data());
+
+   for (uint32_t y = 0; y < height; y++)
+   {
+      for (uint32_t x = 0; x < width; x++)
+      {
+         EXPECT_EQ(w.GetElevationData()[y][x], heightmap[y * width + x]);
+         EXPECT_EQ(w.GetPlateData()[y][x], platesmap[y * width + x]);
+      }
+   }
+}
+
+TEST(GenerationTest, ScratchArenaTest)
+{
+   ScratchArena arena(1024u);
+
+   LayerView<int32_t> first  = arena.AllocateLayer(16u, 8u, -1);
+   LayerView<float>   second = arena.AllocateLayer<float>(32u, 32u);
+
+   EXPECT_EQ(reinterpret_cast<uintptr_t>(first.data()) % SCRATCH_ALIGNMENT,
+             0u);
+   EXPECT_EQ(reinterpret_cast<uintptr_t>(second.data()) % SCRATCH_ALIGNMENT,
+             0u);
+   EXPECT_TRUE(std::all_of(first.data(),
+                           first.data() + first.size(),
+                           [](int32_t value) { return value == -1; }));
+
+   // The second layer did not fit in the first block
+   size_t capacity = arena.capacity();
+   EXPECT_GT(capacity, 1024u);
+
+   arena.Reset();
+   EXPECT_EQ(arena.used(), 0u);
+   EXPECT_EQ(arena.capacity(), capacity);
+
+   // A scope releases its allocations, including on the exception path
+   arena.AllocateLayer<uint8_t>(8u, 8u);
+   size_t used = arena.used();
+
+   try
+   {
+      ScratchScope scope(arena);
+      arena.AllocateLayer<float>(64u, 64u);
+      EXPECT_GT(arena.used(), used);
+      throw std::runtime_error("stage failed");
+   }
+   catch (const std::runtime_error&)
+   {
+   }
+
+   EXPECT_EQ(arena.used(), used);
+   EXPECT_EQ(arena.capacity(), capacity);
+
+   arena.Reset();
+
+   // Worlds generated with a shared arena match worlds generated without one
+   std::shared_ptr<World> expected = WorldGen("Dummy", 32, 16, 1);
+
+   for (uint32_t i = 0; i < 2; i++)
+   {
+      std::shared_ptr<World> w = WorldGen("Dummy",
+                                          32,
+                                          16,
+                                          1,
+                                          DEFAULT_TEMPS,
+                                          DEFAULT_HUMIDS,
+                                          DEFAULT_GAMMA_CURVE,
+                                          DEFAULT_CURVE_OFFSET,
+                                          DEFAULT_NUM_PLATES,
+                                          DEFAULT_OCEAN_LEVEL,
+                                          DEFAULT_STEP,
+                                          DEFAULT_FADE_BORDERS,
+                                          &arena);
+
+      EXPECT_EQ(w->GetElevationData(), expected->GetElevationData());
+      EXPECT_EQ(w->GetSeaDepthData(), expected->GetSeaDepthData());
+      EXPECT_EQ(w->GetRiverMapData(), expected->GetRiverMapData());
+      EXPECT_EQ(w->GetLakeMapData(), expected->GetLakeMapData());
+      EXPECT_EQ(arena.used(), 0u);
+   }
+
+   // Stages release their layers when they return, rather than holding them
+   // until generation completes
+   std::shared_ptr<World> w = WorldGen("Dummy", 32, 16, 1);
+   arena.AllocateLayer<uint8_t>(8u, 8u);
+   used = arena.used();
+
+   ErosionSimulation(*w, &arena);
+   EXPECT_EQ(arena.used(), used);
+
+   BiomeSimulation(*w, &arena);
+   EXPECT_EQ(arena.used(), used);
+}
+
+TEST(GenerationTest, RegenerateTest)
+{
+   static const uint32_t width  = 64u;
+   static const uint32_t height = 32u;
+   static const uint32_t seed   = 5u;
+
+   const std::vector<float> temps      = {0.1f, 0.2f, 0.3f, 0.5f, 0.7f, 0.9f};
+   const std::vector<float> humids     = {0.02f, 0.07f, 0.15f, 0.3f, 0.5f, 0.7f,
+                                          0.9f};
+   const float              gammaCurve = 1.5f;
+
+   std::shared_ptr<World> w = WorldGen("regenerate", width, height, seed);
+
+   // Only the cells changed by erosion are kept to repeat it
+   size_t numChanges = w->GetGenerationRecord().erosionChanges_.size();
+   EXPECT_GT(numChanges, 0u);
+   EXPECT_LT(numChanges, static_cast<size_t>(width) * height);
+
+   // Changing thresholds does not repeat any simulation
+   uint32_t temperatureVersion = w->GetLayerVersion(Layer::Temperature);
+   uint32_t humidityVersion    = w->GetLayerVersion(Layer::Humidity);
+   uint32_t biomeVersion       = w->GetLayerVersion(Layer::Biome);
+
+   w->SetTemps(temps);
+   w->SetHumids(humids);
+   Regenerate(*w, {Parameter::Temps, Parameter::Humids});
+
+   EXPECT_EQ(w->GetLayerVersion(Layer::Temperature), temperatureVersion);
+   EXPECT_EQ(w->GetLayerVersion(Layer::Humidity), humidityVersion);
+   EXPECT_NE(w->GetLayerVersion(Layer::Biome), biomeVersion);
+
+   // Changing the gamma curve repeats every simulation after temperature,
+   // eroding the elevation from before erosion
+   uint32_t permeabilityVersion = w->GetLayerVersion(Layer::Permeability);
+
+   w->SetGammaCurve(gammaCurve);
+   Regenerate(*w, {Parameter::GammaCurve});
+
+   EXPECT_EQ(w->GetLayerVersion(Layer::Temperature), temperatureVersion);
+   EXPECT_EQ(w->GetLayerVersion(Layer::Permeability), permeabilityVersion);
+   EXPECT_NE(w->GetLayerVersion(Layer::Humidity), humidityVersion);
+
+   std::shared_ptr<World> expected = WorldGen(
+      "regenerate", width, height, seed, temps, humids, gammaCurve);
+
+   EXPECT_EQ(w->GetElevationData(), expected->GetElevationData());
+   EXPECT_EQ(w->GetOceanData(), expected->GetOceanData());
+   EXPECT_EQ(w->GetPlateData(), expected->GetPlateData());
+   EXPECT_EQ(w->GetSeaDepthData(), expected->GetSeaDepthData());
+   EXPECT_EQ(w->GetTemperatureData(), expected->GetTemperatureData());
+   EXPECT_EQ(w->GetPrecipitationData(), expected->GetPrecipitationData());
+   EXPECT_EQ(w->GetRiverMapData(), expected->GetRiverMapData());
+   EXPECT_EQ(w->GetLakeMapData(), expected->GetLakeMapData());
+   EXPECT_EQ(w->GetWaterMapData(), expected->GetWaterMapData());
+   EXPECT_EQ(w->GetIrrigationData(), expected->GetIrrigationData());
+   EXPECT_EQ(w->GetHumidityData(), expected->GetHumidityData());
+   EXPECT_EQ(w->GetPermeabilityData(), expected->GetPermeabilityData());
+   EXPECT_EQ(w->GetBiomeData(), expected->GetBiomeData());
+   EXPECT_EQ(w->GetIcecapData(), expected->GetIcecapData());
+
+   for (HumidityLevel level : HumidityIterator())
+   {
+      EXPECT_EQ(w->GetThreshold(level), expected->GetThreshold(level));
+   }
+   for (TemperatureLevel level : TemperatureIterator())
+   {
+      EXPECT_EQ(w->GetThreshold(level), expected->GetThreshold(level));
+   }
+   for (WaterThreshold threshold : WaterIterator())
+   {
+      EXPECT_EQ(w->GetThreshold(threshold), expected->GetThreshold(threshold));
+   }
+   for (PermeabilityLevel level : PermeabilityIterator())
+   {
+      EXPECT_EQ(w->GetThreshold(level), expected->GetThreshold(level));
+   }
+
+   // Nothing is repeated without a change
+   biomeVersion = w->GetLayerVersion(Layer::Biome);
+   Regenerate(*w, {});
+   EXPECT_EQ(w->GetLayerVersion(Layer::Biome), biomeVersion);
+
+   // Editing a layer repeats the simulations consuming it, but not the
+   // simulation which wrote it
+   uint32_t precipitationVersion = w->GetLayerVersion(Layer::Precipitation);
+   uint32_t lastVersion          = w->GetGenerationRecord().lastVersion_;
+
+   w->GetTemperatureData()[0][0] += 0.1f;
+   temperatureVersion = w->MarkLayerEdited(Layer::Temperature);
+   EXPECT_EQ(temperatureVersion, lastVersion + 1u);
+
+   Regenerate(*w, {});
+
+   EXPECT_EQ(w->GetLayerVersion(Layer::Temperature), temperatureVersion);
+   EXPECT_NE(w->GetLayerVersion(Layer::Precipitation), precipitationVersion);
+   EXPECT_NE(w->GetLayerVersion(Layer::Biome), biomeVersion);
+}
+
+TEST(GenerationTest, CounterRandomThreadsTest)
+{
+   static const uint32_t width  = 128u;
+   static const uint32_t height = 64u;
+   static const uint32_t seed   = 3u;
+
+   Step step        = STEP_FULL;
+   step.randomMode_ = RandomMode::CounterBased;
+
+   auto Generate = [&](uint32_t numThreads)
+   {
+      SetNumThreads(numThreads);
+      std::shared_ptr<World> world = WorldGen("counter",
+                                              width,
+                                              height,
+                                              seed,
+                                              DEFAULT_TEMPS,
+                                              DEFAULT_HUMIDS,
+                                              DEFAULT_GAMMA_CURVE,
+                                              DEFAULT_CURVE_OFFSET,
+                                              DEFAULT_NUM_PLATES,
+                                              DEFAULT_OCEAN_LEVEL,
+                                              step);
+      SetNumThreads(0u);
+      return world;
+   };
+
+   // Counter-based random numbers do not depend on the number of threads
+   std::shared_ptr<World> expected = Generate(1u);
+
+   for (uint32_t numThreads : {2u, 5u})
+   {
+      std::shared_ptr<World> w = Generate(numThreads);
+
+      EXPECT_EQ(w->GetIcecapData(), expected->GetIcecapData())
+         << "numThreads = " << numThreads;
+      EXPECT_EQ(w->GetWaterMapData(), expected->GetWaterMapData())
+         << "numThreads = " << numThreads;
+      EXPECT_EQ(w->GetPermeabilityData(), expected->GetPermeabilityData())
+         << "numThreads = " << numThreads;
+      EXPECT_EQ(w->GetRiverMapData(), expected->GetRiverMapData())
+         << "numThreads = " << numThreads;
+      EXPECT_EQ(w->GetLakeMapData(), expected->GetLakeMapData())
+         << "numThreads = " << numThreads;
+
+      for (WaterThreshold threshold : WaterIterator())
+      {
+         EXPECT_EQ(w->GetThreshold(threshold),
+                   expected->GetThreshold(threshold));
+      }
+      for (PermeabilityLevel level : PermeabilityIterator())
+      {
+         EXPECT_EQ(w->GetThreshold(level), expected->GetThreshold(level));
+      }
+   }
+}
+
+TEST(GenerationTest, ErosionThreadsTest)
+{
+   static const uint32_t width  = 256u;
+   static const uint32_t height = 128u;
+   static const uint32_t seed   = 7u;
+
+   Step step         = STEP_FULL;
+   step.erosionMode_ = ErosionMode::Search;
+
+   auto Generate = [&](uint32_t numThreads)
+   {
+      SetNumThreads(numThreads);
+      std::shared_ptr<World> world = WorldGen("erosion",
+                                              width,
+                                              height,
+                                              seed,
+                                              DEFAULT_TEMPS,
+                                              DEFAULT_HUMIDS,
+                                              DEFAULT_GAMMA_CURVE,
+                                              DEFAULT_CURVE_OFFSET,
+                                              DEFAULT_NUM_PLATES,
+                                              DEFAULT_OCEAN_LEVEL,
+                                              step);
+      SetNumThreads(0u);
+      return world;
+   };
+
+   // Rivers traced concurrently match rivers traced in the order of their
+   // sources
+   std::shared_ptr<World>   expected = Generate(1u);
+   const RiverMapArrayType& rivers   = expected->GetRiverMapData();
+
+   ASSERT_TRUE(std::any_of(rivers.data(),
+                           rivers.data() + rivers.num_elements(),
+                           [](float flow) { return flow > 0.0f; }));
+
+   for (uint32_t numThreads : {2u, 4u, 7u})
+   {
+      std::shared_ptr<World> w = Generate(numThreads);
+
+      EXPECT_EQ(w->GetElevationData(), expected->GetElevationData())
+         << "numThreads = " << numThreads;
+      EXPECT_EQ(w->GetRiverMapData(), expected->GetRiverMapData())
+         << "numThreads = " << numThreads;
+      EXPECT_EQ(w->GetLakeMapData(), expected->GetLakeMapData())
+         << "numThreads = " << numThreads;
+   }
+}
+
 static float MeanElevationAtBorders(const World& world)
 {
    float totalElevation = 0.0f;
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <basic.h>
+#include <noise.h>
+
+#include <cmath>
+
+#include <OpenSimplexNoise.h>
+
+namespace WorldEngine
+{
+
+TEST(NoiseTest, EvaluateTest)
+{
+   // Odd count exercises the partial vector at the end of the batch
+   const size_t numPoints = 1001u;
+
+   std::vector<double> x(numPoints);
+   std::vector<double> y(numPoints);
+   std::vector<double> result(numPoints);
+
+   for (size_t i = 0; i < numPoints; i++)
+   {
+      x[i] = -250.0 + 0.4999 * static_cast<double>(i);
+      y[i] = 125.0 - 0.2501 * static_cast<double>(i % 997);
+   }
+
+   for (int64_t seed : {0ll, 1ll, 1618ll, -42ll, 4294967295ll})
+   {
+      NoiseGenerator noise(seed);
+
+      // The batched kernel agrees with the library, and is not bypassed
+      EXPECT_NE(noise.instructionSet(), NoiseInstructionSet::Reference);
+
+      for (uint32_t octaves : {1u, 6u})
+      {
+         noise.Evaluate(x.data(), y.data(), numPoints, octaves, result.data());
+
+         for (size_t i = 0; i < numPoints; i++)
+         {
+            EXPECT_EQ(result[i], Noise(noise.noise(), x[i], y[i], octaves))
+               << "seed = " << seed << ", (x, y) = (" << x[i] << ", " << y[i]
+               << ")";
+         }
+      }
+   }
+}
+
+TEST(NoiseTest, LargeCoordinateTest)
+{
+   // Lattice coordinates beyond the range of a 32-bit integer
+   std::vector<double> x = {3.0e9, -3.0e9, 1.0e12, -5.5e14, 0.5};
+   std::vector<double> y = {0.25, 7.0e9, -1.0e12, 2.5e14, -4.0e13};
+   std::vector<double> result(x.size());
+
+   NoiseGenerator noise(1618);
+   noise.Evaluate(x.data(), y.data(), x.size(), 6u, result.data());
+
+   for (size_t i = 0; i < x.size(); i++)
+   {
+      EXPECT_TRUE(std::isfinite(result[i]))
+         << "(x, y) = (" << x[i] << ", " << y[i] << ")";
+      EXPECT_LE(std::abs(result[i]), 1.0)
+         << "(x, y) = (" << x[i] << ", " << y[i] << ")";
+   }
+}
+
+} // namespace WorldEngine
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <parallel.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace WorldEngine
+{
+
+TEST(ParallelTest, ParallelForTest)
+{
+   SetNumThreads(4u);
+
+   std::vector<uint32_t> visits(1000u, 0u);
+
+   ParallelFor(10u, 1000u, [&](uint32_t i) { visits[i]++; });
+
+   for (uint32_t i = 0; i < visits.size(); i++)
+   {
+      EXPECT_EQ(visits[i], (i < 10u) ? 0u : 1u) << "i = " << i;
+   }
+
+   SetNumThreads(0u);
+}
+
+TEST(ParallelTest, NestedTest)
+{
+   SetNumThreads(4u);
+
+   std::vector<std::atomic<uint32_t>> visits(64u * 64u);
+
+   // Nested calls run inline on the thread processing the outer index
+   ParallelFor(0u,
+               64u,
+               [&](uint32_t y)
+               {
+                  const std::thread::id outer = std::this_thread::get_id();
+
+                  ParallelFor(0u,
+                              64u,
+                              [&](uint32_t x)
+                              {
+                                 EXPECT_EQ(std::this_thread::get_id(), outer);
+                                 visits[y * 64u + x]++;
+                              });
+               });
+
+   for (const std::atomic<uint32_t>& v : visits)
+   {
+      EXPECT_EQ(v, 1u);
+   }
+
+   SetNumThreads(0u);
+}
+
+TEST(ParallelTest, ConcurrentTest)
+{
+   SetNumThreads(4u);
+
+   const uint32_t numCallers = 6u;
+
+   std::vector<std::vector<uint32_t>> visits(
+      numCallers, std::vector<uint32_t>(5000u, 0u));
+   std::vector<std::thread> callers;
+
+   // Calls from several threads share the pool
+   for (uint32_t c = 0; c < numCallers; c++)
+   {
+      callers.emplace_back(
+         [&, c]()
+         {
+            for (uint32_t repeat = 0; repeat < 20u; repeat++)
+            {
+               ParallelFor(
+                  0u, 5000u, [&, c](uint32_t i) { visits[c][i]++; });
+            }
+         });
+   }
+
+   for (std::thread& t : callers)
+   {
+      t.join();
+   }
+
+   for (uint32_t c = 0; c < numCallers; c++)
+   {
+      for (uint32_t i = 0; i < 5000u; i++)
+      {
+         EXPECT_EQ(visits[c][i], 20u) << "c = " << c << ", i = " << i;
+      }
+   }
+
+   SetNumThreads(0u);
+}
+
+TEST(ParallelTest, ExceptionTest)
+{
+   SetNumThreads(4u);
+
+   EXPECT_THROW(ParallelFor(0u,
+                            1000u,
+                            [](uint32_t i)
+                            {
+                               if (i == 500u)
+                               {
+                                  throw std::runtime_error("ParallelFor");
+                               }
+                            }),
+                std::runtime_error);
+
+   // The pool remains usable
+   std::atomic<uint32_t> count(0u);
+   ParallelFor(0u, 1000u, [&](uint32_t) { count++; });
+   EXPECT_EQ(count, 1000u);
+
+   SetNumThreads(0u);
+}
+
+} // namespace WorldEngine
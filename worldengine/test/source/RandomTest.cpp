@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <random.h>
+
+namespace WorldEngine
+{
+
+TEST(RandomTest, KnownAnswerTest)
+{
+   typedef CounterRandom::CounterType C;
+
+   // Philox4x32-10 known answers from the reference implementation
+   CounterRandom zero(0x00000000u, 0x00000000u);
+   CounterRandom ones(0xffffffffu, 0xffffffffu);
+   CounterRandom pi(0xa4093822u, 0x299f31d0u);
+
+   const C zeroCounter({0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u});
+   const C onesCounter({0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu});
+   const C piCounter({0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u});
+
+   EXPECT_EQ(zero.Generate(zeroCounter),
+             C({0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u}));
+   EXPECT_EQ(ones.Generate(onesCounter),
+             C({0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu}));
+   EXPECT_EQ(pi.Generate(piCounter),
+             C({0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u}));
+}
+
+TEST(RandomTest, DistributionTest)
+{
+   const uint32_t numValues = 10000u;
+   const uint32_t range     = 7u;
+
+   CounterRandom random(1618u, 3u);
+   CounterRandom other(1618u, 4u);
+
+   uint32_t counts[range] = {};
+   uint32_t equal         = 0u;
+   double   sum           = 0.0;
+
+   for (uint32_t i = 0; i < numValues; i++)
+   {
+      float u = random.Uniform(i, 5u);
+      EXPECT_GE(u, 0.0f);
+      EXPECT_LT(u, 1.0f);
+      sum += u;
+
+      uint32_t b = random.Below(range, i, 5u, 1u);
+      ASSERT_LT(b, range);
+      counts[b]++;
+
+      // Values depend only on the key and counter
+      EXPECT_EQ(random(i, 5u), random(i, 5u));
+
+      if (random(i, 5u) == other(i, 5u))
+      {
+         equal++;
+      }
+   }
+
+   EXPECT_NEAR(sum / numValues, 0.5, 0.02);
+   for (uint32_t count : counts)
+   {
+      EXPECT_NEAR(count, numValues / range, numValues / range / 10u);
+   }
+
+   // Streams of the same seed are independent
+   EXPECT_LE(equal, 1u);
+}
+
+} // namespace WorldEngine
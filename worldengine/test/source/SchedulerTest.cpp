@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <scheduler.h>
+
+#include <atomic>
+#include <stdexcept>
+
+namespace WorldEngine
+{
+
+TEST(SchedulerTest, DependenciesTest)
+{
+   SimulationScheduler scheduler;
+
+   auto Nothing = []() {};
+
+   scheduler.Add(Simulation::Temperature,
+                 {Layer::Elevation, Layer::Ocean},
+                 {Layer::Temperature},
+                 Nothing);
+   scheduler.Add(Simulation::Precipitation,
+                 {Layer::Ocean, Layer::Temperature},
+                 {Layer::Precipitation},
+                 Nothing);
+   scheduler.Add(Simulation::Erosion,
+                 {Layer::Elevation, Layer::Ocean, Layer::Precipitation},
+                 {Layer::Elevation, Layer::RiverMap, Layer::LakeMap},
+                 Nothing);
+   scheduler.Add(
+      Simulation::Permeability, {Layer::Ocean}, {Layer::Permeability}, Nothing);
+
+   EXPECT_EQ(scheduler.Dependencies(0), std::vector<size_t>());
+   EXPECT_EQ(scheduler.Dependencies(1), std::vector<size_t>({0}));
+   EXPECT_EQ(scheduler.Dependencies(2), std::vector<size_t>({0, 1}));
+   EXPECT_EQ(scheduler.Dependencies(3), std::vector<size_t>());
+}
+
+TEST(SchedulerTest, ExecuteOrderTest)
+{
+   SimulationScheduler scheduler(4u);
+
+   std::atomic<uint32_t> counter(0u);
+   uint32_t              order[4];
+
+   auto Record = [&](size_t i) { return [&, i]() { order[i] = counter++; }; };
+
+   scheduler.Add(Simulation::Temperature, {}, {Layer::Temperature}, Record(0));
+   scheduler.Add(
+      Simulation::Permeability, {}, {Layer::Permeability}, Record(1));
+   scheduler.Add(Simulation::Precipitation,
+                 {Layer::Temperature},
+                 {Layer::Precipitation},
+                 Record(2));
+   scheduler.Add(Simulation::Humidity,
+                 {Layer::Precipitation, Layer::Permeability},
+                 {Layer::Humidity},
+                 Record(3));
+
+   scheduler.Execute();
+
+   EXPECT_EQ(counter, 4u);
+   EXPECT_LT(order[0], order[2]);
+   EXPECT_LT(order[2], order[3]);
+   EXPECT_LT(order[1], order[3]);
+}
+
+TEST(SchedulerTest, ExceptionTest)
+{
+   SimulationScheduler scheduler(2u);
+
+   bool dependentRan = false;
+
+   scheduler.Add(Simulation::Temperature,
+                 {},
+                 {Layer::Temperature},
+                 []() { throw std::runtime_error("Temperature"); });
+   scheduler.Add(Simulation::Precipitation,
+                 {Layer::Temperature},
+                 {Layer::Precipitation},
+                 [&]() { dependentRan = true; });
+
+   EXPECT_THROW(scheduler.Execute(), std::runtime_error);
+   EXPECT_FALSE(dependentRan);
+}
+
+} // namespace WorldEngine
@@ -1,11 +1,98 @@
 #include <gtest/gtest.h>
 
 #include <worldengine/world.h>
+#include <simulations/erosion.h>
 #include <simulations/hydrology.h>
+#include <simulations/irrigation.h>
 
 namespace WorldEngine
 {
 
+TEST(SimulationTest, ErosionPriorityFloodTest)
+{
+   const Size size(10, 7);
+
+   // Valley along the middle row, draining to the ocean on the left through a
+   // pit at x = 3
+   static const float valley[10] = {
+      0.0f, 0.2f, 0.3f, 0.1f, 0.5f, 0.6f, 0.7f, 0.8f, 0.9f, 2.0f};
+
+   std::shared_ptr<World> w = std::make_shared<World>(
+      "Erosion", size, 0, GenerationParameters(0, 1.0f, StepType::Full));
+
+   ElevationArrayType&     elevation     = w->GetElevationData();
+   OceanArrayType&         ocean         = w->GetOceanData();
+   PrecipitationArrayType& precipitation = w->GetPrecipitationData();
+   elevation.resize(boost::extents[size.height_][size.width_]);
+   ocean.resize(boost::extents[size.height_][size.width_]);
+   precipitation.resize(boost::extents[size.height_][size.width_]);
+
+   for (uint32_t y = 0; y < size.height_; y++)
+   {
+      for (uint32_t x = 0; x < size.width_; x++)
+      {
+         elevation[y][x]     = (y == 3 || x == 0) ? valley[x] : 2.0f;
+         ocean[y][x]         = (x == 0);
+         precipitation[y][x] = (y == 3) ? 1.0f : 0.0f;
+      }
+   }
+
+   // The head of the valley is the only river source
+   w->SetThreshold(ElevationThreshold::Mountain, 0.85f);
+
+   ErosionSimulation(*w, nullptr, ErosionMode::PriorityFlood);
+
+   // The river flows through the pit to the ocean, leaving a lake in the pit
+   const RiverMapArrayType& riverMap = w->GetRiverMapData();
+   const LakeMapArrayType&  lakeMap  = w->GetLakeMapData();
+   for (uint32_t x = 1; x < size.width_ - 1; x++)
+   {
+      EXPECT_GT(riverMap[3][x], 0.0f) << "x = " << x;
+      EXPECT_EQ(lakeMap[3][x], (x == 3) ? 0.1f : 0.0f) << "x = " << x;
+   }
+}
+
+TEST(SimulationTest, IrrigationTest)
+{
+   const Size    size(5, 4);
+   const int32_t radius = 1;
+
+   std::shared_ptr<World> w = std::make_shared<World>(
+      "Irrigation", size, 0, GenerationParameters(0, 1.0f, StepType::Full));
+
+   OceanArrayType&    ocean    = w->GetOceanData();
+   WaterMapArrayType& watermap = w->GetWaterMapData();
+   ocean.resize(boost::extents[size.height_][size.width_]);
+   watermap.resize(boost::extents[size.height_][size.width_]);
+
+   std::fill(ocean.data(), ocean.data() + ocean.num_elements(), false);
+   std::fill(watermap.data(), watermap.data() + watermap.num_elements(), 1.0f);
+
+   // Single ocean cell at (1, 1)
+   ocean[1][1] = true;
+
+   IrrigationSimulation(*w, radius);
+
+   const IrrigationArrayType& irrigation = w->GetIrrigationData();
+   for (int32_t y = 0; y < static_cast<int32_t>(size.height_); y++)
+   {
+      for (int32_t x = 0; x < static_cast<int32_t>(size.width_); x++)
+      {
+         float dx       = static_cast<float>(x - 1);
+         float dy       = static_cast<float>(y - 1);
+         float expected = 0.0f;
+
+         if (std::abs(dx) <= radius && std::abs(dy) <= radius)
+         {
+            expected = 1.0f / (log1pf(sqrtf(dx * dx + dy * dy)) + 1);
+         }
+
+         EXPECT_EQ(irrigation[y][x], expected)
+            << "(x, y) = (" << x << ", " << y << ")";
+      }
+   }
+}
+
 TEST(SimulationTest, RandomLandTest)
 {
    const Size size(100, 90);
@@ -51,4 +138,125 @@ TEST(SimulationTest, WatermapNoLandTest)
    EXPECT_EQ(w->GetWaterMapData().num_elements(), size.width_ * size.height_);
 }
 
+TEST(SimulationTest, WatermapDeepDropletTest)
+{
+   // A single slope, long enough that a droplet following it recursively
+   // would exhaust the call stack
+   const Size     size(200000, 1);
+   const uint32_t numSources = 256u;
+
+   std::shared_ptr<World> w = std::make_shared<World>(
+      "Watermap", size, 0, GenerationParameters(0, 1.0f, StepType::Full));
+
+   ElevationArrayType&     elevation     = w->GetElevationData();
+   OceanArrayType&         ocean         = w->GetOceanData();
+   PrecipitationArrayType& precipitation = w->GetPrecipitationData();
+   elevation.resize(boost::extents[size.height_][size.width_]);
+   ocean.resize(boost::extents[size.height_][size.width_]);
+   precipitation.resize(boost::extents[size.height_][size.width_]);
+
+   // Slope down to the ocean on the right, with rainfall only at the top. The
+   // slope is steeper than the water deposited on it, so each droplet flows
+   // the length of the slope.
+   for (uint32_t x = 0; x < size.width_; x++)
+   {
+      elevation[0][x]     = static_cast<float>(size.width_ - x) * 4.0f;
+      ocean[0][x]         = (x == size.width_ - 1);
+      precipitation[0][x] = (x < numSources) ? 0.1f : 0.0f;
+   }
+
+   for (RandomMode randomMode :
+        {RandomMode::Sequential, RandomMode::CounterBased})
+   {
+      WatermapSimulation(*w, 3, WatermapMode::Droplets, randomMode);
+
+      // Water reaches the bottom of the slope
+      const WaterMapArrayType& watermap = w->GetWaterMapData();
+      EXPECT_GT(watermap[0][size.width_ - 2], 0.0f)
+         << "randomMode = " << static_cast<int>(randomMode);
+      EXPECT_EQ(watermap[0][size.width_ - 1], 0.0f)
+         << "randomMode = " << static_cast<int>(randomMode);
+   }
+}
+
+TEST(SimulationTest, WatermapAccumulationTest)
+{
+   const Size size(8, 1);
+
+   std::shared_ptr<World> w = std::make_shared<World>(
+      "Watermap", size, 0, GenerationParameters(0, 1.0f, StepType::Full));
+
+   ElevationArrayType&     elevation     = w->GetElevationData();
+   OceanArrayType&         ocean         = w->GetOceanData();
+   PrecipitationArrayType& precipitation = w->GetPrecipitationData();
+   elevation.resize(boost::extents[size.height_][size.width_]);
+   ocean.resize(boost::extents[size.height_][size.width_]);
+   precipitation.resize(boost::extents[size.height_][size.width_]);
+
+   // Slope down to the ocean on the right
+   for (uint32_t x = 0; x < size.width_; x++)
+   {
+      elevation[0][x]     = static_cast<float>(size.width_ - x);
+      ocean[0][x]         = (x == size.width_ - 1);
+      precipitation[0][x] = 1.0f;
+   }
+
+   for (WatermapMode mode :
+        {WatermapMode::Accumulation, WatermapMode::AccumulationD8})
+   {
+      WatermapSimulation(*w, 0, mode);
+
+      // Each land cell receives the rainfall of every cell uphill
+      const WaterMapArrayType& watermap = w->GetWaterMapData();
+      for (uint32_t x = 0; x < size.width_ - 1; x++)
+      {
+         EXPECT_EQ(watermap[0][x], static_cast<float>(x)) << "x = " << x;
+      }
+      EXPECT_EQ(watermap[0][size.width_ - 1], 0.0f);
+   }
+}
+
+TEST(SimulationTest, WatermapAccumulationD8Test)
+{
+   const Size size(3, 3);
+
+   std::shared_ptr<World> w = std::make_shared<World>(
+      "Watermap", size, 0, GenerationParameters(0, 1.0f, StepType::Full));
+
+   ElevationArrayType&     elevation     = w->GetElevationData();
+   OceanArrayType&         ocean         = w->GetOceanData();
+   PrecipitationArrayType& precipitation = w->GetPrecipitationData();
+   elevation.resize(boost::extents[size.height_][size.width_]);
+   ocean.resize(boost::extents[size.height_][size.width_]);
+   precipitation.resize(boost::extents[size.height_][size.width_]);
+
+   // Peak in the center, sloping down towards the lowest corner
+   static const float peak[3][3] = {
+      {3.0f, 4.0f, 5.0f}, {4.0f, 9.0f, 6.0f}, {5.0f, 6.0f, 7.0f}};
+
+   for (uint32_t y = 0; y < size.height_; y++)
+   {
+      for (uint32_t x = 0; x < size.width_; x++)
+      {
+         elevation[y][x]     = peak[y][x];
+         ocean[y][x]         = false;
+         precipitation[y][x] = (x == 1 && y == 1) ? 1.0f : 0.0f;
+      }
+   }
+
+   WatermapSimulation(*w, 0, WatermapMode::AccumulationD8);
+
+   // All rainfall from the peak flows to its lowest neighbor, the corner. The
+   // corner has no lower neighbors, and also collects the water flowing out.
+   const WaterMapArrayType& watermap = w->GetWaterMapData();
+   for (uint32_t y = 0; y < size.height_; y++)
+   {
+      for (uint32_t x = 0; x < size.width_; x++)
+      {
+         EXPECT_EQ(watermap[y][x], (x == 0 && y == 0) ? 2.0f : 0.0f)
+            << "(x, y) = (" << x << ", " << y << ")";
+      }
+   }
+}
+
 } // namespace WorldEngine